@@ -0,0 +1,143 @@
+#include "cxxopts.h"
+#include "core/core.h"
+#include "core/Archive.h"
+
+#include <filesystem>
+#include <fstream>
+#include <set>
+
+using namespace tim::core;
+using namespace tim;
+
+/* Pack the files of a directory in a .tpk (see core/Archive.h), with their path relative to the directory.
+ * At runtime FileSystem::mount("Data.tpk") from the directory makes the loaders read in the archive.
+ * The .tim are never compressed so they stay mapped in place. */
+
+namespace
+{
+    std::set<std::string> parseExtensions(const std::string& list)
+    {
+        std::set<std::string> res;
+        std::string ext;
+        for(size_t i=0 ; i<=list.size() ; ++i)
+        {
+            if(i == list.size() || list[i] == ',')
+            {
+                if(!ext.empty()) res.insert("." + ext);
+                ext.clear();
+            }
+            else if(list[i] != '.' && list[i] != ' ')
+                ext += char(tolower(static_cast<unsigned char>(list[i])));
+        }
+        return res;
+    }
+
+    /* Read back every entry of the written archive */
+    bool verify(const std::string& archiveFile, const vector<std::filesystem::path>& files, const std::filesystem::path& dir)
+    {
+        Archive archive(archiveFile);
+        if(!archive.isOpen() || archive.size() != files.size())
+            return false;
+
+        for(const auto& f : files)
+        {
+            FileData packed = archive.find(FileSystem::normalize(std::filesystem::relative(f, dir).generic_string()));
+            std::ifstream in(f, std::ios_base::binary);
+            std::string original((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+            if(!packed.isOpen() || packed.size != original.size() || memcmp(packed.data, original.data(), original.size()) != 0)
+            {
+                std::cerr << "Mismatch on " << f.generic_string() << std::endl;
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    cxxopts::Options optionsBase("TIMEngine2_AssetPacker", "Pack a directory of assets in a single archive with an indexed directory");
+    optionsBase.positional_help("directory");
+    optionsBase.add_options()
+        ("dir", "Directory packed recursively", cxxopts::value<std::string>()->default_value("."))
+        ("o,output", "Archive file", cxxopts::value<std::string>()->default_value("Data.tpk"))
+        ("compress", "Extensions stored compressed", cxxopts::value<std::string>()->default_value("obj,xml,txt,ini,glsl,vert,frag,geom,cs,dat"))
+        ("exclude", "Extensions not packed", cxxopts::value<std::string>()->default_value("tpk"))
+        ("verify", "Read back the archive once written", cxxopts::value<bool>()->implicit_value("true")->default_value("false"))
+        ("h,help", "Print usage");
+    optionsBase.parse_positional({"dir"});
+
+    auto args = optionsBase.parse(argc, argv);
+    if(args.count("help"))
+    {
+        std::cout << optionsBase.help() << std::endl;
+        return 0;
+    }
+
+    const std::filesystem::path dir = args["dir"].as<std::string>();
+    const std::string output = args["output"].as<std::string>();
+    const std::set<std::string> compressed = parseExtensions(args["compress"].as<std::string>());
+    const std::set<std::string> excluded = parseExtensions(args["exclude"].as<std::string>());
+
+    tim::core::init();
+
+    vector<std::filesystem::path> files;
+    std::error_code ec;
+    for(const auto& f : std::filesystem::recursive_directory_iterator(dir, ec))
+    {
+        std::string ext = f.path().extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return char(tolower(c)); });
+        if(f.is_regular_file() && excluded.count(ext) == 0)
+            files.push_back(f.path());
+    }
+    std::sort(files.begin(), files.end());
+
+    if(ec)
+    {
+        std::cerr << "Can't read " << dir.generic_string() << ": " << ec.message() << std::endl;
+        tim::core::quit();
+        return 2;
+    }
+
+    ArchiveBuilder builder;
+    bool error = false;
+    for(const auto& f : files)
+    {
+        std::ifstream in(f, std::ios_base::binary);
+        if(!in)
+        {
+            std::cerr << "Can't read " << f.generic_string() << std::endl;
+            error = true;
+            continue;
+        }
+        std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+        std::string ext = f.extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return char(tolower(c)); });
+
+        const std::string name = std::filesystem::relative(f, dir).generic_string();
+        error = !builder.add(name, content.data(), content.size(), ext != ".tim" && compressed.count(ext) > 0) || error;
+    }
+
+    if(error || !builder.write(output))
+    {
+        std::cerr << "Failed to write " << output << std::endl;
+        tim::core::quit();
+        return 1;
+    }
+
+    const ArchiveBuilder::Stats& s = builder.stats();
+    std::cout << output << ": " << s.nbFiles << " files (" << s.nbCompressed << " compressed), "
+              << s.rawBytes << " bytes stored in " << s.storedBytes << std::endl;
+
+    if(args["verify"].as<bool>() && !verify(output, files, dir))
+    {
+        std::cerr << "Verification of " << output << " failed" << std::endl;
+        tim::core::quit();
+        return 1;
+    }
+
+    tim::core::quit();
+    return 0;
+}
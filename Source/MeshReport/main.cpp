@@ -0,0 +1,204 @@
+#include "cxxopts.h"
+#include "core/core.h"
+#include "resource/MeshLoader.h"
+#include "resource/MeshAnalysis.h"
+
+#include <filesystem>
+#include <fstream>
+
+using namespace tim::core;
+using namespace tim::resource;
+using namespace tim;
+
+/* Report of the meshes (.tim and .obj) of a directory as json or csv.
+ * With thresholds, the meshes above them are listed as failures and the exit code is 1 (2 if a mesh can't be loaded),
+ * so an asset pipeline can reject a regression. */
+
+namespace
+{
+    struct Limits
+    {
+        float maxAcmr, maxOverdraw, maxOverfetch, maxSphereRatio;
+        bool requireBounds;
+    };
+
+    struct Entry
+    {
+        std::string file;
+        bool loaded = false;
+        MeshAnalysis analysis;
+        vector<std::string> failures;
+    };
+
+    std::string jsonString(const std::string& str)
+    {
+        std::string res = "\"";
+        for(char c : str)
+        {
+            if(c == '"' || c == '\\') res += '\\';
+            res += c;
+        }
+        return res + "\"";
+    }
+
+    /* Quoted if needed (RFC 4180), the quotes inside are doubled */
+    std::string csvString(const std::string& str)
+    {
+        if(str.find_first_of(",\"\r\n") == std::string::npos)
+            return str;
+
+        std::string res = "\"";
+        for(char c : str)
+        {
+            if(c == '"') res += '"';
+            res += c;
+        }
+        return res + "\"";
+    }
+
+    vector<std::string> check(const MeshAnalysis& a, const Limits& limits)
+    {
+        vector<std::string> failures;
+        auto above = [&](const char* name, uint lod, float value, float limit)
+        {
+            if(limit > 0 && value > limit)
+                failures.push_back(std::string(name) + " of lod " + std::to_string(lod) + " is " + std::to_string(value) + " > " + std::to_string(limit));
+        };
+
+        for(uint i=0 ; i<a.lods.size() ; ++i)
+        {
+            above("acmr", i, a.lods[i].acmr, limits.maxAcmr);
+            above("overdraw", i, a.lods[i].overdraw, limits.maxOverdraw);
+            above("overfetch", i, a.lods[i].overfetch, limits.maxOverfetch);
+        }
+
+        if(limits.maxSphereRatio > 0 && a.sphereToBoxRatio > limits.maxSphereRatio)
+            failures.push_back("sphereToBoxRatio is " + std::to_string(a.sphereToBoxRatio) + " > " + std::to_string(limits.maxSphereRatio));
+        if(!a.containsAll)
+            failures.push_back("the bounding sphere doesn't contain all the vertices");
+        if(limits.requireBounds && !a.storedBounds)
+            failures.push_back("no pre-computed bounds");
+        return failures;
+    }
+
+    void writeJson(std::ostream& os, const vector<Entry>& entries)
+    {
+        os << "{\n  \"meshes\": [";
+        for(size_t i=0 ; i<entries.size() ; ++i)
+        {
+            const Entry& e = entries[i];
+            const MeshAnalysis& a = e.analysis;
+            os << (i ? ",\n" : "\n") << "    {\"file\": " << jsonString(e.file) << ", \"loaded\": " << (e.loaded ? "true" : "false");
+            if(e.loaded)
+            {
+                os << ", \"vertices\": " << a.nbVertex << ", \"lods\": [";
+                for(size_t l=0 ; l<a.lods.size() ; ++l)
+                {
+                    os << (l ? ", " : "") << "{\"triangles\": " << a.lods[l].nbTriangle << ", \"acmr\": " << a.lods[l].acmr << ", \"atvr\": " << a.lods[l].atvr
+                       << ", \"overdraw\": " << a.lods[l].overdraw << ", \"overfetch\": " << a.lods[l].overfetch << "}";
+                }
+                os << "], \"bounds\": {\"stored\": " << (a.storedBounds ? "true" : "false") << ", \"radius\": " << a.sphere.radius()
+                   << ", \"sphereToBoxRatio\": " << a.sphereToBoxRatio << ", \"containsAll\": " << (a.containsAll ? "true" : "false") << "}";
+            }
+
+            os << ", \"failures\": [";
+            for(size_t f=0 ; f<e.failures.size() ; ++f)
+                os << (f ? ", " : "") << jsonString(e.failures[f]);
+            os << "]}";
+        }
+        os << "\n  ]\n}\n";
+    }
+
+    /* One line per lod */
+    void writeCsv(std::ostream& os, const vector<Entry>& entries)
+    {
+        os << "file,lod,vertices,triangles,acmr,atvr,overdraw,overfetch,storedBounds,sphereToBoxRatio,containsAll,failures\n";
+        for(const Entry& e : entries)
+        {
+            const MeshAnalysis& a = e.analysis;
+            for(size_t l=0 ; l<std::max<size_t>(a.lods.size(), 1) ; ++l)
+            {
+                os << csvString(e.file) << ',';
+                if(l < a.lods.size())
+                {
+                    os << l << ',' << a.nbVertex << ',' << a.lods[l].nbTriangle << ',' << a.lods[l].acmr << ',' << a.lods[l].atvr << ','
+                       << a.lods[l].overdraw << ',' << a.lods[l].overfetch << ',' << a.storedBounds << ',' << a.sphereToBoxRatio << ',' << a.containsAll;
+                }
+                else os << ",,,,,,,,,";
+                os << ',' << (e.loaded ? e.failures.size() : 1) << '\n';
+            }
+        }
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    cxxopts::Options optionsBase("TIMEngine2_MeshReport", "Cache, overdraw, fetch and bounds report of the meshes of a directory");
+    optionsBase.positional_help("directory");
+    optionsBase.add_options()
+        ("dir", "Directory searched recursively for .tim and .obj", cxxopts::value<std::string>()->default_value("."))
+        ("format", "json or csv", cxxopts::value<std::string>()->default_value("json"))
+        ("o,output", "Output file, stdout if empty", cxxopts::value<std::string>()->default_value(""))
+        ("maxAcmr", "Fail above this acmr (0 disables)", cxxopts::value<float>()->default_value("0"))
+        ("maxOverdraw", "Fail above this overdraw (0 disables)", cxxopts::value<float>()->default_value("0"))
+        ("maxOverfetch", "Fail above this overfetch (0 disables)", cxxopts::value<float>()->default_value("0"))
+        ("maxSphereRatio", "Fail above this bounding sphere to box radius ratio (0 disables)", cxxopts::value<float>()->default_value("0"))
+        ("requireBounds", "Fail if the bounds aren't stored in the file", cxxopts::value<bool>()->implicit_value("true")->default_value("false"))
+        ("h,help", "Print usage");
+    optionsBase.parse_positional({"dir"});
+
+    auto args = optionsBase.parse(argc, argv);
+    if(args.count("help"))
+    {
+        std::cout << optionsBase.help() << std::endl;
+        return 0;
+    }
+
+    const Limits limits = { args["maxAcmr"].as<float>(), args["maxOverdraw"].as<float>(), args["maxOverfetch"].as<float>(),
+                            args["maxSphereRatio"].as<float>(), args["requireBounds"].as<bool>() };
+
+    tim::core::init();
+
+    vector<Entry> entries;
+    std::error_code ec;
+    for(const auto& f : std::filesystem::recursive_directory_iterator(args["dir"].as<std::string>(), ec))
+    {
+        const std::string ext = f.path().extension().string();
+        if(f.is_regular_file() && (ext == ".tim" || ext == ".obj"))
+        {
+            entries.emplace_back();
+            entries.back().file = f.path().generic_string();
+        }
+    }
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.file < b.file; });
+
+    bool loadError = false, failed = false;
+    for(Entry& e : entries)
+    {
+        renderer::MeshData data = StringUtils(e.file).extension() == "obj" ? MeshLoader::importObj(e.file) : MeshLoader::importTim(e.file);
+
+        e.loaded = data.nbVertex > 0 && data.nbIndex > 0;
+        if(e.loaded)
+        {
+            e.analysis = analyzeMesh(data);
+            e.failures = check(e.analysis, limits);
+        }
+        else e.failures.push_back("can't be loaded");
+
+        loadError = loadError || !e.loaded;
+        failed = failed || !e.failures.empty();
+        data.clear();
+    }
+
+    std::ofstream file;
+    const std::string output = args["output"].as<std::string>();
+    if(!output.empty())
+        file.open(output);
+    std::ostream& os = output.empty() ? std::cout : file;
+
+    if(args["format"].as<std::string>() == "csv") writeCsv(os, entries);
+    else                                          writeJson(os, entries);
+
+    tim::core::quit();
+    return loadError ? 2 : (failed ? 1 : 0);
+}
@@ -7,6 +7,8 @@
 #include "OpenVR/OpenVR_Device.h"
 #include "OpenVR/SoftVR_Device.h"
 #include "resource/AssetManager.h"
+#include "core/FileSystem.h"
+#include <fstream>
 
 #include "MultiPromise.h"
 
@@ -61,6 +63,11 @@ int main(int argc, char* argv[])
     indexLevel = std::min(std::max(1, indexLevel), 5);
 
 	tim::core::init();
+
+    // assets packed by AssetPacker, searched before the loose files
+    if(std::ifstream("Data.tpk"))
+        FileSystem::mount("Data.tpk");
+
 	{
 		initContextSDL(WIN_RES.x(), WIN_RES.y());
 		tim::renderer::init();
@@ -286,6 +293,7 @@ int main(int argc, char* argv[])
                 pipeline.pipeline()->render();
                 swapBuffer();
                 pVRDevice->sync();
+                tim::core::AllocCounter::nextFrame();
                 GL_ASSERT();
 
                 if(input.keyState(SDLK_p).firstPress)
@@ -310,6 +318,7 @@ int main(int argc, char* argv[])
 			/** Close context **/
 			threadPool.wait();
 
+            interface::GeometryCache::printReport();
             AssetManager<Geometry>::freeInstance();
             AssetManager<interface::Texture>::freeInstance();
             ShaderPool::freeInstance();
@@ -2,6 +2,7 @@
 #include "interface/ResourceManager.h"
 #include "ImageAlgorithm.h"
 #include "resource/Image.h"
+#include "renderer/renderer.h"
 
 #include "Rand.h"
 
@@ -38,7 +39,7 @@ TerrainRenderer::TerrainRenderer(float pSize, float zScale, interface::SimpleSce
 
     delete[] data;
 
-    _patch->setHeightData(f_img.blur<13>()/*.transformed(imat2::FLIP_Y())*/);
+    _patch->setHeightData(f_img.blur<13>(&renderer::globalThreadPool)/*.transformed(imat2::FLIP_Y())*/);
     _patch->generateHeightmap();
 }
 
@@ -46,7 +47,7 @@ void TerrainRenderer::Patch::setHeightData(const ImageAlgorithm<vec3>& img)
 {
     _gpuHeightData = img;
     uivec2 newSize(std::min(img.size().x(),256u), std::min(img.size().y(),256u));
-    _heightData = _gpuHeightData.resized(newSize);
+    _heightData = _gpuHeightData.resized(newSize, &renderer::globalThreadPool);
 }
 
 TerrainRenderer::Patch::Patch(interface::SimpleScene& scene, const Parameter& p, uint terrainUbo)
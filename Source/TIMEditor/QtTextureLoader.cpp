@@ -1,5 +1,6 @@
 #include "QtTextureLoader.h"
 #include <QImage>
+#include "core/FileSystem.h"
 
 #include "MemoryLoggerOn.h"
 namespace tim
@@ -7,7 +8,11 @@ namespace tim
 
 ubyte* QtTextureLoader::loadImage(const std::string& file, ImageFormat& format) const
 {
-    QImage textureImg(file.c_str());
+    FileData data = FileSystem::read(file);
+    if(!data.isOpen())
+        return nullptr;
+
+    QImage textureImg = QImage::fromData(reinterpret_cast<const uchar*>(data.data), int(data.size));
 
     if(textureImg.isNull())
         return nullptr;
@@ -226,24 +226,28 @@ void ResourceViewWidget::showContextMenu(const QPoint& pos)
     }
 }
 
-void exportToTim(QString path)
+void exportToTim(QString path, tim::resource::MeshLoader::TimCompression compression)
 {
     tim::renderer::MeshData mData = tim::resource::MeshLoader::importObj(path.toStdString());
 
     path.resize(path.size()-3);
     path += "tim";
-    tim::resource::MeshLoader::exportTim(mData, path.toStdString());
+    tim::resource::MeshLoader::exportTim(mData, path.toStdString(), 0.33f, compression);
     mData.clear();
 }
 
 void ResourceViewWidget::onGeometryRightClicked(const ItemElement& elem, const QPoint& pos)
 {
+    using Compression = tim::resource::MeshLoader::TimCompression;
+
     QMenu myMenu;
     QAction* timConvert = myMenu.addAction("Convert to tim");
+    QAction* timConvertLossless = myMenu.addAction("Convert to tim (compressed)");
+    QAction* timConvertFiltered = myMenu.addAction("Convert to tim (compressed, quantized normals and uvs)");
 
     QString newPath;
     QAction* ret = myMenu.exec(pos);
-    if(ret == timConvert)
+    if(ret == timConvert || ret == timConvertLossless || ret == timConvertFiltered)
     {
         newPath = elem.elem.path;
         if(newPath.size() < 3)
@@ -251,7 +255,8 @@ void ResourceViewWidget::onGeometryRightClicked(const ItemElement& elem, const Q
         else if(StringUtils(newPath.toStdString()).extension() != "obj")
             return;
 
-        exportToTim(newPath);
+        exportToTim(newPath, ret == timConvertLossless ? Compression::LOSSLESS :
+                             ret == timConvertFiltered ? Compression::FILTERED : Compression::NONE);
         newPath.resize(newPath.size()-3);
         addElement({newPath+"tim", Element::Geometry});
     }
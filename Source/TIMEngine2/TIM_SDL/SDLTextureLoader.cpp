@@ -4,6 +4,7 @@
 
 #include "core/Matrix.h"
 #include "resource/Image.h"
+#include "core/FileSystem.h"
 
 #include "MemoryLoggerOn.h"
 namespace tim
@@ -11,7 +12,12 @@ namespace tim
 
 ubyte* SDLTextureLoader::loadImage(const std::string& file, ImageFormat& format) const
 {
-    SDL_Surface* img = IMG_Load(file.c_str());
+    // decoded from memory, the file can be in a mounted archive
+    FileData data = FileSystem::read(file);
+    if(!data.isOpen())
+        return nullptr;
+
+    SDL_Surface* img = IMG_Load_RW(SDL_RWFromConstMem(data.data, int(data.size)), 1);
     if(!img)
         return nullptr;
 
@@ -1,5 +1,7 @@
 #include "bullet/GeometryShape.h"
 #include "bullet/BulletEngine.h"
+#include "core/BatchTransform.h"
+#include "renderer/renderer.h"
 
 namespace tim
 {
@@ -36,8 +38,9 @@ btBvhTriangleMeshShape* GeometryShape::genStaticGeometryShape(const vector<MeshI
             //renderer::MeshData::DataType* data = meshData->vData;
             //uint formatSize = renderer::vertexFormatSize(renderer::MeshData::DATA_ID);
 
-            for(size_t j=0 ; j<meshData->nbVertex ; ++j)
-                *(iterator_vdata++) = geometry[i].mat * meshData->vData[j].v;
+            transformPoints(geometry[i].mat, &meshData->vData[0].v.x(), sizeof(renderer::MeshData::DataType) / sizeof(float),
+                            &iterator_vdata->x(), 3, meshData->nbVertex, &renderer::globalThreadPool);
+            iterator_vdata += meshData->nbVertex;
 
             for(size_t j=0 ; j<meshData->nbIndex ; ++j)
                 *(iterator_idata++) = meshData->indexData[j]+indexOffset;
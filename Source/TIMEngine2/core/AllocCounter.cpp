@@ -0,0 +1,260 @@
+#include "AllocCounter.h"
+#include "Logger.h"
+#include "SpinLock.h"
+
+#include <cstdlib>
+#include <new>
+#include <algorithm>
+
+#include "MemoryLoggerOn.h"
+namespace tim
+{
+namespace core
+{
+    namespace
+    {
+        /* Counters written by their thread only, linked in a global list so nextFrame() can sum them */
+        struct ThreadState
+        {
+            std::atomic<size_t> count = 0, bytes = 0;
+            AllocCounter::Scope* scope = nullptr;
+            uint noAlloc = 0;
+            bool asserting = false;
+            ThreadState* prev = nullptr;
+            ThreadState* next = nullptr;
+
+            ThreadState();
+            ~ThreadState();
+
+            AllocCounter::Stats stats() const { return { count.load(std::memory_order_relaxed), bytes.load(std::memory_order_relaxed) }; }
+        };
+
+        // a lock which never allocates, it's taken from operator new
+        SpinLock s_threadsLock;
+        ThreadState* s_threads = nullptr;
+        AllocCounter::Stats s_endedThreads;
+
+        ThreadState::ThreadState()
+        {
+            std::lock_guard<SpinLock> guard(s_threadsLock);
+            next = s_threads;
+            if(next) next->prev = this;
+            s_threads = this;
+        }
+
+        ThreadState::~ThreadState()
+        {
+            std::lock_guard<SpinLock> guard(s_threadsLock);
+            s_endedThreads += stats();
+            if(prev) prev->next = next;
+            else s_threads = next;
+            if(next) next->prev = prev;
+        }
+
+        thread_local ThreadState t_state;
+
+        AllocCounter::Stats s_frameStart;
+        AllocCounter::Stats s_lastFrame;
+    }
+
+    std::atomic<AllocCounter::Site*> AllocCounter::s_sites = nullptr;
+    std::atomic<size_t> AllocCounter::s_frame = 0;
+
+    /* Site */
+
+    AllocCounter::Site::Site(const char* name) : _name(name)
+    {
+        _next = s_sites.load(std::memory_order_relaxed);
+        while(!s_sites.compare_exchange_weak(_next, this, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    /* Scope */
+
+    AllocCounter::Scope::Scope(Site& site) : _site(site), _parent(t_state.scope), _start(t_state.stats())
+    {
+        t_state.scope = this;
+    }
+
+    AllocCounter::Scope::~Scope()
+    {
+        const Stats inclusive = t_state.stats() - _start;
+        const Stats exclusive = inclusive - _children;
+
+        _site._count.fetch_add(exclusive.count, std::memory_order_relaxed);
+        _site._bytes.fetch_add(exclusive.bytes, std::memory_order_relaxed);
+        _site._calls.fetch_add(1, std::memory_order_relaxed);
+
+        if(_parent)
+            _parent->_children += inclusive;
+        t_state.scope = _parent;
+    }
+
+    /* AllocCounter */
+
+    AllocCounter::Stats AllocCounter::thread()
+    {
+        return t_state.stats();
+    }
+
+    AllocCounter::Stats AllocCounter::allThreads()
+    {
+        std::lock_guard<SpinLock> guard(s_threadsLock);
+        Stats total = s_endedThreads;
+        for(const ThreadState* t = s_threads ; t ; t = t->next)
+            total += t->stats();
+        return total;
+    }
+
+    void AllocCounter::onAlloc(size_t size)
+    {
+        t_state.count.store(t_state.count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        t_state.bytes.store(t_state.bytes.load(std::memory_order_relaxed) + size, std::memory_order_relaxed);
+
+#ifdef TIM_DEBUG
+        if(t_state.noAlloc > 0 && !t_state.asserting)
+        {
+            t_state.asserting = true;
+            handleAssert(__LINE__, __FILE__, "Heap allocation inside a NoAllocScope.");
+            t_state.asserting = false;
+        }
+#endif
+    }
+
+    void AllocCounter::nextFrame()
+    {
+        const Stats cur = allThreads();
+        s_lastFrame = cur - s_frameStart;
+        s_frameStart = cur;
+
+        for(Site* site = s_sites.load(std::memory_order_acquire) ; site ; site = site->_next)
+        {
+            site->_lastCount = site->_count.exchange(0, std::memory_order_relaxed);
+            site->_lastBytes = site->_bytes.exchange(0, std::memory_order_relaxed);
+            site->_lastCalls = site->_calls.exchange(0, std::memory_order_relaxed);
+        }
+
+        s_frame.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    AllocCounter::Stats AllocCounter::lastFrame()
+    {
+        return s_lastFrame;
+    }
+
+    vector<AllocCounter::SiteStats> AllocCounter::lastFrameReport()
+    {
+        vector<SiteStats> report;
+        for(Site* site = s_sites.load(std::memory_order_acquire) ; site ; site = site->_next)
+        {
+            if(site->_lastCalls.load() == 0)
+                continue;
+
+            report.push_back({ site->_name, site->_lastCalls.load(), { site->_lastCount.load(), site->_lastBytes.load() } });
+        }
+
+        std::sort(report.begin(), report.end(), [](const SiteStats& a, const SiteStats& b) { return a.allocs.count > b.allocs.count; });
+        return report;
+    }
+
+    void AllocCounter::printLastFrame()
+    {
+        const Stats frameStats = lastFrame();
+        LOG("Frame ", frame(), ": ", frameStats.count, " allocations, ", frameStats.bytes, " bytes");
+
+        for(const SiteStats& s : lastFrameReport())
+            LOG("    ", s.name, " (", s.calls, " calls): ", s.allocs.count, " allocations, ", s.allocs.bytes, " bytes");
+    }
+
+    /* NoAllocScope */
+
+    NoAllocScope::NoAllocScope() { ++t_state.noAlloc; }
+    NoAllocScope::~NoAllocScope() { --t_state.noAlloc; }
+    bool NoAllocScope::active() { return t_state.noAlloc > 0; }
+}
+}
+#include "MemoryLoggerOff.h"
+
+#ifdef TIM_MEMORY_TRACKING
+
+/* Global operator new replacement, only counts then forwards to malloc */
+
+namespace
+{
+    inline void* countedAlloc(size_t size)
+    {
+        tim::core::AllocCounter::onAlloc(size);
+        return malloc(size > 0 ? size : 1);
+    }
+
+    inline void* countedAlignedAlloc(size_t size, std::align_val_t al)
+    {
+        tim::core::AllocCounter::onAlloc(size);
+        const size_t align = static_cast<size_t>(al);
+#ifdef _MSC_VER
+        return _aligned_malloc(size > 0 ? size : 1, align);
+#else
+        return aligned_alloc(align, (std::max<size_t>(size, 1) + align - 1) / align * align);
+#endif
+    }
+
+    /* In profile builds the new-expressions of the engine are tracked by the MemoryLogger (see MemoryLoggerOn.h) */
+    inline void release(void* ptr, bool isArray)
+    {
+#ifdef TIM_MEMORY_PROFILE
+        tim::core::MemoryLogger::release(ptr, isArray);
+#else
+        (void)isArray;
+        free(ptr);
+#endif
+    }
+
+    inline void alignedFree(void* ptr)
+    {
+#ifdef _MSC_VER
+        _aligned_free(ptr);
+#else
+        free(ptr);
+#endif
+    }
+}
+
+void* operator new(size_t size)
+{
+    if(void* ptr = countedAlloc(size)) return ptr;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size)
+{
+    if(void* ptr = countedAlloc(size)) return ptr;
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return countedAlloc(size); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return countedAlloc(size); }
+
+void* operator new(size_t size, std::align_val_t al)
+{
+    if(void* ptr = countedAlignedAlloc(size, al)) return ptr;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size, std::align_val_t al)
+{
+    if(void* ptr = countedAlignedAlloc(size, al)) return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept { release(ptr, false); }
+void operator delete[](void* ptr) noexcept { release(ptr, true); }
+void operator delete(void* ptr, size_t) noexcept { release(ptr, false); }
+void operator delete[](void* ptr, size_t) noexcept { release(ptr, true); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { release(ptr, false); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { release(ptr, true); }
+
+void operator delete(void* ptr, std::align_val_t) noexcept { alignedFree(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { alignedFree(ptr); }
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept { alignedFree(ptr); }
+void operator delete[](void* ptr, size_t, std::align_val_t) noexcept { alignedFree(ptr); }
+
+#endif
@@ -0,0 +1,121 @@
+#ifndef ALLOCCOUNTER_H_INCLUDED
+#define ALLOCCOUNTER_H_INCLUDED
+
+#include <atomic>
+#include <cstddef>
+#include "Common.h"
+#include "MemoryLogger.h"
+#include "type.h"
+
+#include "MemoryLoggerOn.h"
+namespace tim
+{
+namespace core
+{
+    /* Count heap allocations per thread, per frame and per scope (pipeline nodes).
+     * Counting is done by the global operator new replacement, only when TIM_MEMORY_TRACKING is defined
+     * (debug and profile builds); otherwise every counter stays at 0 and the scopes are empty. */
+    class AllocCounter
+    {
+    public:
+        struct Stats
+        {
+            size_t count = 0, bytes = 0;
+            Stats operator-(const Stats& s) const { return { count - s.count, bytes - s.bytes }; }
+            Stats& operator+=(const Stats& s) { count += s.count; bytes += s.bytes; return *this; }
+        };
+
+        /* A named scope, declared static by TIM_ALLOC_SCOPE, linked in a global list */
+        class Site
+        {
+            friend class AllocCounter;
+        public:
+            Site(const char* name);
+
+            const char* name() const { return _name; }
+
+        private:
+            const char* _name;
+            std::atomic<size_t> _count = 0, _bytes = 0, _calls = 0;
+            std::atomic<size_t> _lastCount = 0, _lastBytes = 0, _lastCalls = 0;
+            Site* _next = nullptr;
+        };
+
+        struct SiteStats
+        {
+            const char* name;
+            size_t calls;
+            Stats allocs; // exclusive of the nested scopes
+        };
+
+        /* Measure the allocations done by the current thread between construction and destruction */
+        class Scope
+        {
+        public:
+            Scope(Site&);
+            ~Scope();
+
+        private:
+            Site& _site;
+            Scope* _parent;
+            Stats _start;
+            Stats _children;
+        };
+
+        static constexpr bool enabled()
+        {
+#ifdef TIM_MEMORY_TRACKING
+            return true;
+#else
+            return false;
+#endif
+        }
+
+        /* Cumulative allocations of the calling thread */
+        static Stats thread();
+        /* Cumulative allocations of every thread, ended ones included */
+        static Stats allThreads();
+
+        /* Close the current frame: per site counters are moved to the 'last frame' report */
+        static void nextFrame();
+        static size_t frame() { return s_frame.load(std::memory_order_relaxed); }
+
+        /* Allocations of every thread (render, workers, loaders) during the last frame */
+        static Stats lastFrame();
+        static vector<SiteStats> lastFrameReport();
+        static void printLastFrame();
+
+        static void onAlloc(size_t);
+
+    private:
+        static std::atomic<Site*> s_sites;
+        static std::atomic<size_t> s_frame;
+    };
+
+    /* Assert (debug) if the current thread allocates while the scope is alive */
+    class NoAllocScope
+    {
+    public:
+        NoAllocScope();
+        ~NoAllocScope();
+
+        static bool active();
+    };
+}
+}
+#include "MemoryLoggerOff.h"
+
+#define TIM_ALLOC_CONCAT_INNER(a, b) a##b
+#define TIM_ALLOC_CONCAT(a, b) TIM_ALLOC_CONCAT_INNER(a, b)
+
+#ifdef TIM_MEMORY_TRACKING
+    #define TIM_ALLOC_SCOPE(name) \
+        static tim::core::AllocCounter::Site TIM_ALLOC_CONCAT(s_allocSite, __LINE__)(name); \
+        tim::core::AllocCounter::Scope TIM_ALLOC_CONCAT(allocScope, __LINE__)(TIM_ALLOC_CONCAT(s_allocSite, __LINE__))
+    #define TIM_NO_ALLOC_SCOPE() tim::core::NoAllocScope TIM_ALLOC_CONCAT(noAllocScope, __LINE__)
+#else
+    #define TIM_ALLOC_SCOPE(name)
+    #define TIM_NO_ALLOC_SCOPE()
+#endif
+
+#endif // ALLOCCOUNTER_H_INCLUDED
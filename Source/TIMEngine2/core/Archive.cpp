@@ -0,0 +1,250 @@
+#include "Archive.h"
+#include "Hash.h"
+#include "LzCodec.h"
+#include "Logger.h"
+#include <fstream>
+#include <cstring>
+
+#include "MemoryLoggerOn.h"
+namespace tim
+{
+namespace core
+{
+
+uint64_t Archive::hash(const std::string& normalizedPath)
+{
+    return hash64(normalizedPath.data(), normalizedPath.size());
+}
+
+bool Archive::open(const std::string& fileName)
+{
+    _file = nullptr;
+    _entries = nullptr;
+    _table = nullptr;
+    _names = nullptr;
+    _nbEntries = _tableSize = 0;
+
+    auto file = std::make_shared<MappedFile>(fileName);
+    if(!file->isOpen())
+        return false;
+
+    Header header;
+    if(file->size() < sizeof(Header))
+        return false;
+    memcpy(&header, file->data(), sizeof(Header));
+
+    if(memcmp(header.magic, "TPAK", 4) != 0 || header.version != VERSION)
+    {
+        LOG_EXT("Invalid archive ", fileName);
+        return false;
+    }
+
+    const uint64_t dirSize = uint64_t(header.nbEntries) * sizeof(Entry) + uint64_t(header.tableSize) * sizeof(uint32_t);
+    if(header.directoryOffset > file->size() || header.directorySize > file->size() - header.directoryOffset ||
+       dirSize > header.directorySize || header.directoryOffset % alignof(Entry) != 0 ||
+       header.tableSize == 0 || (header.tableSize & (header.tableSize - 1)) != 0 || header.tableSize < header.nbEntries)
+    {
+        LOG_EXT("Corrupted archive directory ", fileName);
+        return false;
+    }
+
+    const char* dir = file->data() + header.directoryOffset;
+    const Entry* entries = reinterpret_cast<const Entry*>(dir);
+    const uint64_t namesSize = header.directorySize - dirSize;
+
+    for(uint i=0 ; i<header.nbEntries ; ++i)
+    {
+        const Entry& e = entries[i];
+        if(e.offset > header.directoryOffset || e.size > header.directoryOffset - e.offset ||
+           uint64_t(e.nameOffset) + e.nameSize > namesSize || e.compression > LZ ||
+           (e.compression == NONE && e.size != e.rawSize))
+        {
+            LOG_EXT("Corrupted archive entry ", i, " in ", fileName);
+            return false;
+        }
+    }
+
+    _file = file;
+    _fileName = fileName;
+    _entries = entries;
+    _table = reinterpret_cast<const uint32_t*>(dir + header.nbEntries * sizeof(Entry));
+    _names = dir + dirSize;
+    _nbEntries = header.nbEntries;
+    _tableSize = header.tableSize;
+    return true;
+}
+
+std::string Archive::name(size_t i) const
+{
+    return std::string(_names + _entries[i].nameOffset, _entries[i].nameSize);
+}
+
+int Archive::findIndex(const std::string& path) const
+{
+    if(!isOpen())
+        return -1;
+
+    const uint64_t h = hash(path);
+    const uint32_t mask = _tableSize - 1;
+    for(uint32_t i=0, slot=uint32_t(h) & mask ; i<_tableSize ; ++i, slot = (slot + 1) & mask)
+    {
+        const uint32_t index = _table[slot];
+        if(index == 0)
+            return -1;
+        if(index > _nbEntries)
+            return -1;
+
+        const Entry& e = _entries[index - 1];
+        if(e.hash == h && e.nameSize == path.size() && memcmp(_names + e.nameOffset, path.data(), path.size()) == 0)
+            return int(index - 1);
+    }
+    return -1;
+}
+
+FileData Archive::find(const std::string& path) const
+{
+    int index = findIndex(path);
+    return index < 0 ? FileData() : read(index);
+}
+
+FileData Archive::read(size_t i) const
+{
+    const Entry& e = _entries[i];
+    const char* stored = _file->data() + e.offset;
+
+    FileData fd;
+    if(e.compression == NONE)
+    {
+        // view in the mapping, which is kept alive
+        fd.data = stored;
+        fd.size = e.size;
+        fd.storage = _file;
+        return fd;
+    }
+
+    auto buffer = std::make_shared<vector<char>>(e.rawSize + 1);
+    if(!lzDecompress(stored, e.size, buffer->data(), e.rawSize))
+    {
+        LOG_EXT("Corrupted entry ", name(i), " in ", _fileName);
+        return FileData();
+    }
+
+    fd.data = buffer->data();
+    fd.size = e.rawSize;
+    fd.storage = buffer;
+    return fd;
+}
+
+bool ArchiveBuilder::add(const std::string& path, const char* data, size_t size, bool compress)
+{
+    File f;
+    f.name = FileSystem::normalize(path);
+    f.hash = Archive::hash(f.name);
+    f.rawSize = size;
+    f.compression = Archive::NONE;
+
+    for(const File& other : _files)
+    {
+        if(other.hash == f.hash && other.name == f.name)
+        {
+            LOG_EXT("Duplicated file in the archive: ", f.name);
+            return false;
+        }
+    }
+
+    if(compress && size > 0)
+    {
+        lzCompress(data, size, f.data);
+        if(f.data.size() < size - size / 10)
+            f.compression = Archive::LZ;
+        else
+            f.data.clear();
+    }
+
+    if(f.compression == Archive::NONE)
+        f.data.assign(data, data + size);
+
+    ++_stats.nbFiles;
+    _stats.nbCompressed += f.compression != Archive::NONE ? 1 : 0;
+    _stats.rawBytes += size;
+    _stats.storedBytes += f.data.size();
+
+    _files.push_back(std::move(f));
+    return true;
+}
+
+bool ArchiveBuilder::write(const std::string& fileName) const
+{
+    std::ofstream out(fileName, std::ios_base::binary);
+    if(!out)
+        return false;
+
+    auto pad = [&out](uint64_t pos) -> uint64_t
+    {
+        const uint64_t aligned = (pos + Archive::ALIGNMENT - 1) / Archive::ALIGNMENT * Archive::ALIGNMENT;
+        for( ; pos < aligned ; ++pos)
+            out.put(0);
+        return aligned;
+    };
+
+    Archive::Header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "TPAK", 4);
+    header.version = Archive::VERSION;
+    header.nbEntries = uint32_t(_files.size());
+    header.alignment = Archive::ALIGNMENT;
+
+    // load factor of 1/2 at most
+    header.tableSize = 1;
+    while(header.tableSize < _files.size() * 2)
+        header.tableSize *= 2;
+
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    uint64_t pos = sizeof(header);
+
+    vector<Archive::Entry> entries(_files.size());
+    std::string names;
+    for(size_t i=0 ; i<_files.size() ; ++i)
+    {
+        const File& f = _files[i];
+        pos = pad(pos);
+
+        Archive::Entry& e = entries[i];
+        memset(&e, 0, sizeof(e));
+        e.offset = pos;
+        e.size = f.data.size();
+        e.rawSize = f.rawSize;
+        e.hash = f.hash;
+        e.nameOffset = uint32_t(names.size());
+        e.nameSize = uint32_t(f.name.size());
+        e.compression = f.compression;
+
+        names += f.name;
+        out.write(f.data.data(), f.data.size());
+        pos += f.data.size();
+    }
+
+    vector<uint32_t> table(header.tableSize, 0);
+    const uint32_t mask = header.tableSize - 1;
+    for(size_t i=0 ; i<entries.size() ; ++i)
+    {
+        uint32_t slot = uint32_t(entries[i].hash) & mask;
+        while(table[slot] != 0)
+            slot = (slot + 1) & mask;
+        table[slot] = uint32_t(i + 1);
+    }
+
+    header.directoryOffset = pos = pad(pos);
+    out.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(Archive::Entry));
+    out.write(reinterpret_cast<const char*>(table.data()), table.size() * sizeof(uint32_t));
+    out.write(names.data(), names.size());
+    header.directorySize = entries.size() * sizeof(Archive::Entry) + table.size() * sizeof(uint32_t) + names.size();
+
+    out.seekp(0);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    return bool(out);
+}
+
+}
+}
+#include "MemoryLoggerOff.h"
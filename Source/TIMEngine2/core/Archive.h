@@ -0,0 +1,115 @@
+#ifndef ARCHIVE_H_INCLUDED
+#define ARCHIVE_H_INCLUDED
+
+#include <string>
+#include <memory>
+#include <cstdint>
+#include "type.h"
+#include "MappedFile.h"
+#include "FileSystem.h"
+
+#include "MemoryLoggerOn.h"
+namespace tim
+{
+namespace core
+{
+    /* Packed files (.tpk), mapped and read without a system call per file:
+     * header (64 bytes) | entries, each aligned on ALIGNMENT | directory
+     * The directory holds the entries, an open addressing table on the hash of the normalized names
+     * (index + 1 of the entry, 0 is empty) and the names. The uncompressed entries are read in place in the mapping,
+     * so a .tim can still be used without copy, the compressed ones (LZ, see LzCodec) are decoded in a buffer. */
+    class Archive
+    {
+    public:
+        static const uint32_t VERSION = 1;
+        static const uint32_t ALIGNMENT = 64;
+
+        enum Compression : uint32_t { NONE = 0, LZ = 1 };
+
+        struct Header
+        {
+            char magic[4]; // "TPAK"
+            uint32_t version;
+            uint32_t nbEntries;
+            uint32_t tableSize; // power of 2
+            uint64_t directoryOffset;
+            uint64_t directorySize;
+            uint32_t alignment;
+            uint32_t pad[7];
+        };
+
+        struct Entry
+        {
+            uint64_t offset;
+            uint64_t size;    // stored
+            uint64_t rawSize; // decompressed
+            uint64_t hash;    // of the normalized name
+            uint32_t nameOffset, nameSize;
+            uint32_t compression, pad;
+        };
+
+        static_assert(sizeof(Header) == 64 && sizeof(Entry) == 48, "Archive layout");
+
+        Archive() = default;
+        Archive(const std::string& file) { open(file); }
+
+        bool open(const std::string&);
+        bool isOpen() const { return _file != nullptr; }
+        const std::string& fileName() const { return _fileName; }
+
+        size_t size() const { return _nbEntries; }
+        std::string name(size_t i) const;
+        const Entry& entry(size_t i) const { return _entries[i]; }
+
+        /* path is normalized, the result is not open if it's not in the archive or corrupted */
+        FileData find(const std::string& path) const;
+        FileData read(size_t i) const;
+        bool contains(const std::string& path) const { return findIndex(path) >= 0; }
+
+        static uint64_t hash(const std::string& normalizedPath);
+
+    private:
+        std::shared_ptr<MappedFile> _file;
+        std::string _fileName;
+        const Entry* _entries = nullptr;
+        const uint32_t* _table = nullptr;
+        const char* _names = nullptr;
+        uint32_t _nbEntries = 0, _tableSize = 0;
+
+        int findIndex(const std::string&) const;
+    };
+
+    /* Write a .tpk, used by the AssetPacker tool */
+    class ArchiveBuilder
+    {
+    public:
+        /* compress: stored compressed if it saves at least 10% */
+        bool add(const std::string& path, const char* data, size_t size, bool compress);
+        bool write(const std::string& file) const;
+
+        size_t size() const { return _files.size(); }
+
+        struct Stats
+        {
+            size_t nbFiles = 0, nbCompressed = 0;
+            uint64_t rawBytes = 0, storedBytes = 0;
+        };
+        const Stats& stats() const { return _stats; }
+
+    private:
+        struct File
+        {
+            std::string name;
+            uint64_t hash, rawSize;
+            uint32_t compression;
+            vector<char> data;
+        };
+
+        vector<File> _files;
+        Stats _stats;
+    };
+}
+}
+#include "MemoryLoggerOff.h"
+
+#endif // ARCHIVE_H_INCLUDED
@@ -0,0 +1,110 @@
+#include "BatchTransform.h"
+#include "ThreadPool.h"
+
+#ifdef TIM_SSE
+    #include <xmmintrin.h>
+#endif
+
+#include "MemoryLoggerOn.h"
+namespace tim
+{
+namespace core
+{
+
+namespace
+{
+    const uint PARALLEL_THRESHOLD = 1 << 15;
+    const uint CHUNK_SIZE = 1 << 13;
+
+    /* Run f(begin, end) on the whole range, split in chunks on the pool when it's worth it */
+    template <class F>
+    void split(uint count, ThreadPool* pool, const F& f)
+    {
+        if(pool && count >= PARALLEL_THRESHOLD)
+        {
+            const uint nbChunks = (count + CHUNK_SIZE - 1) / CHUNK_SIZE;
+            pool->parallelFor(0, nbChunks, 1, [&](size_t c)
+            {
+                f(uint(c)*CHUNK_SIZE, std::min(count, uint(c+1)*CHUNK_SIZE));
+            });
+        }
+        else f(0, count);
+    }
+
+    /* The sums are done in the order of Matrix::operator*(Vector) so the results are identical */
+    template <bool TRANSLATE>
+    void transform(const mat4& m, const real* in, uint inStride, real* out, uint outStride, uint begin, uint end)
+    {
+#ifdef TIM_SSE
+        // columns of the upper 3x4 part, the 4th lane is unused
+        const __m128 c0 = _mm_setr_ps(m[0][0], m[1][0], m[2][0], 0);
+        const __m128 c1 = _mm_setr_ps(m[0][1], m[1][1], m[2][1], 0);
+        const __m128 c2 = _mm_setr_ps(m[0][2], m[1][2], m[2][2], 0);
+        const __m128 c3 = _mm_setr_ps(m[0][3], m[1][3], m[2][3], 0);
+
+        for(uint i=begin ; i<end ; ++i)
+        {
+            const real* p = in + size_t(i)*inStride;
+            __m128 r = _mm_add_ps(_mm_setzero_ps(), _mm_mul_ps(c0, _mm_set1_ps(p[0])));
+            r = _mm_add_ps(r, _mm_mul_ps(c1, _mm_set1_ps(p[1])));
+            r = _mm_add_ps(r, _mm_mul_ps(c2, _mm_set1_ps(p[2])));
+            if(TRANSLATE)
+                r = _mm_add_ps(r, c3);
+
+            // 3 floats only, the 4th may be the next attribute of an interleaved buffer
+            real* o = out + size_t(i)*outStride;
+            _mm_storel_pi(reinterpret_cast<__m64*>(o), r);
+            _mm_store_ss(o + 2, _mm_movehl_ps(r, r));
+        }
+#else
+        for(uint i=begin ; i<end ; ++i)
+        {
+            const real* p = in + size_t(i)*inStride;
+            real r[3];
+            for(int j=0 ; j<3 ; ++j)
+            {
+                r[j] = real(0) + m[j][0]*p[0];
+                r[j] += m[j][1]*p[1];
+                r[j] += m[j][2]*p[2];
+                if(TRANSLATE)
+                    r[j] += m[j][3];
+            }
+
+            real* o = out + size_t(i)*outStride;
+            o[0] = r[0]; o[1] = r[1]; o[2] = r[2];
+        }
+#endif
+    }
+}
+
+void transformPoints(const mat4& m, const real* in, uint inStride, real* out, uint outStride, uint count, ThreadPool* pool)
+{
+    split(count, pool, [&](uint begin, uint end) { transform<true>(m, in, inStride, out, outStride, begin, end); });
+}
+
+void transformDirections(const mat4& m, const real* in, uint inStride, real* out, uint outStride, uint count, ThreadPool* pool)
+{
+    split(count, pool, [&](uint begin, uint end) { transform<false>(m, in, inStride, out, outStride, begin, end); });
+}
+
+void transformSpheres(const mat4& m, const Sphere* in, Sphere* out, uint count, ThreadPool* pool)
+{
+    // the biggest scale of the 3 axis, Sphere::transform applies it to each sphere
+    real scale = 0;
+    for(int j=0 ; j<3 ; ++j)
+        scale = std::max(scale, vec3(m[0][j], m[1][j], m[2][j]).length());
+
+    split(count, pool, [&](uint begin, uint end)
+    {
+        for(uint i=begin ; i<end ; ++i)
+        {
+            vec3 center;
+            transform<true>(m, &in[i].center().x(), 0, &center.x(), 0, 0, 1);
+            out[i] = Sphere(center, in[i].radius() * scale);
+        }
+    });
+}
+
+}
+}
+#include "MemoryLoggerOff.h"
@@ -0,0 +1,41 @@
+#ifndef BATCHTRANSFORM_H_INCLUDED
+#define BATCHTRANSFORM_H_INCLUDED
+
+#include "Matrix.h"
+#include "Sphere.h"
+
+#include "MemoryLoggerOn.h"
+namespace tim
+{
+namespace core
+{
+    class ThreadPool;
+
+    /* Transformation of whole arrays by one matrix, the matrix is read once and kept in registers.
+     * Inputs and outputs are count elements of 3 floats, stride floats apart (an interleaved vertex buffer for instance),
+     * only the 3 first floats of each output element are written. in and out can be the same array with the same stride.
+     * Results are the same as the per element operators; big arrays are split on the pool if one is given. */
+
+    /* out = m * vec4(in, 1), without perspective divide (as mat4 * vec3) */
+    void transformPoints(const mat4& m, const real* in, uint inStride, real* out, uint outStride, uint count, ThreadPool* pool=nullptr);
+
+    /* out = mat3(m) * in, the translation is ignored (normals need the inverse transpose) */
+    void transformDirections(const mat4& m, const real* in, uint inStride, real* out, uint outStride, uint count, ThreadPool* pool=nullptr);
+
+    /* out[i] = in[i] transformed as Sphere::transform does, the radius scale is computed once for the array */
+    void transformSpheres(const mat4& m, const Sphere* in, Sphere* out, uint count, ThreadPool* pool=nullptr);
+
+    inline void transformPoints(const mat4& m, vec3* points, uint count, ThreadPool* pool=nullptr)
+    {
+        transformPoints(m, &points->x(), 3, &points->x(), 3, count, pool);
+    }
+
+    inline void transformDirections(const mat4& m, vec3* dirs, uint count, ThreadPool* pool=nullptr)
+    {
+        transformDirections(m, &dirs->x(), 3, &dirs->x(), 3, count, pool);
+    }
+}
+}
+#include "MemoryLoggerOff.h"
+
+#endif // BATCHTRANSFORM_H_INCLUDED
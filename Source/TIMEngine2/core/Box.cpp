@@ -2,6 +2,12 @@
 #include "Box.h"
 #include "Sphere.h"
 #include "OrientedBox.h"
+#include "ThreadPool.h"
+
+#include <cfloat>
+#ifdef TIM_SSE
+    #include <xmmintrin.h>
+#endif
 
 #include "MemoryLoggerOn.h"
 namespace tim
@@ -225,18 +231,72 @@ Plan Box::extractOptimalPlan() const
     return Plan(center(), dir);
 }
 
-Box Box::computeBox(const real* ptr, uint size, uint stride)
+namespace
+{
+    const uint PARALLEL_THRESHOLD = 1 << 16;
+    const uint CHUNK_SIZE = 1 << 14;
+
+    void minMax(const real* ptr, uint begin, uint end, uint stride, vec3& minV, vec3& maxV)
+    {
+        uint i = begin;
+#ifdef TIM_SSE
+        if(stride >= 3)
+        {
+            // 4 floats are loaded per point, keep the last point of the array scalar when the 4th float isn't ours
+            const uint simdEnd = stride >= 4 || end <= begin ? end : end - 1;
+            __m128 mi = _mm_set1_ps(FLT_MAX), ma = _mm_set1_ps(-FLT_MAX);
+            for( ; i<simdEnd ; ++i)
+            {
+                const __m128 v = _mm_loadu_ps(ptr + size_t(i)*stride);
+                mi = _mm_min_ps(mi, v);
+                ma = _mm_max_ps(ma, v);
+            }
+
+            float fmi[4], fma[4];
+            _mm_storeu_ps(fmi, mi);
+            _mm_storeu_ps(fma, ma);
+            for(int j=0 ; j<3 ; ++j)
+            {
+                minV[j] = std::min(minV[j], fmi[j]);
+                maxV[j] = std::max(maxV[j], fma[j]);
+            }
+        }
+#endif
+        for( ; i<end ; ++i)
+        {
+            for(int j=0 ; j<3 ; ++j)
+            {
+                minV[j] = std::min(minV[j], ptr[j+size_t(i)*stride]);
+                maxV[j] = std::max(maxV[j], ptr[j+size_t(i)*stride]);
+            }
+        }
+    }
+}
+
+Box Box::computeBox(const real* ptr, uint size, uint stride, ThreadPool* pool)
 {
-    vec3 minV = vec3::construct(std::numeric_limits<float>::max()), maxV = vec3::construct(std::numeric_limits<float>::min());
+    vec3 minV = vec3::construct(FLT_MAX), maxV = vec3::construct(-FLT_MAX);
 
-    for(uint i=0 ; i<size ; ++i)
+    if(pool && size >= PARALLEL_THRESHOLD)
     {
-        for(int j=0 ; j<3 ; ++j)
+        const uint nbChunks = (size + CHUNK_SIZE - 1) / CHUNK_SIZE;
+        vector<vec3> chunkMin(nbChunks, minV), chunkMax(nbChunks, maxV);
+
+        pool->parallelFor(0, nbChunks, 1, [&](size_t c)
+        {
+            minMax(ptr, uint(c)*CHUNK_SIZE, std::min(size, uint(c+1)*CHUNK_SIZE), stride, chunkMin[c], chunkMax[c]);
+        });
+
+        for(uint c=0 ; c<nbChunks ; ++c)
         {
-            minV[j] = std::min(minV[j], ptr[j+i*stride]);
-            maxV[j] = std::max(maxV[j], ptr[j+i*stride]);
+            for(int j=0 ; j<3 ; ++j)
+            {
+                minV[j] = std::min(minV[j], chunkMin[c][j]);
+                maxV[j] = std::max(maxV[j], chunkMax[c][j]);
+            }
         }
     }
+    else minMax(ptr, 0, size, stride, minV, maxV);
 
     return Box(minV, maxV);
 }
@@ -12,6 +12,7 @@ namespace core
 {
     class Sphere;
     class OrientedBox;
+    class ThreadPool;
     struct OrientedBoxAxis;
 
     class Box
@@ -19,7 +20,8 @@ namespace core
 
     public:
 
-        static Box computeBox(const real* ptr, uint size, uint stride=1);
+        /* Bounding box of size points of 3 floats, stride floats apart; big inputs are split on the pool if one is given */
+        static Box computeBox(const real* ptr, uint size, uint stride=1, ThreadPool* pool=nullptr);
 
         Box();
         Box(const Vector<vec2, 3>&);
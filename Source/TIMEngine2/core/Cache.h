@@ -1,99 +1,234 @@
 #ifndef CACHE_H_INCLUDED
 #define CACHE_H_INCLUDED
 
-#include "boost/thread/mutex.hpp"
-#include "core/Rand.h"
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include "Common.h"
+#include "type.h"
+#include "Option.h"
+#include "NonCopyable.h"
+#include "MemoryLogger.h"
 
 #include "MemoryLoggerOn.h"
 namespace tim
 {
 namespace core
 {
-    template <class Data, class Key, class LockPolicy, uint NB_SLOTS=16>
-    class LinearCache
+    /* Thread safe LRU cache, split in shards each with its own mutex, hash index and LRU list.
+     * The capacity is a number of entries, or a total cost when a cost function is given (bytes for instance);
+     * each shard holds capacity/nbShards and evicts its least recently used entries when full.
+     * getOrCompute runs the computation once per key: concurrent misses on the same key wait for the first one. */
+    template <class Key, class Value, class Hash = std::hash<Key>>
+    class LruCache : NonCopyable
     {
     public:
-        LinearCache()
+        using CostFunction = std::function<size_t(const Key&, const Value&)>;
+
+        struct Stats
+        {
+            uint64_t hits, misses, evictions;
+            uint64_t waits; // misses served by a computation already in flight
+            size_t size, cost;
+        };
+
+        LruCache(size_t capacity, uint nbShards = 16, CostFunction cost = nullptr)
+            : _nbShards(nbShards > 0 ? nbShards : 1), _shards(new Shard[_nbShards]), _cost(std::move(cost))
         {
-            for(int i=0 ; i<NB_SLOTS ; ++i)
-                std::get<2>(_data[i]) = 0;
+            _shardCapacity = std::max<size_t>(capacity / _nbShards, 1);
         }
 
-        /* Lock unlock function */
+        Option<Value> get(const Key& key)
+        {
+            Shard& s = shard(key);
+            std::lock_guard<std::mutex> guard(s.mutex);
 
-        void lock(uint index) { std::get<3>(_data[index]).lock(); }
+            auto it = s.index.find(key);
+            if(it == s.index.end())
+            {
+                _misses.fetch_add(1, std::memory_order_relaxed);
+                return Option<Value>();
+            }
 
-        bool searchLock(const Key& k, uint& index) const // return true if the key is found
+            _hits.fetch_add(1, std::memory_order_relaxed);
+            s.lru.splice(s.lru.begin(), s.lru, it->second);
+            return Option<Value>(it->second->value);
+        }
+
+        void put(const Key& key, const Value& value)
+        {
+            Shard& s = shard(key);
+            std::lock_guard<std::mutex> guard(s.mutex);
+            insert(s, key, value);
+        }
+
+        template <class Compute>
+        Value getOrCompute(const Key& key, Compute&& compute)
         {
-            for(uint i=0 ; i<NB_SLOTS ; ++i)
+            Shard& s = shard(key);
+            std::promise<Value> promise;
             {
-                std::get<3>(_data[i]).lock();
-                if(k == std::get<0>(_data[i]))
+                std::unique_lock<std::mutex> guard(s.mutex);
+
+                auto it = s.index.find(key);
+                if(it != s.index.end())
                 {
-                    index=i;
-                    return true;
+                    _hits.fetch_add(1, std::memory_order_relaxed);
+                    s.lru.splice(s.lru.begin(), s.lru, it->second);
+                    return it->second->value;
                 }
-                std::get<3>(_data[i]).unlock();
+
+                auto inFlight = s.pending.find(key);
+                if(inFlight != s.pending.end())
+                {
+                    std::shared_future<Value> future = inFlight->second;
+                    guard.unlock();
+
+                    _waits.fetch_add(1, std::memory_order_relaxed);
+                    return future.get();
+                }
+
+                _misses.fetch_add(1, std::memory_order_relaxed);
+                s.pending.emplace(key, promise.get_future().share());
             }
-            return false;
-        }
 
-        bool searchAvailableLock(uint& index) // if return false, the cache must be flush
-        {
-            for(uint i=0 ; i<NB_SLOTS ; ++i)
+            try
             {
-                std::get<3>(_data[i]).lock();
-                if(std::get<2>(_data[i]) == 0)
+                Value value = compute();
                 {
-                    index=i;
-                    return true;
+                    std::lock_guard<std::mutex> guard(s.mutex);
+                    insert(s, key, value);
+                    s.pending.erase(key);
                 }
-                std::get<3>(_data[i]).unlock();
+                promise.set_value(value);
+                return value;
             }
-
-            vector<uint> available;
-            for(uint i=0 ; i<NB_SLOTS ; ++i)
+            catch(...)
             {
-                std::get<3>(_data[i]).lock();
-                if(std::get<2>(_data[i]) == 1)
-                    available.push_back(i);
-                else
-                    std::get<3>(_data[i]).unlock();
+                {
+                    std::lock_guard<std::mutex> guard(s.mutex);
+                    s.pending.erase(key);
+                }
+                promise.set_exception(std::current_exception());
+                throw;
             }
+        }
+
+        bool erase(const Key& key)
+        {
+            Shard& s = shard(key);
+            std::lock_guard<std::mutex> guard(s.mutex);
 
-            if(available.empty())
-                return false; // the cache need to be flush
+            auto it = s.index.find(key);
+            if(it == s.index.end())
+                return false;
 
-            index=Rand::rand()%available.size();
-            for(size_t i=0 ; i<available.size() ; ++i)
+            s.cost -= it->second->cost;
+            s.lru.erase(it->second);
+            s.index.erase(it);
+            return true;
+        }
+
+        void clear()
+        {
+            for(uint i=0 ; i<_nbShards ; ++i)
             {
-                if(i != index)
-                    std::get<3>(_data[available[i]]).unlock();
+                std::lock_guard<std::mutex> guard(_shards[i].mutex);
+                _shards[i].index.clear();
+                _shards[i].lru.clear();
+                _shards[i].cost = 0;
             }
+        }
 
-            index = available[index];
-            return true;
+        Stats stats() const
+        {
+            Stats st = { _hits.load(), _misses.load(), _evictions.load(), _waits.load(), 0, 0 };
+            for(uint i=0 ; i<_nbShards ; ++i)
+            {
+                std::lock_guard<std::mutex> guard(_shards[i].mutex);
+                st.size += _shards[i].index.size();
+                st.cost += _shards[i].cost;
+            }
+            return st;
         }
 
-        void unlock(uint index) const
+        void resetStats()
         {
-            std::get<3>(_data[index]).unlock();
+            _hits = 0; _misses = 0; _evictions = 0; _waits = 0;
         }
 
-        /* if you have the lock you can use: */
+        size_t capacity() const { return _shardCapacity * _nbShards; }
+
+    private:
+        struct Entry
+        {
+            Key key;
+            Value value;
+            size_t cost;
+        };
 
-        const Data& get(int i) const { return std::get<1>(_data[i]); }
-        Data& get(int i) { return std::get<1>(_data[i]); }
+        struct Shard
+        {
+            mutable std::mutex mutex;
+            std::list<Entry> lru; // most recently used first
+            std::unordered_map<Key, typename std::list<Entry>::iterator, Hash> index;
+            std::unordered_map<Key, std::shared_future<Value>, Hash> pending;
+            size_t cost = 0;
+        };
+
+        uint _nbShards;
+        std::unique_ptr<Shard[]> _shards;
+        size_t _shardCapacity;
+        CostFunction _cost;
+        Hash _hash;
+
+        std::atomic<uint64_t> _hits = 0, _misses = 0, _evictions = 0, _waits = 0;
+
+        Shard& shard(const Key& key)
+        {
+            // the low bits of std::hash are often poor (identity on integers), mix before the modulo
+            uint64_t h = static_cast<uint64_t>(_hash(key));
+            h ^= h >> 33;
+            h *= 0xff51afd7ed558ccdull;
+            h ^= h >> 33;
+            return _shards[h % _nbShards];
+        }
 
-        void upToDate(uint index) { std::get<2>(_data[index]) = 1; }
-        void changed(uint index) { std::get<2>(_data[index]) = 2; }
-        void setKey(uint index, const Key& k) { std::get<0>(_data[index]) = k; }
+        /* Shard must be locked */
+        void insert(Shard& s, const Key& key, const Value& value)
+        {
+            const size_t cost = _cost ? _cost(key, value) : 1;
 
-        const Key& getKey(uint index) const { return std::get<0>(_data[index]); }
-        int getState(uint index) const { return std::get<2>(_data[index]); }
+            auto it = s.index.find(key);
+            if(it != s.index.end())
+            {
+                s.cost -= it->second->cost;
+                it->second->value = value;
+                it->second->cost = cost;
+                s.lru.splice(s.lru.begin(), s.lru, it->second);
+            }
+            else
+            {
+                s.lru.push_front({ key, value, cost });
+                s.index.emplace(key, s.lru.begin());
+            }
+            s.cost += cost;
 
-    private:
-        mutable std::tuple<Key, Data, int, std::mutex> _data[NB_SLOTS]; // key, data, state { 0:free 1:uptodate 2:changed }, lock
+            // the newest entry is kept even if it doesn't fit alone
+            while(s.cost > _shardCapacity && s.lru.size() > 1)
+            {
+                Entry& last = s.lru.back();
+                s.cost -= last.cost;
+                s.index.erase(last.key);
+                s.lru.pop_back();
+                _evictions.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
     };
 }
 }
@@ -1,4 +1,5 @@
 #include "Common.h"
+#include "Logger.h"
 
 #include <windows.h>
 #include "DebugApi.h"
@@ -17,6 +18,7 @@ namespace tim
             OutputDebugString(buffer);
 
         std::cerr << buffer << std::endl;
+        core::logger.flush();
         
         if (IsDebuggerPresent())
             __debugbreak();
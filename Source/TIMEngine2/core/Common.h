@@ -13,6 +13,11 @@
 #define TIM_ASSERT_MSG(cond)
 #endif
 
+/* SSE intrinsics are available (x64, or x86 built with /arch:SSE or above) */
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define TIM_SSE
+#endif
+
 namespace tim
 {
     void handleAssert(int _line, const char* _file, const char* _msg);
@@ -0,0 +1,160 @@
+#include "FileSystem.h"
+#include "Archive.h"
+#include "MappedFile.h"
+#include "Logger.h"
+#include <shared_mutex>
+#include <filesystem>
+#include <cctype>
+
+#include "MemoryLoggerOn.h"
+namespace tim
+{
+namespace core
+{
+
+namespace
+{
+    struct Mount
+    {
+        std::shared_ptr<Archive> archive;
+        std::string root; // normalized, without the last '/'
+    };
+
+    std::shared_mutex mountsMutex;
+    vector<Mount> mounts;
+
+    /* f(archive, path in the archive) on the mounts under which the path is, the last mounted first, until it returns true */
+    template<class F>
+    bool findInMounts(const std::string& path, F f)
+    {
+        std::shared_lock<std::shared_mutex> guard(mountsMutex);
+        if(mounts.empty())
+            return false;
+
+        const std::string key = FileSystem::normalize(path);
+        for(size_t i=mounts.size() ; i-- > 0 ; )
+        {
+            const std::string& root = mounts[i].root;
+            if(root.empty())
+            {
+                if(f(*mounts[i].archive, key)) return true;
+            }
+            else if(key.size() > root.size() && key[root.size()] == '/' && key.compare(0, root.size(), root) == 0)
+            {
+                if(f(*mounts[i].archive, key.substr(root.size() + 1))) return true;
+            }
+        }
+        return false;
+    }
+}
+
+std::string FileSystem::normalize(const std::string& path)
+{
+    vector<std::string> parts;
+    std::string part;
+
+    for(size_t i=0 ; i<=path.size() ; ++i)
+    {
+        const char c = i < path.size() ? path[i] : '/';
+        if(c != '/' && c != '\\')
+        {
+            part += char(tolower(static_cast<unsigned char>(c)));
+            continue;
+        }
+
+        if(part == "..")
+        {
+            if(!parts.empty() && parts.back() != "..") parts.pop_back();
+            else parts.push_back(part);
+        }
+        else if(!part.empty() && part != ".")
+            parts.push_back(part);
+        part.clear();
+    }
+
+    std::string res;
+    for(size_t i=0 ; i<parts.size() ; ++i)
+    {
+        if(i > 0) res += '/';
+        res += parts[i];
+    }
+    return res;
+}
+
+bool FileSystem::mount(const std::string& file, const std::string& root)
+{
+    auto archive = std::make_shared<Archive>();
+    if(!archive->open(file))
+    {
+        LOG_EXT("Failed to mount ", file);
+        return false;
+    }
+
+    std::unique_lock<std::shared_mutex> guard(mountsMutex);
+    mounts.push_back({archive, normalize(root)});
+    return true;
+}
+
+void FileSystem::unmount(const std::string& file)
+{
+    std::unique_lock<std::shared_mutex> guard(mountsMutex);
+    for(size_t i=0 ; i<mounts.size() ; )
+    {
+        if(mounts[i].archive->fileName() == file) mounts.erase(mounts.begin() + i);
+        else ++i;
+    }
+}
+
+void FileSystem::unmountAll()
+{
+    std::unique_lock<std::shared_mutex> guard(mountsMutex);
+    mounts.clear();
+}
+
+FileData FileSystem::read(const std::string& path)
+{
+    FileData fd;
+    if(findInMounts(path, [&fd](const Archive& archive, const std::string& key) { fd = archive.find(key); return fd.isOpen(); }))
+        return fd;
+
+    auto file = std::make_shared<MappedFile>(path);
+    if(!file->isOpen())
+        return FileData();
+
+    fd.data = file->data();
+    fd.size = file->size();
+    fd.storage = file;
+    return fd;
+}
+
+bool FileSystem::exists(const std::string& path)
+{
+    if(findInMounts(path, [](const Archive& archive, const std::string& key) { return archive.contains(key); }))
+        return true;
+
+    std::error_code ec;
+    return std::filesystem::is_regular_file(path, ec);
+}
+
+bool FileSystem::readText(const std::string& path, std::string& text)
+{
+    text.clear();
+    FileData fd = read(path);
+    if(!fd.isOpen())
+        return false;
+
+    text.reserve(fd.size + 1);
+    for(size_t i=0 ; i<fd.size ; ++i)
+    {
+        if(fd.data[i] != '\r') text += fd.data[i];
+        else if(i + 1 >= fd.size || fd.data[i+1] != '\n') text += '\n';
+    }
+
+    if(text.empty() || text.back() != '\n')
+        text += '\n';
+    return true;
+}
+
+}
+}
+#include "MemoryLoggerOff.h"
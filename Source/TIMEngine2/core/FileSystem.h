@@ -0,0 +1,87 @@
+#ifndef FILESYSTEM_H_INCLUDED
+#define FILESYSTEM_H_INCLUDED
+
+#include <string>
+#include <memory>
+#include <istream>
+#include <streambuf>
+
+#include "MemoryLoggerOn.h"
+namespace tim
+{
+namespace core
+{
+    /* Read only content of a file, kept alive by storage (mapping of the loose file or of the archive, or decoded copy) */
+    struct FileData
+    {
+        const char* data = nullptr;
+        size_t size = 0;
+        std::shared_ptr<void> storage;
+
+        bool isOpen() const { return data != nullptr; }
+    };
+
+    /* Virtual file layer of the loaders: the files are searched in the mounted archives (.tpk, see Archive),
+     * the last mounted first, then on the disk, so a pack can be replaced by loose files file by file.
+     * Thread safe. */
+    class FileSystem
+    {
+    public:
+        /* The paths in the archive are relative to root: with root "Data", "Data/mesh/a.tim" is "mesh/a.tim" in the archive */
+        static bool mount(const std::string& archive, const std::string& root = "");
+        static void unmount(const std::string& archive);
+        static void unmountAll();
+
+        static FileData read(const std::string& path);
+        /* Without reading the file */
+        static bool exists(const std::string& path);
+
+        /* Content with "\n" line endings, empty if the file can't be read */
+        static bool readText(const std::string& path, std::string& text);
+
+        /* Key of a path in an archive: '/' separators, no "." or ".." parts, lower case (the loose files are on Windows) */
+        static std::string normalize(const std::string& path);
+    };
+
+    /* std::istream reading a FileData, for the loaders written for the streams */
+    class MemoryStream : public std::istream
+    {
+    public:
+        MemoryStream(const FileData& file) : std::istream(&_buf), _file(file), _buf(file.data, file.size) {}
+
+        const FileData& file() const { return _file; }
+
+    private:
+        class Buffer : public std::streambuf
+        {
+        public:
+            Buffer(const char* data, size_t size)
+            {
+                char* p = const_cast<char*>(data); // never written, the get area only
+                setg(p, p, p + size);
+            }
+
+        protected:
+            pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode) override
+            {
+                char* pos = (dir == std::ios_base::beg ? eback() : dir == std::ios_base::cur ? gptr() : egptr()) + off;
+                if(pos < eback() || pos > egptr())
+                    return pos_type(off_type(-1));
+                setg(eback(), pos, egptr());
+                return pos_type(off_type(pos - eback()));
+            }
+
+            pos_type seekpos(pos_type pos, std::ios_base::openmode mode) override
+            {
+                return seekoff(off_type(pos), std::ios_base::beg, mode);
+            }
+        };
+
+        FileData _file;
+        Buffer _buf;
+    };
+}
+}
+#include "MemoryLoggerOff.h"
+
+#endif // FILESYSTEM_H_INCLUDED
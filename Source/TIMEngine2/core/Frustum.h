@@ -45,6 +45,7 @@ namespace core
 
         void add(const Plan&);
         const Plan& plan(int) const;
+        size_t nbPlan() const { return _plans.size(); }
         void clear();
 
         /* Collision*/
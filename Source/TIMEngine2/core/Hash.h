@@ -0,0 +1,56 @@
+#ifndef HASH_H_INCLUDED
+#define HASH_H_INCLUDED
+
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+
+namespace tim
+{
+namespace core
+{
+    /* 64 bits hash of a block of memory (MurmurHash64A), stable across runs and platforms of the same endianness,
+     * usable as a content hash. Several blocks are hashed by passing the hash of the previous one as seed. Not cryptographic. */
+    inline uint64_t hash64(const void* data, size_t size, uint64_t seed = 0)
+    {
+        const uint64_t m = 0xc6a4a7935bd1e995ull;
+        const int r = 47;
+
+        uint64_t h = seed ^ (size * m);
+
+        const unsigned char* ptr = static_cast<const unsigned char*>(data);
+        const unsigned char* end = ptr + (size & ~size_t(7));
+        for( ; ptr != end ; ptr += 8)
+        {
+            uint64_t k;
+            memcpy(&k, ptr, 8);
+
+            k *= m;
+            k ^= k >> r;
+            k *= m;
+
+            h ^= k;
+            h *= m;
+        }
+
+        switch(size & 7)
+        {
+        case 7: h ^= uint64_t(ptr[6]) << 48; [[fallthrough]];
+        case 6: h ^= uint64_t(ptr[5]) << 40; [[fallthrough]];
+        case 5: h ^= uint64_t(ptr[4]) << 32; [[fallthrough]];
+        case 4: h ^= uint64_t(ptr[3]) << 24; [[fallthrough]];
+        case 3: h ^= uint64_t(ptr[2]) << 16; [[fallthrough]];
+        case 2: h ^= uint64_t(ptr[1]) << 8;  [[fallthrough]];
+        case 1: h ^= uint64_t(ptr[0]);
+                h *= m;
+        }
+
+        h ^= h >> r;
+        h *= m;
+        h ^= h >> r;
+        return h;
+    }
+}
+}
+
+#endif // HASH_H_INCLUDED
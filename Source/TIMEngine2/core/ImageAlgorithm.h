@@ -1,15 +1,83 @@
 #ifndef IMAGE_ALGORITHM_H_INCLUDED
 #define IMAGE_ALGORITHM_H_INCLUDED
 
+#include "Common.h"
 #include "Vector.h"
 #include "PascaleTriangle.h"
 #include "Matrix.h"
+#include "ThreadPool.h"
+#include "StringUtils.h"
+#include <algorithm>
+
+#ifdef TIM_SSE
+    #include <xmmintrin.h>
+#endif
 
 #include "MemoryLoggerOn.h"
 namespace tim
 {
 namespace core
 {
+    namespace imageAlgorithm
+    {
+        /* Number of floats of a pixel type made only of floats, 0 otherwise */
+        template <class T> struct FloatCount { static constexpr uint value = 0; };
+        template <> struct FloatCount<float> { static constexpr uint value = 1; };
+        template <size_t N> struct FloatCount<Vector<float, N>>
+        {
+            static constexpr uint value = sizeof(Vector<float, N>) == N*sizeof(float) ? uint(N) : 0;
+        };
+
+        /* out[i] = sum(src[k][i] * w[k]), accumulated in k order like the scalar code */
+        inline void weightedSum(float* out, const float* const* src, const float* w, uint nbSrc, size_t n)
+        {
+            size_t i=0;
+#ifdef TIM_SSE
+            for( ; i+4<=n ; i+=4)
+            {
+                __m128 acc = _mm_mul_ps(_mm_loadu_ps(src[0]+i), _mm_set1_ps(w[0]));
+                for(uint k=1 ; k<nbSrc ; ++k)
+                    acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(src[k]+i), _mm_set1_ps(w[k])));
+                _mm_storeu_ps(out+i, acc);
+            }
+#endif
+            for( ; i<n ; ++i)
+            {
+                float acc = src[0][i] * w[0];
+                for(uint k=1 ; k<nbSrc ; ++k)
+                    acc += src[k][i] * w[k];
+                out[i] = acc;
+            }
+        }
+
+        /* Same on any pixel type, using the SSE path when T is made of floats */
+        template <class T>
+        void weightedSum(T* out, const T* const* src, const float* w, uint nbSrc, size_t n)
+        {
+            constexpr uint NF = FloatCount<T>::value;
+            if constexpr(NF > 0)
+            {
+                const float* fsrc[64];
+                TIM_ASSERT(nbSrc <= 64);
+                for(uint k=0 ; k<nbSrc ; ++k)
+                    fsrc[k] = reinterpret_cast<const float*>(src[k]);
+                weightedSum(reinterpret_cast<float*>(out), fsrc, w, nbSrc, n*NF);
+            }
+            else
+            {
+                for(size_t i=0 ; i<n ; ++i)
+                {
+                    T acc = src[0][i] * w[0];
+                    for(uint k=1 ; k<nbSrc ; ++k)
+                        acc += src[k][i] * w[k];
+                    out[i] = acc;
+                }
+            }
+        }
+    }
+
+    /* Pixel (x,y) is stored at x*size.y+y: a column of constant x is contiguous.
+     * Kernels walk memory in that order; the functions taking a ThreadPool split the work by columns when one is given. */
     template <class T>
     class ImageAlgorithm
     {
@@ -47,11 +115,15 @@ namespace core
         const T& clamp_get(int x, int y) const;
         T& clamp_get(int x, int y);
 
-        ImageAlgorithm blur3x3() const;
-        template <uint KS> ImageAlgorithm blur() const;
+        ImageAlgorithm blur3x3(ThreadPool* pool = nullptr) const;
+        template <uint KS> ImageAlgorithm blur(ThreadPool* pool = nullptr) const; // gaussian (binomial) kernel
+        ImageAlgorithm boxBlur(uint radius, ThreadPool* pool = nullptr) const;
+
+        /* Separable convolution with clamped borders: along x with wx, then along y with wy (odd sizes, at most 63 taps) */
+        ImageAlgorithm convolved(const float* wx, uint sizeX, const float* wy, uint sizeY, ThreadPool* pool = nullptr) const;
 
-        ImageAlgorithm resized(uivec2) const;
-        ImageAlgorithm transformed(const imat2&) const;
+        ImageAlgorithm resized(uivec2, ThreadPool* pool = nullptr) const;
+        ImageAlgorithm transformed(const imat2&, ThreadPool* pool = nullptr) const;
 
     private:
         T* _data;
@@ -66,6 +138,14 @@ namespace core
         T& get(uivec2);
 
         bool check(uivec2 v) const { return v.x() < _size.x() && v.y() < _size.y(); }
+
+        /* f(x) for each column, on the pool if any */
+        template <class F>
+        static void forEachColumn(uint width, ThreadPool* pool, const F& f)
+        {
+            if(pool && width > 1) pool->parallelFor(0, width, 16, [&f](size_t x) { f(uint(x)); });
+            else for(uint x=0 ; x<width ; ++x) f(x);
+        }
     };
 
     template <class T>
@@ -74,9 +154,7 @@ namespace core
         if(!dat) return;
 
         build(s);
-        for(uint i=0 ; i<_size.x() ; ++i)
-            for(uint j=0 ; j<_size.y() ; ++j)
-                get({i,j}) = dat[i*_size.y()+j];
+        std::copy(dat, dat + _size.x()*_size.y(), _data);
     }
 
     template <class T>
@@ -89,9 +167,7 @@ namespace core
     ImageAlgorithm<T>::ImageAlgorithm(const ImageAlgorithm& img) : _data(nullptr), _size(0,0)
     {
         build(img._size);
-        for(uint i=0 ; i<_size.x() ; ++i)
-            for(uint j=0 ; j<_size.y() ; ++j)
-                get({i,j}) = img.get({i,j});
+        std::copy(img._data, img._data + _size.x()*_size.y(), _data);
     }
 
     template <class T>
@@ -112,9 +188,7 @@ namespace core
         if(_size != img._size)
             build(img._size);
 
-        for(uint i=0 ; i<_size.x() ; ++i)
-            for(uint j=0 ; j<_size.y() ; ++j)
-                get({i,j}) = img.get({i,j});
+        std::copy(img._data, img._data + _size.x()*_size.y(), _data);
         return *this;
     }
 
@@ -244,104 +318,146 @@ namespace core
     }
 
     template <class T>
-    ImageAlgorithm<T> ImageAlgorithm<T>::blur3x3() const
+    ImageAlgorithm<T> ImageAlgorithm<T>::blur3x3(ThreadPool* pool) const
     {
-        ImageAlgorithm<T> img(_size);
-        for(int i=0 ; i<static_cast<int>(_size.x()) ; ++i)
-        {
-            for(int j=0 ; j<static_cast<int>(_size.y()) ; ++j)
-            {
-                T c = clamp_get(i-1,j-1)*0.25 + clamp_get(i,j-1)*0.5 + clamp_get(i+1,j-1)*0.25
-                    + clamp_get(i-1,j)*0.5 + clamp_get(i,j) + clamp_get(i+1,j)*0.5
-                    + clamp_get(i-1,j+1)*0.25 + clamp_get(i,j+1)*0.5 + clamp_get(i+1,j+1)*0.25;
-
-                img.set(i,j, c*0.25);
-            }
-        }
-        return img;
+        const float w[3] = {0.25f, 0.5f, 0.25f};
+        return convolved(w, 3, w, 3, pool);
     }
 
     template <class T>
     template<uint KS>
-    ImageAlgorithm<T> ImageAlgorithm<T>::blur() const
+    ImageAlgorithm<T> ImageAlgorithm<T>::blur(ThreadPool* pool) const
     {
         static_assert(KS%2==1, "KS must be odd.");
+        static_assert(KS <= 31, "KS too big for the binomial coefficients.");
         static PascaleTriangle COEF(KS);
 
+        float w[KS];
+        for(uint k=0 ; k<KS ; ++k)
+            w[k] = float(float(COEF.getRow(KS-1)[k]) / (1<<(KS-1)));
+
+        return convolved(w, KS, w, KS, pool);
+    }
+
+    template <class T>
+    ImageAlgorithm<T> ImageAlgorithm<T>::boxBlur(uint radius, ThreadPool* pool) const
+    {
+        TIM_ASSERT(radius < 32);
+        const uint KS = radius*2+1;
+
+        float w[63];
+        std::fill(w, w+KS, 1.f / KS);
+        return convolved(w, KS, w, KS, pool);
+    }
+
+    template <class T>
+    ImageAlgorithm<T> ImageAlgorithm<T>::convolved(const float* wx, uint sizeX, const float* wy, uint sizeY, ThreadPool* pool) const
+    {
+        TIM_ASSERT(sizeX%2==1 && sizeY%2==1 && sizeX <= 63 && sizeY <= 63);
+        if(empty()) return *this;
+
+        const int W = int(_size.x()), H = int(_size.y());
+
+        // along x: a column is a weighted sum of its neighbour columns, contiguous arrays
         ImageAlgorithm<T> imgH(_size);
-        for(int i=0 ; i<static_cast<int>(_size.x()) ; ++i)
-            for(int j=0 ; j<static_cast<int>(_size.y()) ; ++j)
+        const int rx = int(sizeX-1)/2;
+        forEachColumn(_size.x(), pool, [&](uint x)
         {
-            T c;
-            for(int k=-(int(KS)-1)/2 ; k<=(int(KS)-1)/2 ; ++k)
-                c += clamp_get(i+k,j) * float(float(COEF.getRow(KS-1)[k+(KS-1)/2]) / (1<<(KS-1)));
+            const T* src[63];
+            for(int k=-rx ; k<=rx ; ++k)
+                src[k+rx] = _data + std::max(std::min(int(x)+k, W-1), 0) * H;
 
-            imgH.set(i,j, c);
-        }
+            imageAlgorithm::weightedSum(imgH._data + x*H, src, wx, sizeX, H);
+        });
 
+        // along y: inside the column, shifted views of it for the interior, clamped taps on the borders
         ImageAlgorithm<T> imgV(_size);
-        for(int i=0 ; i<static_cast<int>(_size.x()) ; ++i)
-            for(int j=0 ; j<static_cast<int>(_size.y()) ; ++j)
+        const int ry = int(sizeY-1)/2;
+        forEachColumn(_size.x(), pool, [&](uint x)
         {
-            T c;
-            for(int k=-(int(KS)-1)/2 ; k<=(int(KS)-1)/2 ; ++k)
-                c += imgH.clamp_get(i,j+k) * float(float(COEF.getRow(KS-1)[k+(KS-1)/2]) / (1<<(KS-1)));
+            const T* col = imgH._data + x*H;
+            T* out = imgV._data + x*H;
 
-            imgV.set(i,j, c);
-        }
+            auto border = [&](int y)
+            {
+                T c = col[std::max(std::min(y-ry, H-1), 0)] * wy[0];
+                for(int k=1 ; k<int(sizeY) ; ++k)
+                    c += col[std::max(std::min(y+k-ry, H-1), 0)] * wy[k];
+                out[y] = c;
+            };
+
+            const int beginInterior = std::min(ry, H), endInterior = std::max(H-ry, beginInterior);
+            for(int y=0 ; y<beginInterior ; ++y)
+                border(y);
+
+            if(endInterior > beginInterior)
+            {
+                const T* src[63];
+                for(int k=0 ; k<int(sizeY) ; ++k)
+                    src[k] = col + beginInterior + k - ry;
+                imageAlgorithm::weightedSum(out + beginInterior, src, wy, sizeY, endInterior - beginInterior);
+            }
+
+            for(int y=endInterior ; y<H ; ++y)
+                border(y);
+        });
 
         return imgV;
     }
 
     template <class T>
-    ImageAlgorithm<T> ImageAlgorithm<T>::resized(uivec2 s) const
+    ImageAlgorithm<T> ImageAlgorithm<T>::resized(uivec2 s, ThreadPool* pool) const
     {
         if(s.x() == 0 || s.y() == 0 || (s == _size) || s.x() > _size.x() || s.y() > _size.y())
             return *this;
 
         class Foo
         {   public:
-            static ImageAlgorithm<T> reduceX(const ImageAlgorithm<T>& img, uint minX)
+            static ImageAlgorithm<T> reduceX(const ImageAlgorithm<T>& img, uint minX, ThreadPool* pool)
             {
                 uint lp2 = l_power2(img.size().x());
                 if(lp2 < minX) lp2 = minX;
                 bool times2 = (lp2 == (img.size().x()>>1));
 
                 ImageAlgorithm res({lp2, img.size().y()});
-                for(uint i=0 ; i<img.size().y() ; ++i)
-                    for(uint j=0 ; j<lp2 ; ++j)
+                forEachColumn(lp2, pool, [&](uint j)
                 {
-                    if(times2)
-                        res.set(j,i, (img.clamp_get(j*2,i)+img.clamp_get(j*2+1,i))/2);
-                    else
+                    for(uint i=0 ; i<img.size().y() ; ++i)
                     {
-                        float ratio = float(img.size().x()) / lp2;
-                        float offset = 0.5f*(float(lp2) - (ratio*(lp2-1)));
-                        res.set(j,i, img.getLinear(vec2(ratio*j+offset, float(i))));
+                        if(times2)
+                            res.set(j,i, (img.clamp_get(j*2,i)+img.clamp_get(j*2+1,i))/2);
+                        else
+                        {
+                            float ratio = float(img.size().x()) / lp2;
+                            float offset = 0.5f*(float(lp2) - (ratio*(lp2-1)));
+                            res.set(j,i, img.getLinear(vec2(ratio*j+offset, float(i))));
+                        }
                     }
-                }
+                });
                 return res;
             }
 
-            static ImageAlgorithm<T> reduceY(const ImageAlgorithm<T>& img, uint minY)
+            static ImageAlgorithm<T> reduceY(const ImageAlgorithm<T>& img, uint minY, ThreadPool* pool)
             {
                 uint lp2 = l_power2(img.size().y());
                 if(lp2 < minY) lp2 = minY;
                 bool times2 = (lp2 == (img.size().y()>>1));
 
                 ImageAlgorithm res({lp2, img.size().x()});
-                for(uint i=0 ; i<img.size().x() ; ++i)
-                    for(uint j=0 ; j<lp2 ; ++j)
+                forEachColumn(img.size().x(), pool, [&](uint i)
                 {
-                    if(times2)
-                        res.set(i,j, (img.clamp_get(i,j*2)+img.clamp_get(i,j*2+1))/2);
-                    else
+                    for(uint j=0 ; j<lp2 ; ++j)
                     {
-                        float ratio = float(img.size().y()) / lp2;
-                        float offset = 0.5f*(float(lp2) - (ratio*(lp2-1)));
-                        res.set(i,j, img.getLinear(vec2(float(i), ratio*j+offset)));
+                        if(times2)
+                            res.set(i,j, (img.clamp_get(i,j*2)+img.clamp_get(i,j*2+1))/2);
+                        else
+                        {
+                            float ratio = float(img.size().y()) / lp2;
+                            float offset = 0.5f*(float(lp2) - (ratio*(lp2-1)));
+                            res.set(i,j, img.getLinear(vec2(float(i), ratio*j+offset)));
+                        }
                     }
-                }
+                });
                 return res;
             }
         };
@@ -351,10 +467,10 @@ namespace core
         while(true)
         {
             if((res.empty() && _size.x() > s.x()) || res.size().x() > s.x())
-                res = Foo::reduceX(res.empty() ? *this : res, s.x());
+                res = Foo::reduceX(res.empty() ? *this : res, s.x(), pool);
 
             if((res.empty() && _size.y() > s.y()) || res.size().y() > s.y())
-                res = Foo::reduceY(res.empty() ? *this : res, s.y());
+                res = Foo::reduceY(res.empty() ? *this : res, s.y(), pool);
 
             if(!res.empty() && res.size().x() <= s.x() && res.size().y() <= s.y())
                 break;
@@ -363,7 +479,7 @@ namespace core
     }
 
     template <class T>
-    ImageAlgorithm<T> ImageAlgorithm<T>::transformed(const imat2& m) const
+    ImageAlgorithm<T> ImageAlgorithm<T>::transformed(const imat2& m, ThreadPool* pool) const
     {
         if(empty()) return *this;
 
@@ -374,20 +490,25 @@ namespace core
 
         ImageAlgorithm img(uivec2(uint(s.x()), uint(s.y())));
 
-        for(size_t i=0 ; i<_size.x() ; ++i)
-            for(size_t j=0 ; j<_size.y() ; ++j)
+        auto column = [&](uint i)
         {
-            ivec2 coord = m*ivec2(i,j);
-            if(coord.x() < 0) coord.x() += s.x();
-            if(coord.y() < 0) coord.y() += s.y();
+            for(uint j=0 ; j<_size.y() ; ++j)
+            {
+                ivec2 coord = m*ivec2(i,j);
+                if(coord.x() < 0) coord.x() += s.x();
+                if(coord.y() < 0) coord.y() += s.y();
 
-            img.set(coord.x(), coord.y(), get(i,j));
-        }
+                img.set(coord.x(), coord.y(), get(i,j));
+            }
+        };
+
+        // two pixels can only land on the same destination if m is not invertible
+        const int det = m.get(0)*m.get(3) - m.get(1)*m.get(2);
+        forEachColumn(_size.x(), det != 0 ? pool : nullptr, column);
 
         return img;
     }
 
-#include "StringUtils.h"
     template <class T>
     std::string ImageAlgorithm<T>::str() const
     {
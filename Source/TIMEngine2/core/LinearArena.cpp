@@ -0,0 +1,155 @@
+#include "LinearArena.h"
+
+#include <atomic>
+#include <mutex>
+#include <new>
+
+#include "MemoryLoggerOn.h"
+namespace tim
+{
+namespace core
+{
+
+/* LinearArena */
+
+LinearArena::LinearArena(size_t initialSize)
+{
+    newBlock(initialSize);
+}
+
+LinearArena::~LinearArena()
+{
+    freeBlocks();
+}
+
+void LinearArena::newBlock(size_t size)
+{
+    const size_t header = (sizeof(Block) + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+
+#include "MemoryLoggerOff.h"
+    Block* block = static_cast<Block*>(::operator new(header + size));
+#include "MemoryLoggerOn.h"
+    block->next = _blocks;
+    block->size = size;
+    _blocks = block;
+
+    _cur = reinterpret_cast<char*>(block) + header;
+    _end = _cur + size;
+    _capacity += size;
+}
+
+void LinearArena::freeBlocks()
+{
+    while(_blocks)
+    {
+        Block* next = _blocks->next;
+        ::operator delete(_blocks);
+        _blocks = next;
+    }
+    _cur = _end = nullptr;
+    _capacity = 0;
+}
+
+void* LinearArena::alloc(size_t size, size_t align)
+{
+    TIM_ASSERT(isPowerOf2(align));
+
+    char* ptr = reinterpret_cast<char*>((reinterpret_cast<uintptr_t>(_cur) + align - 1) & ~(uintptr_t(align) - 1));
+    if(ptr + size > _end)
+    {
+        newBlock(std::max(_capacity, size + align));
+        ptr = reinterpret_cast<char*>((reinterpret_cast<uintptr_t>(_cur) + align - 1) & ~(uintptr_t(align) - 1));
+    }
+
+    _used += (ptr + size) - _cur;
+    _cur = ptr + size;
+    _peak = std::max(_peak, _used);
+    return ptr;
+}
+
+void LinearArena::reset()
+{
+    if(_blocks && _blocks->next)
+    {
+        // the last frame overflowed, merge everything in one block
+        const size_t total = _capacity;
+        freeBlocks();
+        newBlock(total);
+    }
+    else if(_blocks)
+    {
+        _cur = _end - _blocks->size;
+    }
+    _used = 0;
+}
+
+/* FrameArena */
+
+namespace
+{
+    std::atomic<size_t> s_frameArenaId = 0;
+
+    struct LocalArenaCache
+    {
+        size_t owner = size_t(-1);
+        LinearArena* arena = nullptr;
+    };
+
+    thread_local LocalArenaCache t_localArena;
+}
+
+FrameArena::FrameArena(size_t initialSize) : _id(s_frameArenaId.fetch_add(1)), _initialSize(initialSize) {}
+
+LinearArena& FrameArena::local()
+{
+    if(t_localArena.owner == _id)
+        return *t_localArena.arena;
+
+    const std::thread::id threadId = std::this_thread::get_id();
+
+    std::lock_guard<SpinLock> guard(_lock);
+    LinearArena* arena = nullptr;
+    for(auto& a : _arenas)
+    {
+        if(a.first == threadId)
+            arena = a.second.get();
+    }
+
+    if(!arena)
+    {
+        _arenas.emplace_back(threadId, std::make_unique<LinearArena>(_initialSize));
+        arena = _arenas.back().second.get();
+    }
+
+    t_localArena = { _id, arena };
+    return *arena;
+}
+
+void FrameArena::reset()
+{
+    std::lock_guard<SpinLock> guard(_lock);
+    for(auto& a : _arenas)
+        a.second->reset();
+}
+
+size_t FrameArena::used() const
+{
+    std::lock_guard<SpinLock> guard(_lock);
+    size_t total = 0;
+    for(const auto& a : _arenas)
+        total += a.second->used();
+    return total;
+}
+
+size_t FrameArena::peak() const
+{
+    std::lock_guard<SpinLock> guard(_lock);
+    size_t total = 0;
+    for(const auto& a : _arenas)
+        total += a.second->peak();
+    return total;
+}
+
+}
+}
+#include "MemoryLoggerOff.h"
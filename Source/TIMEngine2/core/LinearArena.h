@@ -0,0 +1,133 @@
+#ifndef LINEARARENA_H_INCLUDED
+#define LINEARARENA_H_INCLUDED
+
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <thread>
+#include <type_traits>
+#include "Common.h"
+#include "NonCopyable.h"
+#include "SpinLock.h"
+#include "type.h"
+
+#include "MemoryLoggerOn.h"
+namespace tim
+{
+namespace core
+{
+    /* Bump allocator: alloc moves a pointer, nothing is freed until reset().
+     * When a frame overflows the first block, reset() merges the blocks so the next frames fit in one. */
+    class LinearArena : NonCopyable
+    {
+    public:
+        LinearArena(size_t initialSize = 1 << 16);
+        ~LinearArena();
+
+        void* alloc(size_t size, size_t align = alignof(std::max_align_t));
+
+        /* Default constructed array, its destructors are never called */
+        template<class T>
+        std::span<T> allocArray(size_t n)
+        {
+            T* ptr = static_cast<T*>(alloc(n * sizeof(T), alignof(T)));
+            std::uninitialized_default_construct_n(ptr, n);
+            return std::span<T>(ptr, n);
+        }
+
+        void reset();
+
+        size_t used() const { return _used; }
+        size_t capacity() const { return _capacity; }
+        size_t peak() const { return _peak; }
+
+    private:
+        struct Block
+        {
+            Block* next;
+            size_t size;
+        };
+
+        Block* _blocks = nullptr; // last allocated first
+        char* _cur = nullptr;
+        char* _end = nullptr;
+        size_t _used = 0, _capacity = 0, _peak = 0;
+
+        void newBlock(size_t);
+        void freeBlocks();
+    };
+
+    /* STL allocator on a LinearArena, deallocate does nothing. A default constructed allocator uses the heap. */
+    template <class T>
+    class ArenaAllocator
+    {
+    public:
+        using value_type = T;
+        using propagate_on_container_copy_assignment = std::true_type;
+        using propagate_on_container_move_assignment = std::true_type;
+        using propagate_on_container_swap = std::true_type;
+
+        ArenaAllocator() noexcept = default;
+        ArenaAllocator(LinearArena& arena) noexcept : _arena(&arena) {}
+
+        template <class U>
+        ArenaAllocator(const ArenaAllocator<U>& a) noexcept : _arena(a.arena()) {}
+
+        T* allocate(size_t n)
+        {
+            if(_arena) return static_cast<T*>(_arena->alloc(n * sizeof(T), alignof(T)));
+            else return std::allocator<T>().allocate(n);
+        }
+
+        void deallocate(T* ptr, size_t n) noexcept
+        {
+            if(!_arena) std::allocator<T>().deallocate(ptr, n);
+        }
+
+        LinearArena* arena() const { return _arena; }
+
+        template <class U>
+        bool operator==(const ArenaAllocator<U>& a) const { return _arena == a.arena(); }
+
+    private:
+        LinearArena* _arena = nullptr;
+    };
+
+    /* The memory is lost at the next reset of the arena: when such a vector is kept as a member,
+     * reassign it with a fresh allocator each frame and only store trivially destructible types. */
+    template <class T> using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+    /* One LinearArena per thread, all reset together */
+    class FrameArena : NonCopyable
+    {
+    public:
+        FrameArena(size_t initialSize = 1 << 16);
+
+        /* Arena of the calling thread */
+        LinearArena& local();
+
+        template <class T>
+        ArenaVector<T> makeVector(size_t reserve = 0)
+        {
+            ArenaVector<T> v{ArenaAllocator<T>(local())};
+            v.reserve(reserve);
+            return v;
+        }
+
+        /* No thread must be using the arenas */
+        void reset();
+
+        size_t used() const;
+        size_t peak() const;
+
+    private:
+        const size_t _id;
+        const size_t _initialSize;
+        mutable SpinLock _lock;
+        core::vector<std::pair<std::thread::id, std::unique_ptr<LinearArena>>> _arenas;
+    };
+}
+}
+#include "MemoryLoggerOff.h"
+
+#endif // LINEARARENA_H_INCLUDED
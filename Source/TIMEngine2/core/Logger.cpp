@@ -0,0 +1,156 @@
+#include "Logger.h"
+#include <cstring>
+
+#include "MemoryLoggerOn.h"
+namespace tim
+{
+namespace core
+{
+
+Logger::Logger(const std::string& name) : _file(name, std::ios_base::out | std::ios_base::trunc)
+{
+    TIM_ASSERT(_file.is_open());
+    static_assert((QUEUE_SIZE & (QUEUE_SIZE-1)) == 0, "Logger::QUEUE_SIZE must be a power of 2.");
+
+    // the logger outlives the MemoryLogger, its ring is not tracked
+#include "MemoryLoggerOff.h"
+    _ring = new Record[QUEUE_SIZE];
+#include "MemoryLoggerOn.h"
+    for(size_t i=0 ; i<QUEUE_SIZE ; ++i)
+        _ring[i].seq.store(i, std::memory_order_relaxed);
+
+    _batch.reserve(RECORD_SIZE * QUEUE_SIZE);
+
+    _running = true;
+    _thread = std::thread([this]() { run(); });
+}
+
+Logger::~Logger()
+{
+    stop();
+    delete[] _ring;
+}
+
+std::ostringstream& Logger::formatStream()
+{
+    // rewind instead of str("") to keep the buffer allocated between records
+    static thread_local std::ostringstream stream;
+    stream.seekp(0);
+    return stream;
+}
+
+void Logger::submit(LogLevel level, std::string_view text)
+{
+    if(!push(text))
+    {
+        _dropped.fetch_add(1, std::memory_order_relaxed);
+        _totalDropped.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    if(!_running.load(std::memory_order_acquire))
+        flush();
+    else if(level >= LogLevel::Warning)
+        _wakeUp.notify_one();
+}
+
+bool Logger::push(std::string_view text)
+{
+    const size_t nbSlot = std::min((text.size() + RECORD_SIZE - 1) / RECORD_SIZE, MAX_SLOT_PER_RECORD);
+    if(nbSlot == 0)
+        return true;
+    const bool truncated = nbSlot * RECORD_SIZE < text.size();
+
+    // claim nbSlot contiguous slots, the consumer release them in order so checking the last one is enough
+    size_t pos = _enqueuePos.load(std::memory_order_relaxed);
+    while(true)
+    {
+        const size_t last = pos + nbSlot - 1;
+        const size_t seq = _ring[last & (QUEUE_SIZE-1)].seq.load(std::memory_order_acquire);
+        const std::ptrdiff_t diff = std::ptrdiff_t(seq) - std::ptrdiff_t(last);
+
+        if(diff == 0)
+        {
+            if(_enqueuePos.compare_exchange_weak(pos, pos + nbSlot, std::memory_order_relaxed))
+                break;
+        }
+        else if(diff < 0)
+            return false; // full
+        else
+            pos = _enqueuePos.load(std::memory_order_relaxed);
+    }
+
+    for(size_t i=0 ; i<nbSlot ; ++i)
+    {
+        Record& r = _ring[(pos+i) & (QUEUE_SIZE-1)];
+        r.size = uint(std::min(RECORD_SIZE, text.size() - i*RECORD_SIZE));
+        std::memcpy(r.text, text.data() + i*RECORD_SIZE, r.size);
+        if(truncated && i == nbSlot-1)
+            r.text[r.size-1] = '\n'; // the next record starts on its own line
+        r.seq.store(pos+i+1, std::memory_order_release);
+    }
+
+    // wake the writer each time a quarter of the ring is filled, don't wait the timeout
+    const size_t quarter = QUEUE_SIZE / 4;
+    if(pos / quarter != (pos + nbSlot) / quarter)
+        _wakeUp.notify_one();
+
+    return true;
+}
+
+bool Logger::drain()
+{
+    std::lock_guard<std::mutex> guard(_drainMutex);
+
+    _batch.clear();
+    for(size_t n=0 ; n<QUEUE_SIZE ; ++n)
+    {
+        Record& r = _ring[_dequeuePos & (QUEUE_SIZE-1)];
+        if(r.seq.load(std::memory_order_acquire) != _dequeuePos+1)
+            break;
+
+        _batch.append(r.text, r.size);
+        r.seq.store(_dequeuePos + QUEUE_SIZE, std::memory_order_release);
+        ++_dequeuePos;
+    }
+
+    size_t dropped = _dropped.exchange(0, std::memory_order_relaxed);
+    if(dropped > 0)
+        _batch += "[Logger] " + std::to_string(dropped) + " records dropped, queue full\n";
+
+    if(_batch.empty())
+        return false;
+
+    _file.write(_batch.data(), _batch.size());
+    _file.flush();
+    return true;
+}
+
+void Logger::flush()
+{
+    drain();
+}
+
+void Logger::stop()
+{
+    if(_running.exchange(false))
+    {
+        _wakeUp.notify_one();
+        _thread.join();
+    }
+    drain();
+}
+
+void Logger::run()
+{
+    while(_running.load(std::memory_order_acquire))
+    {
+        if(!drain())
+        {
+            std::unique_lock<std::mutex> lock(_wakeMutex);
+            _wakeUp.wait_for(lock, std::chrono::milliseconds(20));
+        }
+    }
+}
+
+}
+}
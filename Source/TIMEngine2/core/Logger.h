@@ -2,82 +2,155 @@
 #define LOGGER_H_INCLUDED
 
 #include <fstream>
+#include <sstream>
 #include <string>
+#include <string_view>
 #include <mutex>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
 #include "Common.h"
 #include "Exception.h"
 #include "Singleton.h"
 
+/* Compile time filtering: every record below TIM_LOG_MIN_LEVEL is removed by the preprocessor.
+ * 0:Debug 1:Info 2:Warning 3:Error */
+#ifndef TIM_LOG_MIN_LEVEL
+    #ifdef TIM_DEBUG
+        #define TIM_LOG_MIN_LEVEL 0
+    #else
+        #define TIM_LOG_MIN_LEVEL 1
+    #endif
+#endif
+
 namespace tim
 {
 namespace core
 {
+    enum class LogLevel : int { Debug = 0, Info, Warning, Error };
+
+    /* Asynchronous logger: producers format on their own thread and push the text in a bounded
+     * lock-free MPSC ring, a background thread drains the ring and writes batches in the file.
+     * When the ring is full the record is dropped and counted, the number of dropped records is
+     * written in the file as soon as possible. */
     class Logger : Singleton<Logger>
     {
         friend class Singleton<Logger>;
 
     public:
-        Logger(const std::string& name = "Log.txt") : _file(name, std::ios_base::out | std::ios_base::trunc)
-        {
-            TIM_ASSERT(_file.is_open());
-        }
+        static constexpr size_t RECORD_SIZE = 256; // bytes per slot, a record can span several slots
+        static constexpr size_t QUEUE_SIZE = 1024; // number of slots, must be a power of 2
+        static constexpr size_t MAX_SLOT_PER_RECORD = QUEUE_SIZE / 4; // longer records are truncated
 
-        ~Logger() = default;
+        Logger(const std::string& name = "Log.txt");
+        ~Logger();
 
         template< class...Args >
-        void log(Args... args)
+        void write(LogLevel level, const char* file, int line, bool endl, bool withLocation, const Args&... args)
         {
-            inner_log(args...);
-            if(_endl_mode) _file << std::endl;
-            _mutex.unlock();
-        }
+            if(!accept(level))
+                return;
 
-        template< class...Args >
-        void log2(Args... args)
-        {
-            _file << _src_file << "(" << _line << "): ";
-            inner_log(args...);
-            if(_endl_mode) _file << std::endl;
-            _mutex.unlock();
-        }
+            std::ostringstream& stream = formatStream();
+            if(level == LogLevel::Warning) stream << "[warning] ";
+            else if(level == LogLevel::Error) stream << "[error] ";
 
-        Logger& setEndlMode(bool b) { _endl_mode = b; return *this; }
-        Logger& setLoggerInfo(const char* str, int line)
-        {
-            _mutex.lock();
-            _src_file = str;
-            _line = line;
-            return *this;
+            if(withLocation) stream << file << "(" << line << "): ";
+            (stream << ... << args);
+            if(endl) stream << '\n';
+
+            submit(level, std::string_view(stream.view().data(), size_t(stream.tellp())));
         }
 
-    private:
-            std::ofstream _file;
-            bool _endl_mode = true;
-            std::string _src_file;
-            int _line = 0;
-            std::mutex _mutex;
+        bool accept(LogLevel level) const { return int(level) >= _minLevel.load(std::memory_order_relaxed); }
+        void setMinLevel(LogLevel level) { _minLevel.store(int(level), std::memory_order_relaxed); }
+        LogLevel minLevel() const { return LogLevel(_minLevel.load(std::memory_order_relaxed)); }
 
-            template< class Arg , class...Args >
-            void inner_log(Arg a, Args... as)
-            {
-                _file << a;
-                inner_log(as...);
-            }
+        size_t droppedCount() const { return _totalDropped.load(std::memory_order_relaxed); }
 
+        /* Write every published record in the file from the calling thread, safe to call on crash */
+        void flush();
 
-            void inner_log(){}
+        /* Join the writer thread, next records are written synchronously */
+        void stop();
+
+    private:
+        struct Record
+        {
+            std::atomic<size_t> seq;
+            uint size;
+            char text[RECORD_SIZE];
+        };
+
+        Record* _ring;
+        alignas(64) std::atomic<size_t> _enqueuePos = 0;
+        alignas(64) size_t _dequeuePos = 0;
+        std::atomic<size_t> _dropped = 0;
+        std::atomic<size_t> _totalDropped = 0;
+        std::atomic<int> _minLevel = TIM_LOG_MIN_LEVEL;
+
+        std::ofstream _file;
+        std::string _batch;
+        std::mutex _drainMutex;
+
+        std::thread _thread;
+        std::atomic<bool> _running = false;
+        std::mutex _wakeMutex;
+        std::condition_variable _wakeUp;
+
+        static std::ostringstream& formatStream();
+
+        void submit(LogLevel, std::string_view);
+        bool push(std::string_view);
+        bool drain();
+        void run();
     };
 
     static Logger& logger = Singleton<Logger>::instance();
 
-    #define LOG tim::core::logger.setLoggerInfo(__FILE__,__LINE__).setEndlMode(true).log
-    #define LOG_EXT tim::core::logger.setLoggerInfo(__FILE__,__LINE__).setEndlMode(true).log2
-    #define LOG_L tim::core::logger.setLoggerInfo(__FILE__,__LINE__).setEndlMode(false).log
+    /* Build by the LOG macros, hold the call site until the arguments are known */
+    class LogRecord
+    {
+    public:
+        LogRecord(LogLevel level, const char* file, int line) : _file(file), _line(line), _level(level) {}
+
+        LogRecord& setEndlMode(bool b) { _endl_mode = b; return *this; }
+
+        template< class...Args >
+        void log(const Args&... args) const { logger.write(_level, _file, _line, _endl_mode, false, args...); }
+
+        template< class...Args >
+        void log2(const Args&... args) const { logger.write(_level, _file, _line, _endl_mode, true, args...); }
+
+    private:
+        const char* _file;
+        int _line;
+        LogLevel _level;
+        bool _endl_mode = true;
+    };
+
+#if TIM_LOG_MIN_LEVEL <= 1
+    #define LOG tim::core::LogRecord(tim::core::LogLevel::Info,__FILE__,__LINE__).setEndlMode(true).log
+    #define LOG_EXT tim::core::LogRecord(tim::core::LogLevel::Info,__FILE__,__LINE__).setEndlMode(true).log2
+    #define LOG_L tim::core::LogRecord(tim::core::LogLevel::Info,__FILE__,__LINE__).setEndlMode(false).log
+#else
+    #define LOG(...)
+    #define LOG_EXT(...)
+    #define LOG_L(...)
+#endif
+
+#if TIM_LOG_MIN_LEVEL <= 2
+    #define LOG_WARN tim::core::LogRecord(tim::core::LogLevel::Warning,__FILE__,__LINE__).setEndlMode(true).log2
+#else
+    #define LOG_WARN(...)
+#endif
+
+    #define LOG_ERROR tim::core::LogRecord(tim::core::LogLevel::Error,__FILE__,__LINE__).setEndlMode(true).log2
 
-#ifdef TIM_DEBUG
-    #define DLOG tim::core::logger.setLoggerInfo(__FILE__,__LINE__).setEndlMode(true).log
-    #define DLOG_EXT tim::core::logger.setLoggerInfo(__FILE__,__LINE__).setEndlMode(true).log2
-    #define DLOG_L tim::core::logger.setLoggerInfo(__FILE__,__LINE__).setEndlMode(false).log
+#if TIM_LOG_MIN_LEVEL <= 0
+    #define DLOG tim::core::LogRecord(tim::core::LogLevel::Debug,__FILE__,__LINE__).setEndlMode(true).log
+    #define DLOG_EXT tim::core::LogRecord(tim::core::LogLevel::Debug,__FILE__,__LINE__).setEndlMode(true).log2
+    #define DLOG_L tim::core::LogRecord(tim::core::LogLevel::Debug,__FILE__,__LINE__).setEndlMode(false).log
 #else
     #define DLOG(...)
     #define DLOG_EXT(...)
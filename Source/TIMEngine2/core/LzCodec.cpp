@@ -0,0 +1,157 @@
+#include "LzCodec.h"
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+
+#include "MemoryLoggerOn.h"
+namespace tim
+{
+namespace core
+{
+
+namespace
+{
+    const size_t MIN_MATCH = 4;
+    const size_t MAX_OFFSET = 65535;
+    const size_t END_LITERALS = 5; // the last bytes are always literals, a match can't reach the end
+    const uint HASH_BITS = 14;
+
+    uint32_t read32(const char* p)
+    {
+        uint32_t v;
+        memcpy(&v, p, 4);
+        return v;
+    }
+
+    uint hash4(uint32_t v)
+    {
+        return (v * 2654435761u) >> (32 - HASH_BITS);
+    }
+
+    /* 15 in the token then bytes of 255 and the rest */
+    void writeLength(vector<char>& out, size_t len)
+    {
+        for( ; len >= 255 ; len -= 255)
+            out.push_back(char(255));
+        out.push_back(char(len));
+    }
+
+    bool readLength(const unsigned char*& ip, const unsigned char* end, size_t& len)
+    {
+        unsigned char b;
+        do
+        {
+            if(ip >= end) return false;
+            b = *ip++;
+            len += b;
+        } while(b == 255);
+        return true;
+    }
+
+    void writeSequence(vector<char>& out, const char* literals, size_t nbLiteral, size_t offset, size_t matchLength)
+    {
+        const size_t m = matchLength > 0 ? matchLength - MIN_MATCH : 0;
+        out.push_back(char((std::min<size_t>(nbLiteral, 15) << 4) | std::min<size_t>(m, 15)));
+
+        if(nbLiteral >= 15) writeLength(out, nbLiteral - 15);
+        out.insert(out.end(), literals, literals + nbLiteral);
+
+        if(matchLength == 0)
+            return;
+
+        out.push_back(char(offset & 0xFF));
+        out.push_back(char(offset >> 8));
+        if(m >= 15) writeLength(out, m - 15);
+    }
+}
+
+void lzCompress(const char* src, size_t size, vector<char>& out)
+{
+    vector<uint32_t> table(size_t(1) << HASH_BITS, UINT32_MAX);
+
+    size_t anchor = 0, i = 0;
+    const size_t matchLimit = size > END_LITERALS ? size - END_LITERALS : 0;
+
+    while(i + MIN_MATCH + END_LITERALS < size)
+    {
+        const uint32_t seq = read32(src + i);
+        const uint h = hash4(seq);
+        const size_t ref = table[h];
+        table[h] = uint32_t(i);
+
+        if(ref == UINT32_MAX || i - ref > MAX_OFFSET || read32(src + ref) != seq)
+        {
+            // skip faster in data that doesn't compress
+            i += 1 + ((i - anchor) >> 6);
+            continue;
+        }
+
+        size_t len = MIN_MATCH;
+        while(i + len < matchLimit && src[ref + len] == src[i + len])
+            ++len;
+
+        size_t start = i, from = ref;
+        while(start > anchor && from > 0 && src[start - 1] == src[from - 1])
+        {
+            --start; --from; ++len;
+        }
+
+        writeSequence(out, src + anchor, start - anchor, start - from, len);
+        i = anchor = start + len;
+    }
+
+    writeSequence(out, src + anchor, size - anchor, 0, 0);
+}
+
+bool lzDecompress(const char* src, size_t srcSize, char* dst, size_t dstSize)
+{
+    const unsigned char* ip = reinterpret_cast<const unsigned char*>(src);
+    const unsigned char* end = ip + srcSize;
+    char* op = dst;
+    char* const opEnd = dst + dstSize;
+
+    while(ip < end)
+    {
+        const unsigned char token = *ip++;
+
+        size_t nbLiteral = token >> 4;
+        if(nbLiteral == 15 && !readLength(ip, end, nbLiteral))
+            return false;
+        if(nbLiteral > size_t(end - ip) || nbLiteral > size_t(opEnd - op))
+            return false;
+
+        memcpy(op, ip, nbLiteral);
+        ip += nbLiteral;
+        op += nbLiteral;
+
+        // the last sequence has no match
+        if(ip == end)
+            break;
+
+        if(end - ip < 2)
+            return false;
+        const size_t offset = ip[0] | (size_t(ip[1]) << 8);
+        ip += 2;
+        if(offset == 0 || offset > size_t(op - dst))
+            return false;
+
+        size_t len = token & 15;
+        if(len == 15 && !readLength(ip, end, len))
+            return false;
+        len += MIN_MATCH;
+        if(len > size_t(opEnd - op))
+            return false;
+
+        // byte by byte, the match can overlap what it writes
+        const char* match = op - offset;
+        for(size_t k=0 ; k<len ; ++k)
+            op[k] = match[k];
+        op += len;
+    }
+
+    return op == opEnd;
+}
+
+}
+}
+#include "MemoryLoggerOff.h"
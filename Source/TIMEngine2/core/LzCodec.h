@@ -0,0 +1,24 @@
+#ifndef LZCODEC_H_INCLUDED
+#define LZCODEC_H_INCLUDED
+
+#include <cstddef>
+#include "type.h"
+
+#include "MemoryLoggerOn.h"
+namespace tim
+{
+namespace core
+{
+    /* Byte oriented LZ77 (sequences of literals and matches in a 64KB window, as the LZ4 block format),
+     * fast to decode and good on text (.obj, .xml, shaders), useless on already compressed data (.png, .ogg). */
+
+    /* Append the compressed data to out */
+    void lzCompress(const char* src, size_t size, vector<char>& out);
+
+    /* dst must have the exact decompressed size, return false if the data is corrupted */
+    bool lzDecompress(const char* src, size_t srcSize, char* dst, size_t dstSize);
+}
+}
+#include "MemoryLoggerOff.h"
+
+#endif // LZCODEC_H_INCLUDED
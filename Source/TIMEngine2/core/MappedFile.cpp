@@ -0,0 +1,130 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#include "MemoryLoggerOn.h"
+namespace tim
+{
+namespace core
+{
+
+namespace
+{
+    // the view of the empty files, nothing is mapped
+    const char emptyView[1] = {0};
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::string& file)
+{
+    close();
+
+    HANDLE f = CreateFileA(file.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if(f == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER size;
+    if(!GetFileSizeEx(f, &size) || uint64_t(size.QuadPart) > SIZE_MAX)
+    {
+        CloseHandle(f);
+        return false;
+    }
+
+    // a mapping of 0 bytes can't be created
+    if(size.QuadPart == 0)
+    {
+        CloseHandle(f);
+        _data = emptyView;
+        return true;
+    }
+
+    HANDLE mapping = CreateFileMappingA(f, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if(!mapping)
+    {
+        CloseHandle(f);
+        return false;
+    }
+
+    const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if(!view)
+    {
+        CloseHandle(mapping);
+        CloseHandle(f);
+        return false;
+    }
+
+    _file = f;
+    _mapping = mapping;
+    _data = static_cast<const char*>(view);
+    _size = size_t(size.QuadPart);
+    return true;
+}
+
+void MappedFile::close()
+{
+    if(_data && _data != emptyView) UnmapViewOfFile(_data);
+    if(_mapping) CloseHandle(_mapping);
+    if(_file) CloseHandle(_file);
+
+    _data = nullptr;
+    _mapping = _file = nullptr;
+    _size = 0;
+}
+
+#else
+
+bool MappedFile::open(const std::string& file)
+{
+    close();
+
+    int fd = ::open(file.c_str(), O_RDONLY);
+    if(fd < 0)
+        return false;
+
+    struct stat st;
+    if(fstat(fd, &st) != 0)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    // mmap fails on 0 bytes
+    if(st.st_size == 0)
+    {
+        ::close(fd);
+        _data = emptyView;
+        return true;
+    }
+
+    void* view = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // the mapping keeps its own reference
+    if(view == MAP_FAILED)
+        return false;
+
+    _data = static_cast<const char*>(view);
+    _size = size_t(st.st_size);
+    return true;
+}
+
+void MappedFile::close()
+{
+    if(_data && _data != emptyView)
+        munmap(const_cast<char*>(_data), _size);
+
+    _data = nullptr;
+    _size = 0;
+}
+
+#endif
+
+}
+}
+#include "MemoryLoggerOff.h"
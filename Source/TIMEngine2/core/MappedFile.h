@@ -0,0 +1,42 @@
+#ifndef MAPPEDFILE_H_INCLUDED
+#define MAPPEDFILE_H_INCLUDED
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+#include "NonCopyable.h"
+
+#include "MemoryLoggerOn.h"
+namespace tim
+{
+namespace core
+{
+    /* Read only mapping of a whole file, the pages are loaded by the system on first access.
+     * The data stays valid until close() or the destruction. An empty file is open, with a non null view of size 0. */
+    class MappedFile : NonCopyable
+    {
+    public:
+        MappedFile() = default;
+        MappedFile(const std::string& file) { open(file); }
+        ~MappedFile() { close(); }
+
+        bool open(const std::string&);
+        void close();
+
+        bool isOpen() const { return _data != nullptr; }
+        const char* data() const { return _data; }
+        size_t size() const { return _size; }
+
+    private:
+        const char* _data = nullptr;
+        size_t _size = 0;
+#ifdef _WIN32
+        void* _file = nullptr;
+        void* _mapping = nullptr;
+#endif
+    };
+}
+}
+#include "MemoryLoggerOff.h"
+
+#endif // MAPPEDFILE_H_INCLUDED
@@ -2,127 +2,384 @@
 #include "MemoryLogger.h"
 #include "StringUtils.h"
 #include "Logger.h"
+#include "AllocCounter.h"
 #include "Exception.h"
 
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <algorithm>
+
 using namespace tim::core;
 
-MemoryLogger* MemoryLogger::_instance = nullptr;
+std::atomic<MemoryLogger*> MemoryLogger::_instance = nullptr;
+
+namespace
+{
+    void* const TOMBSTONE = reinterpret_cast<void*>(1);
+
+    inline uint64_t hashPtr(const void* ptr)
+    {
+        uint64_t h = uint64_t(reinterpret_cast<uintptr_t>(ptr)) >> 4;
+        h *= 0x9E3779B97F4A7C15ull;
+        return h ^ (h >> 29);
+    }
+}
 
 MemoryLogger& MemoryLogger::instance()
 {
-    if(!_instance)
-        _instance = new MemoryLogger;
-    return *_instance;
+    MemoryLogger* inst = _instance.load(std::memory_order_acquire);
+    if(!inst)
+    {
+        static std::mutex instanceMutex;
+        std::lock_guard<std::mutex> guard(instanceMutex);
+        inst = _instance.load(std::memory_order_relaxed);
+        if(!inst)
+        {
+            inst = new MemoryLogger;
+            _instance.store(inst, std::memory_order_release);
+        }
+    }
+    return *inst;
 }
 
 void MemoryLogger::freeInstance()
 {
-    _instance->~MemoryLogger();
-    free(_instance);
-    _instance=0;
+    MemoryLogger* inst = _instance.exchange(nullptr);
+    delete inst;
+}
+
+void MemoryLogger::release(void* ptr, bool isArray)
+{
+    if(MemoryLogger* inst = _instance.load(std::memory_order_acquire))
+        inst->dealloc(ptr, isArray);
+    else
+        free(ptr);
 }
 
 
-MemoryLogger::MemoryLogger(){ }
+MemoryLogger::MemoryLogger()
+{
+    static_assert((NB_SHARDS & (NB_SHARDS-1)) == 0, "MemoryLogger::NB_SHARDS must be a power of 2.");
+    static_assert((MAX_SITES & (MAX_SITES-1)) == 0, "MemoryLogger::MAX_SITES must be a power of 2.");
+
+    _sites = static_cast<Site*>(malloc(sizeof(Site) * MAX_SITES));
+    for(uint i=0 ; i<MAX_SITES ; ++i)
+        ::new (&_sites[i]) Site();
+
+    _sites[0].file = "<untracked site>";
+}
 
 MemoryLogger::~MemoryLogger()
 {
-    if(_allocatedMemorys.size() > 0) // some leaks
-    {
+    bool leaks = false;
+    for(uint i=0 ; i<NB_SHARDS ; ++i)
+        leaks |= _shards[i].count > 0;
+
+    if(leaks)
         printLeak();
+
+    for(uint i=0 ; i<NB_SHARDS ; ++i)
+        free(_shards[i].table);
+
+    for(uint i=0 ; i<MAX_SITES ; ++i)
+        _sites[i].~Site();
+    free(_sites);
+}
+
+/* Shard */
+
+void MemoryLogger::Shard::insert(const MemoryAlloc& a)
+{
+    if((count + tombstones + 1) * 4 > capacity * 3)
+        rehash(capacity == 0 ? 256 : (count * 2 >= capacity / 2 ? capacity * 2 : capacity));
+
+    uint index = uint(hashPtr(a.ptr)) & (capacity-1);
+    while(table[index].ptr != nullptr && table[index].ptr != TOMBSTONE)
+        index = (index+1) & (capacity-1);
+
+    if(table[index].ptr == TOMBSTONE)
+        --tombstones;
+
+    table[index] = a;
+    ++count;
+}
+
+MemoryLogger::MemoryAlloc* MemoryLogger::Shard::find(void* ptr) const
+{
+    if(capacity == 0)
+        return nullptr;
+
+    uint index = uint(hashPtr(ptr)) & (capacity-1);
+    while(table[index].ptr != nullptr)
+    {
+        if(table[index].ptr == ptr)
+            return &table[index];
+        index = (index+1) & (capacity-1);
     }
+    return nullptr;
 }
 
-void* MemoryLogger::alloc(size_t size, size_t line, const std::string& file, bool isArray)
+void MemoryLogger::Shard::erase(MemoryAlloc* a)
 {
-    void* ptr = malloc(size);
+    a->ptr = TOMBSTONE;
+    --count;
+    ++tombstones;
+}
 
-    std::lock_guard guard(_mutex);
-    _allocatedMemorys[ptr] = {ptr, size, line, file, isArray};
+void MemoryLogger::Shard::rehash(uint newCapacity)
+{
+    MemoryAlloc* oldTable = table;
+    uint oldCapacity = capacity;
+
+    table = static_cast<MemoryAlloc*>(malloc(sizeof(MemoryAlloc) * newCapacity));
+    memset(table, 0, sizeof(MemoryAlloc) * newCapacity);
+    capacity = newCapacity;
+    count = 0;
+    tombstones = 0;
 
-    return (void*)ptr;
+    for(uint i=0 ; i<oldCapacity ; ++i)
+    {
+        if(oldTable[i].ptr != nullptr && oldTable[i].ptr != TOMBSTONE)
+            insert(oldTable[i]);
+    }
+    free(oldTable);
 }
 
-void MemoryLogger::dealloc(void* ptr, bool isArray)
+MemoryLogger::Shard& MemoryLogger::shard(void* ptr) const
+{
+    return const_cast<Shard&>(_shards[(hashPtr(ptr) >> 58) & (NB_SHARDS-1)]);
+}
+
+/* Sites */
+
+uint MemoryLogger::siteId(const char* file, size_t line)
 {
-    std::lock_guard guard(_mutex);
-    auto it = _allocatedMemorys.find(ptr);
-    if(it != _allocatedMemorys.end())
+    // __FILE__ are literals, the pointer is enough to identify the file
+    const uint64_t h = hashPtr(file) ^ (uint64_t(line) * 0xC2B2AE3D27D4EB4Full);
+
+    for(uint i=0 ; i<MAX_SITES ; ++i)
     {
-        if(it->second.isArray != isArray)
+        const uint index = uint(h + i) & (MAX_SITES-1);
+        if(index == 0)
+            continue;
+
+        Site& site = _sites[index];
+        const char* f = site.file.load(std::memory_order_acquire);
+        if(f == nullptr)
         {
-            if(isArray)
+            std::lock_guard<std::mutex> guard(_siteMutex);
+            f = site.file.load(std::memory_order_relaxed);
+            if(f == nullptr)
             {
-                DLOG("BadDealloc, use delete instead of delete[] at line " +
-                                 StringUtils(_lastDeallocLine).str() + " in " + _lastDeallocFile + "\n");
-                TIM_ASSERT(false);
-            }
-            else
-            {
-                DLOG("BadDealloc, use delete[] instead of delete at line " +
-                                 StringUtils(_lastDeallocLine).str() + " in " + _lastDeallocFile + "\n");
-                TIM_ASSERT(false);
+                site.line = line;
+                site.file.store(file, std::memory_order_release);
+                return index;
             }
         }
-        else
+
+        if(f == file && site.line == line)
+            return index;
+    }
+
+    return 0;
+}
+
+void MemoryLogger::onAlloc(Site& site, size_t size, uint weight)
+{
+    size *= weight;
+    site.count.fetch_add(weight, std::memory_order_relaxed);
+    site.totalBytes.fetch_add(size, std::memory_order_relaxed);
+    site.liveCount.fetch_add(weight, std::memory_order_relaxed);
+
+    const size_t live = site.liveBytes.fetch_add(size, std::memory_order_relaxed) + size;
+    size_t peak = site.peakBytes.load(std::memory_order_relaxed);
+    while(live > peak && !site.peakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed));
+}
+
+void MemoryLogger::onDealloc(Site& site, size_t size, uint weight)
+{
+    site.liveCount.fetch_sub(weight, std::memory_order_relaxed);
+    site.liveBytes.fetch_sub(size * weight, std::memory_order_relaxed);
+}
+
+/* Alloc */
+
+void* MemoryLogger::alloc(size_t size, size_t line, const char* file, bool isArray)
+{
+    AllocCounter::onAlloc(size);
+    void* ptr = malloc(size);
+
+    const uint rate = _samplingRate.load(std::memory_order_relaxed);
+    if(rate > 1)
+    {
+        static thread_local uint sampleCounter = 0;
+        if(++sampleCounter % rate != 0)
+            return ptr;
+    }
+
+    const uint site = siteId(file, line);
+    {
+        Shard& s = shard(ptr);
+        std::lock_guard<SpinLock> guard(s.lock);
+        s.insert({ptr, size, site, rate, isArray});
+    }
+    onAlloc(_sites[site], size, rate);
+
+    return ptr;
+}
+
+void MemoryLogger::dealloc(void* ptr, bool isArray)
+{
+    if(ptr == this)
+        return;
+
+    MemoryAlloc a;
+    bool badDealloc = false;
+    {
+        Shard& s = shard(ptr);
+        std::lock_guard<SpinLock> guard(s.lock);
+        MemoryAlloc* e = s.find(ptr);
+        if(!e)
         {
-            _allocatedMemorys.erase(it);
+            /** Untracked (sampled out or not allocated with the logger), never do another things than free(ptr) */
             free(ptr);
+            return;
         }
+
+        a = *e;
+        badDealloc = a.isArray != isArray;
+        if(!badDealloc)
+            s.erase(e);
     }
-    else if(ptr != this)
+
+    if(badDealloc)
     {
-        /** Critical zone, never do another things than free(ptr) */
-        free(ptr);
+        DLOG("BadDealloc, use ", isArray ? "delete instead of delete[]" : "delete[] instead of delete",
+             " at line ", _lastDeallocLine.load(), " in ", _lastDeallocFile.load(), "\n");
+        TIM_ASSERT(false);
+        return;
     }
+
+    onDealloc(_sites[a.site], a.size, a.weight);
+    free(ptr);
 }
 
-void MemoryLogger::nextDealloc(size_t line, const std::string& file)
+void MemoryLogger::nextDealloc(size_t line, const char* file)
 {
-    std::lock_guard guard(_mutex);
     _lastDeallocLine = line;
     _lastDeallocFile = file;
 }
 
+/* Report */
+
 void MemoryLogger::printLeak() const
 {
     DLOG("\nLeaks detected:\n");
 
-    std::lock_guard guard(_mutex);
-    for(auto it = _allocatedMemorys.begin() ; it != _allocatedMemorys.end() ; ++it)
+    for(uint i=0 ; i<NB_SHARDS ; ++i)
     {
-        DLOG("Leak of size " + StringUtils(it->second.size).str() + " in " +
-            it->second.file + " : " + StringUtils(it->second.line).str() + " (" +
-             StringUtils(it->second.ptr).str() + ")\n");
+        const Shard& s = _shards[i];
+        std::lock_guard<SpinLock> guard(s.lock);
+        for(uint j=0 ; j<s.capacity ; ++j)
+        {
+            const MemoryAlloc& a = s.table[j];
+            if(a.ptr == nullptr || a.ptr == TOMBSTONE)
+                continue;
+
+            DLOG("Leak of size ", a.size, " in ", _sites[a.site].file.load(), " : ", _sites[a.site].line,
+                 " (", a.ptr, ")\n");
+        }
+    }
+}
+
+vector<MemoryLogger::SiteStats> MemoryLogger::siteStats() const
+{
+    vector<SiteStats> stats;
+    for(uint i=0 ; i<MAX_SITES ; ++i)
+    {
+        const Site& site = _sites[i];
+        const char* file = site.file.load(std::memory_order_acquire);
+        if(file == nullptr || site.count.load() == 0)
+            continue;
+
+        SiteStats st = { file, site.line, site.count.load(), site.totalBytes.load(),
+                         site.liveCount.load(), site.liveBytes.load(), site.peakBytes.load() };
+
+        // the same file can be seen through several literals, merge them
+        auto it = std::find_if(stats.begin(), stats.end(), [&](const SiteStats& s)
+            { return s.line == st.line && strcmp(s.file, st.file) == 0; });
+
+        if(it == stats.end())
+            stats.push_back(st);
+        else
+        {
+            it->count += st.count; it->totalBytes += st.totalBytes;
+            it->liveCount += st.liveCount; it->liveBytes += st.liveBytes;
+            it->peakBytes += st.peakBytes;
+        }
+    }
+
+    std::sort(stats.begin(), stats.end(), [](const SiteStats& a, const SiteStats& b) { return a.peakBytes > b.peakBytes; });
+    return stats;
+}
+
+void MemoryLogger::printHistogram(size_t maxSites) const
+{
+    vector<SiteStats> stats = siteStats();
+
+    LOG("Allocation sites (sampling 1/", samplingRate(), "): file;line;count;totalBytes;liveCount;liveBytes;peakBytes");
+    for(size_t i=0 ; i<std::min(maxSites, stats.size()) ; ++i)
+    {
+        const SiteStats& s = stats[i];
+        LOG(s.file, ";", s.line, ";", s.count, ";", s.totalBytes, ";", s.liveCount, ";", s.liveBytes, ";", s.peakBytes);
     }
 }
 
 bool MemoryLogger::exist(void* ptr) const
 {
-    std::lock_guard guard(_mutex);
-    if(_allocatedMemorys.find(ptr) != _allocatedMemorys.end())
-        return true;
-    else
-        return false;
+    Shard& s = shard(ptr);
+    std::lock_guard<SpinLock> guard(s.lock);
+    return s.find(ptr) != nullptr;
 }
 
-#ifdef TIM_DEBUG
-void* operator new(size_t size, size_t line, const std::string& file)
+#ifdef TIM_MEMORY_TRACKING
+void* operator new(size_t size, size_t line, const char* file)
 {
     return MemoryLogger::instance().alloc(size, line, file, false);
 }
 
-void* operator new[](size_t size, size_t line, const std::string& file)
+void* operator new[](size_t size, size_t line, const char* file)
 {
     return MemoryLogger::instance().alloc(size, line, file, true);
 }
 
-void operator delete(void* ptr, size_t line, const std::string& file)
+void operator delete(void* ptr, size_t line, const char* file)
 {
     MemoryLogger::instance().dealloc(ptr, false);
 }
-void operator delete[](void* ptr, size_t line, const std::string& file)
+void operator delete[](void* ptr, size_t line, const char* file)
 {
     MemoryLogger::instance().dealloc(ptr, true);
 }
+
+void* operator new(size_t size, std::align_val_t al, size_t, const char*)
+{
+    return ::operator new(size, al);
+}
+
+void* operator new[](size_t size, std::align_val_t al, size_t, const char*)
+{
+    return ::operator new[](size, al);
+}
+
+void operator delete(void* ptr, std::align_val_t al, size_t, const char*)
+{
+    ::operator delete(ptr, al);
+}
+
+void operator delete[](void* ptr, std::align_val_t al, size_t, const char*)
+{
+    ::operator delete[](ptr, al);
+}
 #endif
@@ -2,11 +2,19 @@
 #define MEMORYLOGGER_H_INCLUDED
 
 #include <cstdlib>
+#include <new>
+#include <atomic>
 #include <mutex>
 #include "type.h"
+#include "SpinLock.h"
 
 #include "Exception.h"
 
+/* The tracking operators are available in debug and in profile builds (TIM_MEMORY_PROFILE) */
+#if defined(TIM_DEBUG) || defined(TIM_MEMORY_PROFILE)
+    #define TIM_MEMORY_TRACKING
+#endif
+
 #include "MemoryLoggerOn.h"
 namespace tim
 {
@@ -14,38 +22,94 @@ namespace core
 {
     class MemoryLogger
     {
-    private:
-        struct MemoryAlloc
+    public:
+        static constexpr uint NB_SHARDS = 64; // must be a power of 2
+        static constexpr uint MAX_SITES = 4096; // must be a power of 2, site 0 collects the overflow
+
+        /* Allocation statistics of one call site (file, line) */
+        struct SiteStats
         {
-            void* ptr;
-            size_t size, line;
-            std::string file;
-            bool isArray;
+            const char* file;
+            size_t line;
+            size_t count, totalBytes; // since the beginning
+            size_t liveCount, liveBytes, peakBytes;
         };
 
-    public:
         static MemoryLogger& instance();
+        /* Destroy the instance (leaks are reported), the allocations freed afterwards are no longer tracked */
         static void freeInstance();
 
-		void* alloc(size_t, size_t, const std::string&, bool);
-		void dealloc(void*, bool);
-        void nextDealloc(size_t, const std::string&);
+        /* Called by the global operator delete: dealloc if the logger exists, free otherwise */
+        static void release(void*, bool);
+
+        void* alloc(size_t, size_t, const char*, bool);
+        void dealloc(void*, bool);
+        void nextDealloc(size_t, const char*);
+
+        /* Track only one allocation every rate (per thread), 1 tracks everything.
+         * Leaks and double frees are only detected on tracked allocations. */
+        void setSamplingRate(uint rate) { _samplingRate.store(rate > 0 ? rate : 1, std::memory_order_relaxed); }
+        uint samplingRate() const { return _samplingRate.load(std::memory_order_relaxed); }
+
+        uint siteId(const char*, size_t);
 
         bool exist(void*) const;
 
         void printLeak() const;
 
+        /* Sorted by peak bytes, sampled allocations are weighted by the sampling rate */
+        vector<SiteStats> siteStats() const;
+        void printHistogram(size_t maxSites = 32) const;
+
     protected:
         MemoryLogger();
         ~MemoryLogger();
 
     private:
-        std::map<void*, MemoryAlloc> _allocatedMemorys;
-        size_t _lastDeallocLine;
-        std::string _lastDeallocFile;
-        mutable std::recursive_mutex _mutex;
+        struct MemoryAlloc
+        {
+            void* ptr;
+            size_t size;
+            uint site;
+            uint weight; // sampling rate when allocated
+            bool isArray;
+        };
+
+        /* Open addressing table (linear probing), storage comes from malloc to not recurse in new */
+        struct Shard
+        {
+            MemoryAlloc* table = nullptr;
+            uint capacity = 0;
+            uint count = 0, tombstones = 0;
+            mutable SpinLock lock;
+
+            void insert(const MemoryAlloc&);
+            MemoryAlloc* find(void*) const;
+            void erase(MemoryAlloc*);
+            void rehash(uint);
+        };
 
-        static MemoryLogger* _instance;
+        struct Site
+        {
+            std::atomic<const char*> file = nullptr;
+            size_t line = 0;
+            std::atomic<size_t> count = 0, totalBytes = 0;
+            std::atomic<size_t> liveCount = 0, liveBytes = 0, peakBytes = 0;
+        };
+
+        Shard _shards[NB_SHARDS];
+        Site* _sites;
+        std::mutex _siteMutex;
+        std::atomic<uint> _samplingRate = 1;
+
+        std::atomic<size_t> _lastDeallocLine = 0;
+        std::atomic<const char*> _lastDeallocFile = "";
+
+        static std::atomic<MemoryLogger*> _instance;
+
+        Shard& shard(void*) const;
+        void onAlloc(Site&, size_t, uint);
+        void onDealloc(Site&, size_t, uint);
 
         #include "MemoryLoggerOff.h"
         MemoryLogger(const MemoryLogger&) = delete;
@@ -56,11 +120,17 @@ namespace core
 }
 #include "MemoryLoggerOff.h"
 
-#ifdef TIM_DEBUG
-void* operator new(size_t size, size_t line, const std::string& file);
-void* operator new[](size_t size, size_t line, const std::string& file);
-void operator delete(void* ptr, size_t line, const std::string& file);
-void operator delete[](void* ptr, size_t line, const std::string& file);
+#ifdef TIM_MEMORY_TRACKING
+void* operator new(size_t size, size_t line, const char* file);
+void* operator new[](size_t size, size_t line, const char* file);
+void operator delete(void* ptr, size_t line, const char* file);
+void operator delete[](void* ptr, size_t line, const char* file);
+
+/* Over-aligned types are not tracked, only counted */
+void* operator new(size_t size, std::align_val_t al, size_t line, const char* file);
+void* operator new[](size_t size, std::align_val_t al, size_t line, const char* file);
+void operator delete(void* ptr, std::align_val_t al, size_t line, const char* file);
+void operator delete[](void* ptr, std::align_val_t al, size_t line, const char* file);
 #endif
 
 #endif // MEMORYLOGGER_H_INCLUDED
@@ -1,6 +1,3 @@
-
-// #ifdef TIM_DEBUG
-// #undef new
-// #undef delete
-// #endif
-
+#ifdef TIM_MEMORY_PROFILE
+#undef new
+#endif
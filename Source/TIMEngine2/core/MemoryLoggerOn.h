@@ -1,6 +1,6 @@
-
-// #ifdef TIM_DEBUG
-// #define new new(__LINE__,__FILE__)
-// #define delete tim::core::MemoryLogger::instance().nextDealloc(__LINE__,__FILE__),delete
-// #endif
-
+/* Included after the system headers of a file: in profile builds every new-expression that follows
+ * records its call site in the MemoryLogger (see MemoryLogger::printHistogram).
+ * Placement new and ::operator new must be surrounded by MemoryLoggerOff.h / MemoryLoggerOn.h. */
+#ifdef TIM_MEMORY_PROFILE
+#define new new(__LINE__,__FILE__)
+#endif
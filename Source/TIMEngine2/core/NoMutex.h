@@ -1,5 +1,5 @@
-#ifndef SPINLOCK_H_INCLUDED
-#define SPINLOCK_H_INCLUDED
+#ifndef NOMUTEX_H_INCLUDED
+#define NOMUTEX_H_INCLUDED
 
 namespace tim
 {
@@ -15,4 +15,4 @@ namespace core
 }
 }
 
-#endif // SPINLOCK_H_INCLUDED
+#endif // NOMUTEX_H_INCLUDED
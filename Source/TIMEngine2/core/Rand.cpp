@@ -1,11 +1,131 @@
 #include "Rand.h"
 
+#include <atomic>
+#include <cmath>
+
 #include "MemoryLoggerOn.h"
 namespace tim
 {
 namespace core
 {
-    std::default_random_engine Rand::s_generator;
-    std::uniform_real<float> Rand::frand_range;
+    namespace
+    {
+        uint64_t splitmix64(uint64_t& x)
+        {
+            uint64_t z = (x += 0x9e3779b97f4a7c15ull);
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+            return z ^ (z >> 31);
+        }
+
+        std::atomic<uint64_t> s_globalSeed = 0;
+        std::atomic<uint64_t> s_threadCounter = 0;
+    }
+
+    void Rand::setSeed(uint64_t seed)
+    {
+        uint64_t x = seed;
+        for(uint i=0 ; i<4 ; i+=2)
+        {
+            const uint64_t r = splitmix64(x);
+            _s[i] = uint32_t(r);
+            _s[i+1] = uint32_t(r >> 32);
+        }
+
+        for(uint c=0 ; c<4 ; ++c)
+        {
+            for(uint l=0 ; l<LANES ; ++l)
+                _lanes[c][l] = uint32_t(splitmix64(x) >> 32);
+        }
+    }
+
+    template <class F>
+    void Rand::fillLanes(size_t n, F&& output)
+    {
+        uint32_t* s0 = _lanes[0];
+        uint32_t* s1 = _lanes[1];
+        uint32_t* s2 = _lanes[2];
+        uint32_t* s3 = _lanes[3];
+
+        for(size_t i=0 ; i<n ; i+=LANES)
+        {
+            uint32_t r[LANES];
+            for(uint l=0 ; l<LANES ; ++l)
+            {
+                r[l] = rotl(s1[l] * 5, 7) * 9;
+                step(s0[l], s1[l], s2[l], s3[l]);
+            }
+
+            const size_t count = std::min<size_t>(LANES, n - i);
+            for(uint l=0 ; l<count ; ++l)
+                output(i + l, r[l]);
+        }
+    }
+
+    void Rand::fill_u(std::span<uint32_t> out)
+    {
+        fillLanes(out.size(), [&](size_t i, uint32_t r) { out[i] = r; });
+    }
+
+    void Rand::fill_f(std::span<float> out, float a, float b)
+    {
+        const float scale = (b - a) * (1.f / 16777216.f);
+        fillLanes(out.size(), [&](size_t i, uint32_t r) { out[i] = a + float(r >> 8) * scale; });
+    }
+
+    void Rand::fillOnUnitSphere(std::span<vec3> out)
+    {
+        const size_t CHUNK = 64;
+        float uv[CHUNK * 2];
+
+        for(size_t i=0 ; i<out.size() ; i+=CHUNK)
+        {
+            const size_t count = std::min(CHUNK, out.size() - i);
+            fill_f(std::span<float>(uv, count * 2));
+
+            for(size_t j=0 ; j<count ; ++j)
+            {
+                const float z = uv[2*j] * 2 - 1;
+                const float phi = uv[2*j+1] * float(2 * PI);
+                const float r = sqrtf(std::max(0.f, 1 - z*z));
+                out[i+j] = vec3(r * cosf(phi), r * sinf(phi), z);
+            }
+        }
+    }
+
+    void Rand::fillInUnitDisk(std::span<vec2> out)
+    {
+        const size_t CHUNK = 64;
+        float uv[CHUNK * 2];
+
+        for(size_t i=0 ; i<out.size() ; i+=CHUNK)
+        {
+            const size_t count = std::min(CHUNK, out.size() - i);
+            fill_f(std::span<float>(uv, count * 2));
+
+            for(size_t j=0 ; j<count ; ++j)
+            {
+                const float r = sqrtf(uv[2*j]);
+                const float theta = uv[2*j+1] * float(2 * PI);
+                out[i+j] = vec2(r * cosf(theta), r * sinf(theta));
+            }
+        }
+    }
+
+    Rand& Rand::local()
+    {
+        // each thread gets its own stream, derived from the global seed and its creation order
+        thread_local Rand generator(s_globalSeed.load(std::memory_order_relaxed) ^
+                                    (s_threadCounter.fetch_add(1, std::memory_order_relaxed) * 0x9e3779b97f4a7c15ull));
+        return generator;
+    }
+
+    void Rand::seed(uint64_t seed)
+    {
+        s_globalSeed.store(seed, std::memory_order_relaxed);
+        s_threadCounter.store(1, std::memory_order_relaxed);
+        local().setSeed(seed);
+    }
 }
 }
+#include "MemoryLoggerOff.h"
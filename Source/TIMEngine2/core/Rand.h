@@ -2,60 +2,95 @@
 #define RAND_H_INCLUDED
 
 #include "Vector.h"
-#include <random>
+#include <cstdint>
+#include <span>
 
 #include "MemoryLoggerOn.h"
 namespace tim
 {
 namespace core
 {
-
+    /* xoshiro128** generator, 16 bytes of state, seeded with splitmix64.
+     * An instance is not thread safe: use one per thread, the static functions use a thread local one.
+     * The bulk fills run LANES independent generators side by side so the loop can be vectorised,
+     * they are deterministic for a given seed but don't produce the same sequence as the scalar functions. */
     class Rand
     {
     public:
+        static constexpr uint LANES = 8;
+
+        Rand(uint64_t seed = 0) { setSeed(seed); }
+        void setSeed(uint64_t seed);
+
+        uint32_t next_u32()
+        {
+            // xoshiro128**
+            const uint32_t result = rotl(_s[1] * 5, 7) * 9;
+            step(_s[0], _s[1], _s[2], _s[3]);
+            return result;
+        }
 
-        Rand(uint seed) { _generator.seed(seed); }
-        float next_f() { return float(frand_range(_generator)); }
+        /* [0,1) */
+        float next_f() { return toFloat(next_u32()); }
 
+        /* [range.x, range.y) */
         float next_f(const vec2& range)
         {
             if(range.x() >= range.y())
                 return range.x();
-
-            std::uniform_real_distribution<float> dis(range.x(), range.y());
-            return float(dis(_generator));
+            return range.x() + next_f() * (range.y() - range.x());
         }
 
-        size_t next_i() { return _generator(); }
-        void setSeed(uint seed) { _generator.seed(seed); }
+        size_t next_i() { return next_u32(); }
 
-        /* Static */
-        static float frand() { return float(frand_range(s_generator)); }
-
-        static float frand(const vec2& range)
+        /* [range.x, range.y] */
+        int next_i(const ivec2& range)
         {
             if(range.x() >= range.y())
                 return range.x();
-
-            std::uniform_real_distribution<float> dis(range.x(), range.y());
-            return float(dis(s_generator));
+            const uint64_t width = uint64_t(int64_t(range.y()) - range.x()) + 1;
+            return int(int64_t(range.x()) + int64_t((uint64_t(next_u32()) * width) >> 32));
         }
 
-        static size_t rand() { return s_generator(); }
+        /* Bulk fills */
+        void fill_u(std::span<uint32_t>);
+        void fill_f(std::span<float>, float a = 0, float b = 1); // [a,b)
+        void fillOnUnitSphere(std::span<vec3>);
+        void fillInUnitDisk(std::span<vec2>);
 
-        static int rand(const ivec2& range)
-        {
-            std::uniform_int_distribution<> dis(range.x(), range.y());
-            return dis(s_generator);
-        }
+        /* Static, on the generator of the calling thread */
+        static Rand& local();
 
-        static void seed(uint seed) { s_generator.seed(seed); }
+        static float frand() { return local().next_f(); }
+        static float frand(const vec2& range) { return local().next_f(range); }
+        static size_t rand() { return local().next_i(); }
+        static int rand(const ivec2& range) { return local().next_i(range); }
+
+        /* Seed the calling thread and the threads calling local() for the first time after this */
+        static void seed(uint64_t seed);
 
     private:
-        std::default_random_engine  _generator;
+        uint32_t _s[4];
+        uint32_t _lanes[4][LANES]; // the state of each lane, stored by component so a step is LANES wide
+
+        static uint32_t rotl(uint32_t x, int k) { return (x << k) | (x >> (32 - k)); }
+
+        static void step(uint32_t& s0, uint32_t& s1, uint32_t& s2, uint32_t& s3)
+        {
+            const uint32_t t = s1 << 9;
+            s2 ^= s0;
+            s3 ^= s1;
+            s1 ^= s2;
+            s0 ^= s3;
+            s2 ^= t;
+            s3 = rotl(s3, 11);
+        }
+
+        /* The 24 high bits, exact in a float */
+        static float toFloat(uint32_t x) { return float(x >> 8) * (1.f / 16777216.f); }
 
-        static std::default_random_engine s_generator;
-        static std::uniform_real<float> frand_range;
+        template <class F>
+        void fillLanes(size_t n, F&& output);
     };
 
 }
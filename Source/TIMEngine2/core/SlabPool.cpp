@@ -0,0 +1,108 @@
+#include "SlabPool.h"
+
+#include <algorithm>
+#include <new>
+
+#include "MemoryLoggerOn.h"
+namespace tim
+{
+namespace core
+{
+
+SlabPool::SlabPool(size_t objectSize, size_t objectAlign)
+{
+    TIM_ASSERT(isPowerOf2(objectAlign) && objectAlign <= SLAB_ALIGN);
+
+    // a free slot stores the next pointer
+    objectSize = std::max(objectSize, sizeof(FreeSlot));
+    objectAlign = std::max(objectAlign, alignof(FreeSlot));
+    _stride = (objectSize + objectAlign - 1) & ~(objectAlign - 1);
+}
+
+SlabPool::SlabPool(SlabPool&& pool) noexcept
+    : _stride(pool._stride), _count(pool._count), _capacity(pool._capacity), _nextSlabObjects(pool._nextSlabObjects),
+      _slabs(pool._slabs), _cur(pool._cur), _end(pool._end), _freeList(pool._freeList)
+{
+    pool._slabs = nullptr;
+    pool._cur = pool._end = nullptr;
+    pool._freeList = nullptr;
+    pool._count = pool._capacity = 0;
+}
+
+SlabPool::~SlabPool()
+{
+    TIM_ASSERT(_count == 0);
+
+    while(_slabs)
+    {
+        Slab* next = _slabs->next;
+        ::operator delete(_slabs, std::align_val_t(SLAB_ALIGN));
+        _slabs = next;
+    }
+}
+
+void SlabPool::newSlab()
+{
+    const size_t header = (sizeof(Slab) + SLAB_ALIGN - 1) & ~(SLAB_ALIGN - 1);
+    const size_t bytes = _nextSlabObjects * _stride;
+
+#include "MemoryLoggerOff.h"
+    Slab* slab = static_cast<Slab*>(::operator new(header + bytes, std::align_val_t(SLAB_ALIGN)));
+#include "MemoryLoggerOn.h"
+    slab->next = _slabs;
+    slab->begin = reinterpret_cast<char*>(slab) + header;
+    slab->end = slab->begin + bytes;
+    _slabs = slab;
+
+    _cur = slab->begin;
+    _end = slab->end;
+    _capacity += _nextSlabObjects;
+    _nextSlabObjects = std::min(_nextSlabObjects * 2, MAX_SLAB_OBJECTS);
+}
+
+void* SlabPool::alloc()
+{
+    void* ptr;
+    if(_freeList)
+    {
+        ptr = _freeList;
+        _freeList = _freeList->next;
+    }
+    else
+    {
+        if(_cur == _end)
+            newSlab();
+
+        ptr = _cur;
+        _cur += _stride;
+    }
+
+    ++_count;
+    return ptr;
+}
+
+void SlabPool::free(void* ptr)
+{
+    if(!ptr) return;
+    TIM_ASSERT(owns(ptr));
+
+    FreeSlot* slot = static_cast<FreeSlot*>(ptr);
+    slot->next = _freeList;
+    _freeList = slot;
+    --_count;
+}
+
+bool SlabPool::owns(const void* ptr) const
+{
+    const char* p = static_cast<const char*>(ptr);
+    for(const Slab* s = _slabs ; s ; s = s->next)
+    {
+        if(p >= s->begin && p < s->end)
+            return (p - s->begin) % _stride == 0;
+    }
+    return false;
+}
+
+}
+}
+#include "MemoryLoggerOff.h"
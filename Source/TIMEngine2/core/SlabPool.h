@@ -0,0 +1,67 @@
+#ifndef SLABPOOL_H_INCLUDED
+#define SLABPOOL_H_INCLUDED
+
+#include <cstddef>
+#include <new>
+#include "Common.h"
+#include "NonCopyable.h"
+#include "type.h"
+
+#include "MemoryLoggerOn.h"
+namespace tim
+{
+namespace core
+{
+    /* Fixed size objects stored contiguously in cache aligned slabs.
+     * alloc and free are O(1): freed slots are chained in a free list and reused first,
+     * a new slab (twice bigger than the previous one, up to MAX_SLAB_OBJECTS) is only allocated when the list is empty.
+     * Not thread safe. */
+    class SlabPool : NonCopyable
+    {
+    public:
+        static constexpr size_t SLAB_ALIGN = 64;
+        static constexpr size_t MIN_SLAB_OBJECTS = 32;
+        static constexpr size_t MAX_SLAB_OBJECTS = 4096;
+
+        SlabPool(size_t objectSize, size_t objectAlign);
+        SlabPool(SlabPool&&) noexcept;
+        ~SlabPool();
+
+        void* alloc();
+        void free(void*);
+
+        bool owns(const void*) const;
+
+        size_t objectSize() const { return _stride; }
+        size_t size() const { return _count; }
+        size_t capacity() const { return _capacity; }
+
+    private:
+        struct Slab
+        {
+            Slab* next;
+            char* begin;
+            char* end;
+        };
+
+        struct FreeSlot
+        {
+            FreeSlot* next;
+        };
+
+        size_t _stride;
+        size_t _count = 0, _capacity = 0;
+        size_t _nextSlabObjects = MIN_SLAB_OBJECTS;
+
+        Slab* _slabs = nullptr; // last allocated first
+        char* _cur = nullptr;   // never used slots of the last slab
+        char* _end = nullptr;
+        FreeSlot* _freeList = nullptr;
+
+        void newSlab();
+    };
+}
+}
+#include "MemoryLoggerOff.h"
+
+#endif // SLABPOOL_H_INCLUDED
@@ -1,5 +1,10 @@
 #include "Sphere.h"
 #include "Box.h"
+#include "ThreadPool.h"
+
+#ifdef TIM_SSE
+    #include <xmmintrin.h>
+#endif
 
 #include "MemoryLoggerOn.h"
 namespace tim
@@ -75,30 +80,115 @@ std::string Sphere::str() const
     return str;
 }
 
-Sphere Sphere::computeSphere(const real* ptr, uint size, uint stride)
+namespace
 {
-    vec3 minV = vec3::construct(std::numeric_limits<float>::max()), maxV = vec3::construct(std::numeric_limits<float>::min());
+    const uint PARALLEL_THRESHOLD = 1 << 16;
+    const uint CHUNK_SIZE = 1 << 14;
+
+    /* Max of the squared distances to c of the points [begin,end), summed like vec3::length2 */
+    float maxDistance2(const real* ptr, uint begin, uint end, uint stride, const vec3& c)
+    {
+        float res = 0;
+        uint i = begin;
+#ifdef TIM_SSE
+        if(stride >= 3)
+        {
+            const uint simdEnd = stride >= 4 || end <= begin ? end : end - 1;
+            const __m128 center = _mm_setr_ps(c.x(), c.y(), c.z(), 0);
+            __m128 m = _mm_setzero_ps();
+            for( ; i<simdEnd ; ++i)
+            {
+                const __m128 d = _mm_sub_ps(_mm_loadu_ps(ptr + size_t(i)*stride), center);
+                const __m128 sq = _mm_mul_ps(d, d);
+                const __m128 l = _mm_add_ss(_mm_add_ss(sq, _mm_shuffle_ps(sq, sq, _MM_SHUFFLE(1,1,1,1))),
+                                            _mm_shuffle_ps(sq, sq, _MM_SHUFFLE(2,2,2,2)));
+                m = _mm_max_ss(m, l);
+            }
+            res = _mm_cvtss_f32(m);
+        }
+#endif
+        for( ; i<end ; ++i)
+        {
+            const real* p = ptr + size_t(i)*stride;
+            res = std::max(res, (vec3(p[0], p[1], p[2]) - c).length2());
+        }
+        return res;
+    }
+
+    float maxDistance(const real* ptr, uint size, uint stride, const vec3& c, ThreadPool* pool)
+    {
+        if(pool && size >= PARALLEL_THRESHOLD)
+        {
+            const uint nbChunks = (size + CHUNK_SIZE - 1) / CHUNK_SIZE;
+            vector<float> chunkMax(nbChunks, 0);
+
+            pool->parallelFor(0, nbChunks, 1, [&](size_t k)
+            {
+                chunkMax[k] = maxDistance2(ptr, uint(k)*CHUNK_SIZE, std::min(size, uint(k+1)*CHUNK_SIZE), stride, c);
+            });
+            return sqrtf(*std::max_element(chunkMax.begin(), chunkMax.end()));
+        }
+        else return sqrtf(maxDistance2(ptr, 0, size, stride, c));
+    }
+
+    vec3 point(const real* ptr, uint i, uint stride) { const real* p = ptr + size_t(i)*stride; return vec3(p[0], p[1], p[2]); }
+
+    uint farthest(const real* ptr, uint size, uint stride, const vec3& from)
+    {
+        uint index = 0;
+        float best = -1;
+        for(uint i=0 ; i<size ; ++i)
+        {
+            const float d = (point(ptr, i, stride) - from).length2();
+            if(d > best) { best = d; index = i; }
+        }
+        return index;
+    }
 
-    for(uint i=0 ; i<size ; ++i)
+    /* Ritter: start from two far apart points, grow the sphere to include each point outside */
+    vec3 ritterCenter(const real* ptr, uint size, uint stride)
     {
-        for(int j=0 ; j<3 ; ++j)
+        const vec3 y = point(ptr, farthest(ptr, size, stride, point(ptr, 0, stride)), stride);
+        const vec3 z = point(ptr, farthest(ptr, size, stride, y), stride);
+
+        vec3 center = (y + z) * 0.5f;
+        float radius = (z - y).length() * 0.5f;
+
+        for(uint i=0 ; i<size ; ++i)
         {
-            minV[j] = std::min(minV[j], ptr[j+i*stride]);
-            maxV[j] = std::max(maxV[j], ptr[j+i*stride]);
+            const vec3 p = point(ptr, i, stride);
+            const float d2 = (p - center).length2();
+            if(d2 > radius*radius)
+            {
+                const float d = sqrtf(d2);
+                const float newRadius = (radius + d) * 0.5f;
+                center += (p - center) * ((newRadius - radius) / d);
+                radius = newRadius;
+            }
         }
+        return center;
     }
+}
+
+Sphere Sphere::computeSphere(const real* ptr, uint size, uint stride, Fit fit, ThreadPool* pool)
+{
+    if(size == 0)
+        return Sphere();
 
-    vec3 center = (minV+maxV) / 2;
-    //center = {0,0,0};
+    const Box box = Box::computeBox(ptr, size, stride, pool);
+    const vec3 center = (box.min()+box.max()) / 2;
+    Sphere sphere(center, maxDistance(ptr, size, stride, center, pool));
 
-    float minD = 0;
-    for(uint i=0 ; i<size ; ++i)
+    if(fit == Fit::RITTER)
     {
-        vec3 v = {ptr[i*stride], ptr[i*stride+1], ptr[i*stride+2]};
-        minD = std::max(minD, (v-center).length());
+        // the radius is measured again from the final center, rounding in the growing steps can't leave a point out
+        const vec3 rCenter = ritterCenter(ptr, size, stride);
+        const float rRadius = maxDistance(ptr, size, stride, rCenter, pool);
+        if(rRadius < sphere.radius())
+            sphere = Sphere(rCenter, rRadius);
     }
 
-    return Sphere(center, minD);
+    return sphere;
 }
 
 bool Sphere::collide(const vec3& o, const vec3& l, vec3& res) const
@@ -11,11 +11,19 @@ namespace tim
 namespace core
 {
     class Box;
+    class ThreadPool;
 
     class Sphere
     {
     public:
-        static Sphere computeSphere(const real* ptr, uint size, uint stride=1);
+        enum class Fit
+        {
+            BOX_CENTER, // centered on the bounding box, fast
+            RITTER,     // Ritter's growing sphere, usually tighter, the best of both is kept
+        };
+
+        /* Bounding sphere of size points of 3 floats, stride floats apart; big inputs are split on the pool if one is given */
+        static Sphere computeSphere(const real* ptr, uint size, uint stride=1, Fit fit=Fit::BOX_CENTER, ThreadPool* pool=nullptr);
 
         Sphere();
         Sphere(const vec3&, float);
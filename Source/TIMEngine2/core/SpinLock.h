@@ -2,29 +2,203 @@
 #define SPINLOCK_H_INCLUDED
 
 #include <atomic>
+#include <thread>
+#include <cstdint>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+    #include <immintrin.h>
+    #define TIM_CPU_RELAX() _mm_pause()
+#else
+    #define TIM_CPU_RELAX() std::this_thread::yield()
+#endif
+
+/* Define TIM_LOCK_STATS to count the contended acquisitions of each lock */
 
 namespace tim
 {
 namespace core
 {
+    /* Exponential backoff: pause 1, 2, 4 .. MAX_PAUSE times then yield the thread */
+    class SpinBackoff
+    {
+    public:
+        static constexpr uint32_t MAX_PAUSE = 64;
+
+        void operator()()
+        {
+            if(_pause <= MAX_PAUSE)
+            {
+                for(uint32_t i=0 ; i<_pause ; ++i)
+                    TIM_CPU_RELAX();
+                _pause *= 2;
+            }
+            else std::this_thread::yield();
+        }
+
+    private:
+        uint32_t _pause = 1;
+    };
+
+    /* Counters of a lock, empty unless TIM_LOCK_STATS is defined */
+    class LockStats
+    {
+    public:
+#ifdef TIM_LOCK_STATS
+        void onAcquire(bool contended) { _acquired.fetch_add(1, std::memory_order_relaxed); if(contended) _contended.fetch_add(1, std::memory_order_relaxed); }
+        uint64_t acquired() const { return _acquired.load(std::memory_order_relaxed); }
+        uint64_t contended() const { return _contended.load(std::memory_order_relaxed); }
+
+    private:
+        std::atomic<uint64_t> _acquired = 0, _contended = 0;
+#else
+        void onAcquire(bool) {}
+        uint64_t acquired() const { return 0; }
+        uint64_t contended() const { return 0; }
+#endif
+    };
+
+    /* Test and test-and-set lock: waiters spin on a load, not on the exchange, so the cache line stays shared */
     class SpinLock
     {
     public:
-        SpinLock() : _state(Unlocked) {}
+        SpinLock() = default;
 
         void lock()
         {
-            while (_state.exchange(Locked, std::memory_order_acquire) == Locked);
+            if(!_locked.exchange(true, std::memory_order_acquire))
+            {
+                _stats.onAcquire(false);
+                return;
+            }
+
+            SpinBackoff backoff;
+            do
+            {
+                while(_locked.load(std::memory_order_relaxed))
+                    backoff();
+            }
+            while(_locked.exchange(true, std::memory_order_acquire));
+
+            _stats.onAcquire(true);
+        }
+
+        bool try_lock()
+        {
+            if(_locked.load(std::memory_order_relaxed) || _locked.exchange(true, std::memory_order_acquire))
+                return false;
+
+            _stats.onAcquire(false);
+            return true;
         }
 
         void unlock()
         {
-            _state.store(Unlocked, std::memory_order_release);
+            _locked.store(false, std::memory_order_release);
         }
 
+        const LockStats& stats() const { return _stats; }
+
     private:
-        typedef enum {Locked, Unlocked} LockState;
-        std::atomic<LockState> _state;
+        std::atomic<bool> _locked = false;
+        LockStats _stats;
+    };
+
+    /* Reader-writer spin lock, usable with std::shared_lock / std::lock_guard.
+     * A waiting writer blocks the new readers so it can't be starved. */
+    class SharedSpinLock
+    {
+    public:
+        SharedSpinLock() = default;
+
+        void lock()
+        {
+            uint32_t state = _state.load(std::memory_order_relaxed);
+            if(state == 0 && _state.compare_exchange_strong(state, WRITER, std::memory_order_acquire))
+            {
+                _stats.onAcquire(false);
+                return;
+            }
+
+            SpinBackoff backoff;
+            while(true)
+            {
+                state = _state.load(std::memory_order_relaxed);
+                if((state & ~WRITER_PENDING) == 0)
+                {
+                    // no reader nor writer, take it (and clear the pending flag)
+                    if(_state.compare_exchange_weak(state, WRITER, std::memory_order_acquire))
+                        break;
+                }
+                else if(!(state & WRITER_PENDING))
+                {
+                    _state.fetch_or(WRITER_PENDING, std::memory_order_relaxed);
+                }
+                else backoff();
+            }
+
+            _stats.onAcquire(true);
+        }
+
+        bool try_lock()
+        {
+            uint32_t state = 0;
+            if(!_state.compare_exchange_strong(state, WRITER, std::memory_order_acquire))
+                return false;
+
+            _stats.onAcquire(false);
+            return true;
+        }
+
+        void unlock()
+        {
+            _state.fetch_and(~WRITER, std::memory_order_release);
+        }
+
+        void lock_shared()
+        {
+            bool contended = false;
+            SpinBackoff backoff;
+            while(true)
+            {
+                uint32_t state = _state.load(std::memory_order_relaxed);
+                if(!(state & (WRITER | WRITER_PENDING)))
+                {
+                    if(_state.compare_exchange_weak(state, state + 1, std::memory_order_acquire))
+                        break;
+                }
+                else
+                {
+                    contended = true;
+                    backoff();
+                }
+            }
+
+            _stats.onAcquire(contended);
+        }
+
+        bool try_lock_shared()
+        {
+            uint32_t state = _state.load(std::memory_order_relaxed);
+            if((state & (WRITER | WRITER_PENDING)) || !_state.compare_exchange_strong(state, state + 1, std::memory_order_acquire))
+                return false;
+
+            _stats.onAcquire(false);
+            return true;
+        }
+
+        void unlock_shared()
+        {
+            _state.fetch_sub(1, std::memory_order_release);
+        }
+
+        const LockStats& stats() const { return _stats; }
+
+    private:
+        static constexpr uint32_t WRITER = 1u << 31;
+        static constexpr uint32_t WRITER_PENDING = 1u << 30;
+
+        std::atomic<uint32_t> _state = 0; // flags | number of readers
+        LockStats _stats;
     };
 }
 }
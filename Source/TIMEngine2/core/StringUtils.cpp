@@ -1,4 +1,5 @@
 #include "StringUtils.h"
+#include "FileSystem.h"
 
 #include "MemoryLoggerOn.h"
 namespace tim
@@ -58,12 +59,8 @@ vector<std::string> StringUtils::splitWord(char splitChar) const
 
 std::string StringUtils::readFile(const std::string& file)
 {
-    std::ifstream ff(file);
-    std::string line, total;
-
-    while(std::getline(ff, line))
-        total += line+"\n";
-
+    std::string total;
+    FileSystem::readText(file, total);
     return total;
 }
 
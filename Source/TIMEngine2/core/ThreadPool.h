@@ -6,6 +6,9 @@
 #include "NonCopyable.h"
 #include <mutex>
 #include <future>
+#include <atomic>
+#include <algorithm>
+#include <memory>
 
 #include "MemoryLoggerOn.h"
 namespace tim
@@ -43,6 +46,45 @@ namespace core
         // 
         void wait() { std::lock_guard guard(_mutex); _pool.wait_for_tasks(); }
 
+        /* Call f(i) for i in [begin,end), in chunks of grain indices run by the pool and by the calling thread.
+         * Returns when every index is done. The caller takes chunks too, so it can't deadlock when called from a task. */
+        template <class F>
+        void parallelFor(size_t begin, size_t end, size_t grain, const F& f)
+        {
+            if(begin >= end) return;
+            grain = std::max<size_t>(grain, 1);
+            const size_t nbChunks = (end - begin + grain - 1) / grain;
+
+            struct State
+            {
+                std::atomic<size_t> next = 0, done = 0;
+            };
+            auto state = std::make_shared<State>();
+
+            auto run = [state, begin, end, grain, nbChunks, &f]()
+            {
+                size_t chunk;
+                while((chunk = state->next.fetch_add(1)) < nbChunks)
+                {
+                    const size_t first = begin + chunk * grain;
+                    const size_t last = std::min(first + grain, end);
+                    for(size_t i=first ; i<last ; ++i)
+                        f(i);
+                    state->done.fetch_add(1, std::memory_order_release);
+                }
+            };
+
+            // late tasks find no chunk left and return without touching f.
+            // _mutex isn't taken: a task calling parallelFor while another thread is in wait() would deadlock
+            const size_t nbTasks = std::min<size_t>(nbChunks - 1, _pool.size());
+            for(size_t i=0 ; i<nbTasks ; ++i)
+                _pool.enqueue_detach(run);
+
+            run();
+            while(state->done.load(std::memory_order_acquire) < nbChunks)
+                std::this_thread::yield();
+        }
+
     private:
         dp::thread_pool<> _pool;
         mutable std::mutex _mutex;
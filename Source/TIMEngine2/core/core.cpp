@@ -12,6 +12,9 @@ void init()
     std::freopen("err.txt", "w+", stderr);
     Rand::seed(time(0));
 
+    // the logger writes asynchronously, make sure pending records reach the file before dying
+    std::set_terminate([]() { logger.flush(); std::abort(); });
+
     static_assert(sizeof(sbyte)==1, "Assertion type failed.");
     static_assert(sizeof(ubyte)==1, "Assertion type failed.");
     static_assert(sizeof(real)==4, "Assertion type failed.");
@@ -21,8 +24,12 @@ void init()
 
 void quit()
 {
-    MemoryLogger::instance().printLeak();
-    free(&MemoryLogger::instance());
+#ifdef TIM_MEMORY_PROFILE
+    MemoryLogger::instance().printHistogram();
+#endif
+    // the destructor reports the leaks
+    MemoryLogger::freeInstance();
+    logger.stop();
 }
 
 }
@@ -5,6 +5,7 @@
 #include "Logger.h"
 #include "NonCopyable.h"
 #include "MemoryLogger.h"
+#include "AllocCounter.h"
 
 #define RENDERABLE_OBJECT_NB_LOD 4
 
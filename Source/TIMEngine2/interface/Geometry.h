@@ -43,6 +43,8 @@ namespace interface
 
         const renderer::MeshData* meshData() const { return _ptr->cpuData(); }
 
+        size_t bytes() const { if(!buffers()) return 0; return _ptr->bytes(); }
+
     protected:
         renderer::MeshBuffers* buffers() const { return _ptr.get(); }
     };
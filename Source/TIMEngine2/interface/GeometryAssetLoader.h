@@ -4,6 +4,7 @@
 #include "resource/MeshLoader.h"
 #include "resource/AssetLoader.h"
 #include "Geometry.h"
+#include "GeometryCache.h"
 
 namespace tim
 {
@@ -14,106 +15,170 @@ namespace resource
     class AssetLoader<interface::Geometry>
     {
     public:
+        /* flags: MeshLoader::LoadFlags */
         template<bool async>
-        Option<interface::Geometry> operator()(std::string file, bool keepData = false)
+        Option<interface::Geometry> operator()(std::string file, bool keepData = false, uint flags = 0)
         {
+            // the same file requested with other arguments
+            if(std::shared_ptr<renderer::MeshBuffers> shared = interface::GeometryCache::findFile(file, flags, keepData))
+                return Option<interface::Geometry>(interface::Geometry(shared));
+
             if(!async)
             {
-                renderer::MeshData* data = new renderer::MeshData;
-
-                if(StringUtils(file).extension() == "obj")
-                    *data = MeshLoader::importObj(file);
-                else
-                    *data = MeshLoader::importTim(file);
+                Staged staged = prepare(file, keepData, flags);
+                return finish(staged);
+            }
+            else
+            {
+                std::shared_ptr<renderer::MeshBuffers> emptyBuf(new renderer::MeshBuffers(nullptr, nullptr));
 
-                if(data->nbIndex > 0 && data->nbVertex > 0)
-                {
-                    renderer::VBuffer* vb = renderer::vertexBufferPool->alloc(data->nbVertex);
-                    renderer::IBuffer* ib = renderer::indexBufferPool->alloc(data->nbIndex);
-                    renderer::IBuffer* ib2 = data->secondaryIndexData ? renderer::indexBufferPool->alloc(data->nbSecondaryIndex) : nullptr;
-                    vb->flush(reinterpret_cast<float*>(data->vData), 0, data->nbVertex);
-                    ib->flush(data->indexData, 0, data->nbIndex);
-                    if (ib2) {
-                        ib2->flush(data->secondaryIndexData, 0, data->nbSecondaryIndex);
-                    }
+                auto asyncLoad = [=](){
+                    renderer::MeshData* data = load(file);
+                    if(!data)
+                        return;
 
-                    renderer::MeshBuffers* mb = nullptr;
-                    if(keepData)
+                    if(std::shared_ptr<renderer::MeshBuffers> shared = interface::GeometryCache::find(file, *data, flags, keepData))
                     {
-                        mb = new renderer::MeshBuffers(vb, ib, ib2, Sphere::computeSphere(reinterpret_cast<real*>(data->vData), data->nbVertex,
-                                                       sizeof(renderer::MeshData::DataType)/sizeof(float)), data);
+                        emptyBuf->share(shared);
+                        if(!keepData)
+                            release(data);
+                        else
+                        {
+                            // the cpu data is read on the gl thread
+                            renderer::openGL.pushGLTask([=](){
+                                if(!shared->setCpuData(data))
+                                    release(data);
+                            });
+                        }
+                        return;
                     }
-                    else
-                    {
-                        mb = new renderer::MeshBuffers(vb, ib, ib2, Sphere::computeSphere(reinterpret_cast<real*>(data->vData), data->nbVertex,
-                                                       sizeof(renderer::MeshData::DataType)/sizeof(float)));
 
-                        data->clear();
-                        delete data;
-                    }
+                    // the conversion is done here, the gl thread only uploads
+                    auto gpu = std::make_shared<MeshLoader::GpuData>(MeshLoader::prepareGpuData(*data, (flags & MeshLoader::PACKED_VERTEX) != 0));
+                    renderer::MeshBuffers* mb = MeshLoader::allocMeshBuffers(*gpu, volume(*data, flags), keepData ? data : nullptr);
+                    emptyBuf->swap(*mb);
+                    delete mb;
+                    interface::GeometryCache::add(file, *data, flags, emptyBuf, gpu->bytes());
 
-                    return Option<interface::Geometry>(interface::Geometry(mb));
-                }
-                else
+                    renderer::openGL.pushGLTask([=](){
+                        MeshLoader::flushMeshBuffers(*gpu, *emptyBuf);
+
+                        if(!keepData)
+                            release(data);
+                    });
+                };
+                renderer::globalThreadPool.schedule(asyncLoad);
+
+                return Option<interface::Geometry>(interface::Geometry(emptyBuf));
+            }
+        }
+
+        /* Load in two parts for the LoadQueue */
+        struct Staged
+        {
+            std::string file;
+            bool keepData = false;
+            uint flags = 0;
+            std::shared_ptr<renderer::MeshBuffers> buffers; // shared ones, or to upload
+            renderer::MeshData* data = nullptr;
+            MeshLoader::GpuData gpu;
+            bool upload = false;
+        };
+
+        /* Read, convert and allocate, any thread */
+        static Staged prepare(std::string file, bool keepData = false, uint flags = 0)
+        {
+            Staged staged;
+            staged.file = file;
+            staged.keepData = keepData;
+            staged.flags = flags;
+
+            // the same file requested with other arguments
+            if((staged.buffers = interface::GeometryCache::findFile(file, flags, keepData)))
+                return staged;
+
+            staged.data = load(file);
+            if(!staged.data)
+                return staged;
+
+            // the same content under another name
+            if((staged.buffers = interface::GeometryCache::find(file, *staged.data, flags, keepData)))
+            {
+                if(!keepData)
                 {
-                    LOG_EXT("Failed to load Geometry: ", file);
-                    data->clear();
-                    delete data;
-                    return Option<interface::Geometry>();
+                    release(staged.data);
+                    staged.data = nullptr;
                 }
+                return staged;
             }
-            else
+
+            staged.gpu = MeshLoader::prepareGpuData(*staged.data, (flags & MeshLoader::PACKED_VERTEX) != 0);
+            staged.buffers.reset(MeshLoader::allocMeshBuffers(staged.gpu, volume(*staged.data, flags), keepData ? staged.data : nullptr));
+            staged.upload = true;
+            return staged;
+        }
+
+        /* Upload, gl thread */
+        static Option<interface::Geometry> finish(Staged& staged)
+        {
+            if(!staged.buffers)
+                return Option<interface::Geometry>();
+
+            if(staged.upload)
             {
-                renderer::MeshBuffers* emptyBuf = new renderer::MeshBuffers(nullptr, nullptr);
-                interface::Geometry geom(emptyBuf);
+                MeshLoader::flushMeshBuffers(staged.gpu, *staged.buffers);
+                interface::GeometryCache::add(staged.file, *staged.data, staged.flags, staged.buffers, staged.gpu.bytes());
+                if(!staged.keepData)
+                    release(staged.data);
+            }
+            else if(staged.data && !staged.buffers->setCpuData(staged.data))
+                release(staged.data);
 
-                auto asyncLoad = [=](){
-                    renderer::MeshData* data = new renderer::MeshData;
+            staged.data = nullptr;
+            return Option<interface::Geometry>(interface::Geometry(staged.buffers));
+        }
 
-                    if(StringUtils(file).extension() == "obj")
-                        *data = MeshLoader::importObj(file);
-                    else
-                        *data = MeshLoader::importTim(file);
+        /* Drop a prepared load */
+        static void discard(Staged& staged)
+        {
+            // owned by the buffers when kept
+            if(staged.data && !(staged.upload && staged.keepData))
+                release(staged.data);
+            staged.data = nullptr;
+            staged.buffers.reset();
+        }
 
-                    if(data->nbIndex > 0 && data->nbVertex > 0)
-                    {
-                        interface::Geometry copyGeom = geom;
-                        renderer::VBuffer* vb = renderer::vertexBufferPool->alloc(data->nbVertex);
-                        renderer::IBuffer* ib = renderer::indexBufferPool->alloc(data->nbIndex);
-                        renderer::IBuffer* ib2 = data->secondaryIndexData ? renderer::indexBufferPool->alloc(data->nbSecondaryIndex) : nullptr;
-
-                        renderer::MeshBuffers* mb = new renderer::MeshBuffers(vb, ib, ib2, Sphere::computeSphere(reinterpret_cast<real*>(data->vData), data->nbVertex,
-                                                                              sizeof(renderer::VNC_Vertex)/sizeof(float)), keepData ? data : nullptr);
-                        emptyBuf->swap(*mb);
-
-                        renderer::openGL.pushGLTask([=](){
-                            interface::Geometry copyGeom2 = copyGeom;
-                            vb->flush(reinterpret_cast<float*>(data->vData), 0, data->nbVertex);
-                            ib->flush(data->indexData, 0, data->nbIndex);
-                            if (ib2) {
-                                ib2->flush(data->secondaryIndexData, 0, data->nbSecondaryIndex);
-                            }
-
-                            if(!keepData)
-                            {
-                                data->clear();
-                                delete data;
-                            }
-                        });
-
-                        delete mb;
-                    }
-                    else
-                    {
-                        LOG_EXT("Failed to load Geometry: ", file);
-                        data->clear();
-                        delete data;
-                    }
-                };
-                renderer::globalThreadPool.schedule(asyncLoad);
+    private:
+        /* Null if the file can't be loaded */
+        static renderer::MeshData* load(const std::string& file)
+        {
+            renderer::MeshData* data = new renderer::MeshData;
 
-                return Option<interface::Geometry>(geom);
+            if(StringUtils(file).extension() == "obj")
+                *data = MeshLoader::importObj(file);
+            else
+                *data = MeshLoader::mapTim(file);
+
+            if(data->nbIndex == 0 || data->nbVertex == 0)
+            {
+                LOG_EXT("Failed to load Geometry: ", file);
+                release(data);
+                return nullptr;
             }
+
+            data->contentHash = interface::GeometryCache::hash(*data);
+            return data;
+        }
+
+        static Sphere volume(const renderer::MeshData& data, uint flags)
+        {
+            return MeshLoader::volume(data, (flags & MeshLoader::RITTER_SPHERE) ? Sphere::Fit::RITTER : Sphere::Fit::BOX_CENTER);
+        }
+
+        static void release(renderer::MeshData* data)
+        {
+            data->clear();
+            delete data;
         }
     };
 }
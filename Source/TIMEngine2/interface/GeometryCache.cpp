@@ -0,0 +1,135 @@
+#include "GeometryCache.h"
+#include "resource/MeshLoader.h"
+
+#include "MemoryLoggerOn.h"
+namespace tim
+{
+    using namespace core;
+namespace interface
+{
+
+std::mutex GeometryCache::_mutex;
+std::unordered_map<uint64_t, GeometryCache::Entry> GeometryCache::_byContent;
+std::map<std::pair<std::string, uint>, uint64_t> GeometryCache::_byFile;
+size_t GeometryCache::_pruneSize = 64;
+GeometryCache::Stats GeometryCache::_stats;
+
+namespace
+{
+    size_t cpuBytes(const renderer::MeshData& data)
+    {
+        return sizeof(renderer::MeshData::DataType)*data.nbVertex + sizeof(uint)*(data.nbIndex + data.nbSecondaryIndex);
+    }
+}
+
+uint64_t GeometryCache::hash(const renderer::MeshData& data)
+{
+    return data.contentHash ? data.contentHash : resource::MeshLoader::contentHash(data);
+}
+
+uint64_t GeometryCache::contentKey(const renderer::MeshData& data, uint flags)
+{
+    const uint64_t h = hash(data);
+    return flags == 0 ? h : h ^ (uint64_t(flags) * 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2));
+}
+
+std::shared_ptr<renderer::MeshBuffers> GeometryCache::findFile(const std::string& file, uint flags, bool needCpuData)
+{
+    std::lock_guard<std::mutex> guard(_mutex);
+
+    auto itFile = _byFile.find({ file, flags });
+    if(itFile == _byFile.end())
+        return nullptr;
+
+    auto it = _byContent.find(itFile->second);
+    if(it == _byContent.end())
+        return nullptr;
+
+    std::shared_ptr<renderer::MeshBuffers> buffers = it->second.buffers.lock();
+    if(!buffers || (needCpuData && !buffers->cpuData()))
+        return nullptr;
+
+    ++_stats.fileHits;
+    _stats.gpuBytesSaved += it->second.gpuBytes;
+    _stats.cpuBytesSaved += needCpuData ? it->second.cpuBytes : 0;
+    return buffers;
+}
+
+std::shared_ptr<renderer::MeshBuffers> GeometryCache::find(const std::string& file, const renderer::MeshData& data, uint flags, bool keepData)
+{
+    const uint64_t h = contentKey(data, flags);
+
+    std::lock_guard<std::mutex> guard(_mutex);
+    ++_stats.loads;
+
+    auto it = _byContent.find(h);
+    if(it == _byContent.end() || it->second.nbVertex != data.nbVertex || it->second.nbIndex != data.nbIndex)
+        return nullptr;
+
+    std::shared_ptr<renderer::MeshBuffers> buffers = it->second.buffers.lock();
+    if(!buffers)
+        return nullptr;
+
+    _byFile[{ file, flags }] = h;
+    ++_stats.contentHits;
+    _stats.gpuBytesSaved += it->second.gpuBytes;
+    _stats.cpuBytesSaved += keepData && buffers->cpuData() ? it->second.cpuBytes : 0;
+    return buffers;
+}
+
+void GeometryCache::add(const std::string& file, const renderer::MeshData& data, uint flags, const std::shared_ptr<renderer::MeshBuffers>& buffers, size_t gpuBytes)
+{
+    const uint64_t h = contentKey(data, flags);
+
+    std::lock_guard<std::mutex> guard(_mutex);
+
+    // a live entry (same content loaded at the same time) is kept
+    Entry& e = _byContent[h];
+    if(e.buffers.expired())
+        e = { buffers, data.nbVertex, data.nbIndex, gpuBytes, cpuBytes(data) };
+    else if(e.nbVertex != data.nbVertex || e.nbIndex != data.nbIndex)
+        return;
+
+    _byFile[{ file, flags }] = h;
+
+    if(_byContent.size() + _byFile.size() > _pruneSize)
+        prune();
+}
+
+void GeometryCache::prune()
+{
+    for(auto it = _byContent.begin() ; it != _byContent.end() ; )
+    {
+        if(it->second.buffers.expired()) it = _byContent.erase(it);
+        else ++it;
+    }
+
+    for(auto it = _byFile.begin() ; it != _byFile.end() ; )
+    {
+        if(_byContent.count(it->second) == 0) it = _byFile.erase(it);
+        else ++it;
+    }
+
+    _pruneSize = std::max<size_t>(64, 2 * (_byContent.size() + _byFile.size()));
+}
+
+GeometryCache::Stats GeometryCache::stats()
+{
+    std::lock_guard<std::mutex> guard(_mutex);
+    return _stats;
+}
+
+void GeometryCache::printReport()
+{
+    const Stats s = stats();
+    LOG("Geometry cache: ", s.loads, " files read, ", s.fileHits, " requests served without reading, ", s.contentHits, " duplicated contents shared");
+    LOG("Geometry cache: ", s.gpuBytesSaved / 1024, " KB of gpu memory and ", s.cpuBytesSaved / 1024, " KB of cpu memory saved");
+
+    const resource::MeshLoader::GpuFormatStats f = resource::MeshLoader::gpuFormatStats();
+    LOG("Geometry formats: ", f.meshes, " meshes converted, ", f.packedMeshes, " with packed vertices, ", f.shortIndexMeshes, " with 16 bits indices, ",
+        f.bytes / 1024, " KB uploaded, ", f.bytesSaved / 1024, " KB saved");
+}
+
+}
+}
+#include "MemoryLoggerOff.h"
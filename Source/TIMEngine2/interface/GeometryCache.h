@@ -0,0 +1,70 @@
+#ifndef GEOMETRYCACHE_H_INCLUDED
+#define GEOMETRYCACHE_H_INCLUDED
+
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include "core/core.h"
+#include "renderer/MeshBuffers.h"
+
+#include "MemoryLoggerOn.h"
+namespace tim
+{
+    using namespace core;
+namespace interface
+{
+    /* The geometries loaded by the AssetManager by content hash of the processed mesh (MeshData::contentHash) and load flags
+     * (MeshLoader::LoadFlags, they change the vertex format and the volume), so a file requested again, or a copy of a mesh
+     * under another name, shares the gpu buffers and the cpu data.
+     * Only weak references are kept: a geometry no longer used is released as before.
+     * Two loads of the same content at the same time can still both upload, the second one is just not shared. Thread safe. */
+    class GeometryCache
+    {
+    public:
+        struct Stats
+        {
+            size_t loads = 0;            // files read
+            size_t fileHits = 0;         // served without reading the file
+            size_t contentHits = 0;      // read but the content was already loaded
+            size_t gpuBytesSaved = 0;
+            size_t cpuBytesSaved = 0;
+        };
+
+        /* Buffers of a file loaded with the same flags still in use, null if none or if they have no cpu data while it's needed */
+        static std::shared_ptr<renderer::MeshBuffers> findFile(const std::string& file, uint flags, bool needCpuData);
+
+        /* Buffers of the same content still in use, null if none. The data is no longer needed unless keepData
+         * is set and the buffers have no cpu data: it can then be given to them (MeshBuffers::setCpuData) */
+        static std::shared_ptr<renderer::MeshBuffers> find(const std::string& file, const renderer::MeshData&, uint flags, bool keepData);
+
+        /* Register buffers owning their data, gpuBytes is what a hit saves */
+        static void add(const std::string& file, const renderer::MeshData&, uint flags, const std::shared_ptr<renderer::MeshBuffers>&, size_t gpuBytes);
+
+        /* The hash of the data, computed if it didn't come from the file */
+        static uint64_t hash(const renderer::MeshData&);
+
+        static Stats stats();
+        static void printReport(); // and the gpu formats of the meshes (MeshLoader::gpuFormatStats)
+
+    private:
+        struct Entry
+        {
+            std::weak_ptr<renderer::MeshBuffers> buffers;
+            uint nbVertex, nbIndex; // against the collisions
+            size_t gpuBytes, cpuBytes;
+        };
+
+        static std::mutex _mutex;
+        static std::unordered_map<uint64_t, Entry> _byContent;
+        static std::map<std::pair<std::string, uint>, uint64_t> _byFile;
+        static size_t _pruneSize;
+        static Stats _stats;
+
+        static void prune();
+        static uint64_t contentKey(const renderer::MeshData&, uint flags);
+    };
+}
+}
+#include "MemoryLoggerOff.h"
+
+#endif // GEOMETRYCACHE_H_INCLUDED
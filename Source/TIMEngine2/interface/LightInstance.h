@@ -17,15 +17,15 @@ namespace interface
         friend class scene::BasicScene<scene::Transformable>;
 
     public:
-        void set(const renderer::LightContextRenderer::Light& l) { _light=l; setVolume(Sphere(_light.position, _light.radius)); }
+        void set(const renderer::LightContextRenderer::Light& l) { _light=l; setVolume(Sphere(_light.position, _light.radius)); markChanged(SimpleScene::Journal::PROPERTY); }
         void setPosition(const vec3& p) { _light.position = p; setVolume(Sphere(_light.position, _light.radius)); }
         void setRadius(float r) { _light.radius = r; setVolume(Sphere(_light.position, _light.radius)); }
-        void setColor(const vec4& c) { _light.color = c; }
-        void setPower(float p) { _light.power = p; }
+        void setColor(const vec4& c) { _light.color = c; markChanged(SimpleScene::Journal::PROPERTY); }
+        void setPower(float p) { _light.power = p; markChanged(SimpleScene::Journal::PROPERTY); }
 
         const renderer::LightContextRenderer::Light& get() const { return _light; }
 
-        void setTexture(const interface::Texture& tex) { _lightTex = tex; _light.tex = tex.texture(); }
+        void setTexture(const interface::Texture& tex) { _lightTex = tex; _light.tex = tex.texture(); markChanged(SimpleScene::Journal::PROPERTY); }
         const interface::Texture& texture() const { return _lightTex; }
 
     protected:
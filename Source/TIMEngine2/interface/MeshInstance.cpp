@@ -19,6 +19,7 @@ void MeshInstance::setMesh(const Mesh& m)
 {
     bool sameVolume = m.initialVolume() == _mesh.initialVolume();
     _mesh = m;
+    markChanged(SimpleScene::Journal::PROPERTY);
 
     if(!sameVolume)
         setMatrix(_model);
@@ -7,18 +7,35 @@ namespace tim
 namespace interface
 {
 
-void Particle::createPointRandVel(Particle& p, float, Rand& random)
+namespace
 {
-    p.position = vec3(0,0,0);
-    p.lifeTime = 3;
-    p.color = vec3(random.next_f(), random.next_f(), random.next_f()).saturated();
-    p.sizeXY_Z = vec3(vec2::construct(random.next_f()*0.01+0.01), 0);
-    p.alpha_rotation.x() = 1;
+    const size_t CHUNK = 64; // particles whose random values are drawn at once
+}
+
+void Particle::createPointRandVel(std::span<Particle* const> ps, float, Rand& random)
+{
+    float u[CHUNK * 5];
+    vec3 dir[CHUNK];
+
+    for(size_t i=0 ; i<ps.size() ; i+=CHUNK)
+    {
+        const size_t n = std::min(CHUNK, ps.size() - i);
+        random.fill_f(std::span<float>(u, n * 5));
+        random.fillOnUnitSphere(std::span<vec3>(dir, n));
+
+        for(size_t j=0 ; j<n ; ++j)
+        {
+            Particle& p = *ps[i+j];
+            const float* r = u + j*5;
 
-    float x=random.next_f()*PI;
-    float a=sinf(x);
-    float b=random.next_f()*PI*2;
-    p.vel = vec3(a*cosf(b), a*sinf(b), cosf(x))*random.next_f();
+            p.position = vec3(0,0,0);
+            p.lifeTime = 3;
+            p.color = vec3(r[0], r[1], r[2]).saturated();
+            p.sizeXY_Z = vec3(vec2::construct(r[3]*0.01+0.01), 0);
+            p.alpha_rotation.x() = 1;
+            p.vel = dir[j] * r[4];
+        }
+    }
 }
 
 void Particle::simpleGravity(Particle& p, float time, Rand&)
@@ -31,26 +48,46 @@ void Particle::simpleVel(Particle& p, float time, Rand&)
 {
     p.position += p.vel*time;
 }
-void Particle::createConeVel(Particle& p, float, Rand& random, const ParticleBornParameter& param)
+void Particle::createConeVel(std::span<Particle* const> ps, float, Rand& random, const ParticleBornParameter& param)
 {
-    p.position=vec3(0,0,0);
-    float longitude = 2*PI*random.next_f();
-    float colatitude = interpolate(param.userParam1.x(), param.userParam1.y(), random.next_f())*PI;
-    float sin_colatitude = sinf(colatitude);
-    p.vel = vec3(sin_colatitude*cosf(longitude), sin_colatitude*sinf(longitude), cosf(colatitude));
-    p.assignParameter(param, random);
+    float u[CHUNK * 6];
 
+    for(size_t i=0 ; i<ps.size() ; i+=CHUNK)
+    {
+        const size_t n = std::min(CHUNK, ps.size() - i);
+        random.fill_f(std::span<float>(u, n * 6));
+
+        for(size_t j=0 ; j<n ; ++j)
+        {
+            Particle& p = *ps[i+j];
+            const float* r = u + j*6;
+
+            p.position=vec3(0,0,0);
+            float longitude = 2*PI*r[0];
+            float colatitude = interpolate(param.userParam1.x(), param.userParam1.y(), r[1])*PI;
+            float sin_colatitude = sinf(colatitude);
+            p.vel = vec3(sin_colatitude*cosf(longitude), sin_colatitude*sinf(longitude), cosf(colatitude));
+            p.assignParameter(param, r + 2);
+        }
+    }
 }
 
 void Particle::assignParameter(const ParticleBornParameter& param, Rand& random)
 {
-    lifeTime = random.next_f(param.lifeTime);
+    float u[4];
+    random.fill_f(u);
+    assignParameter(param, u);
+}
+
+void Particle::assignParameter(const ParticleBornParameter& param, const float* u)
+{
+    lifeTime = param.lifeTime.x() + u[0] * std::max(0.f, param.lifeTime.y() - param.lifeTime.x());
 
-    vec4 col = interpolate(param.color_min, param.color_max, random.next_f());
+    vec4 col = interpolate(param.color_min, param.color_max, u[1]);
     color = vec3(col);
     alpha_rotation.x() = col.w();
-    sizeXY_Z = vec3(interpolate(param.size_min, param.size_max, random.next_f()), 0);
-    vel.resize(interpolate(param.vel.x(), param.vel.y(), random.next_f()));
+    sizeXY_Z = vec3(interpolate(param.size_min, param.size_max, u[2]), 0);
+    vel.resize(interpolate(param.vel.x(), param.vel.y(), u[3]));
 }
 
 }
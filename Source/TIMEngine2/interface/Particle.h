@@ -3,6 +3,7 @@
 
 #include "core/core.h"
 #include "core/Rand.h"
+#include <span>
 
 #include "MemoryLoggerOn.h"
 namespace tim
@@ -30,14 +31,16 @@ namespace interface
         float mass=1;
         vec3 vel;
 
-        /** Some particle function */
-        static void createPointRandVel(Particle& p, float time, Rand& random);
+        /** Some particle function, the creations get every particle born in the frame to draw their random values in bulk */
+        static void createPointRandVel(std::span<Particle* const> ps, float time, Rand& random);
         static void simpleGravity(Particle& p, float time, Rand& random);
         static void simpleVel(Particle& p, float time, Rand& random);
 
-        static void createConeVel(Particle& p, float time, Rand& random, const ParticleBornParameter& param);
+        static void createConeVel(std::span<Particle* const> ps, float time, Rand& random, const ParticleBornParameter& param);
 
         void assignParameter(const ParticleBornParameter& p, Rand& random);
+        /* u: 4 uniforms in [0,1) */
+        void assignParameter(const ParticleBornParameter& p, const float* u);
     };
 
     struct ParticleBornParameter
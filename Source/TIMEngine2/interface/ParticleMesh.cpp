@@ -8,13 +8,14 @@ namespace tim
 namespace interface
 {
 
-ParticleMesh::ParticleMesh(uint maxParticles, const std::function<TypeFunc>& fCreate, const std::function<TypeFunc>& fUpdate, int seed)
+ParticleMesh::ParticleMesh(uint maxParticles, const std::function<CreateFunc>& fCreate, const std::function<TypeFunc>& fUpdate, int seed)
         : _particles(new Particle[maxParticles]), _size(maxParticles),
           _rand(seed), _funCreate(fCreate), _funUpdate(fUpdate)
 {
     _mesh = new renderer::MeshBuffers(vertexBufferPool->alloc(maxParticles), indexBufferPool->alloc(maxParticles), nullptr, Sphere(vec3(0,0,0), 1));
     _geometry = new interface::Geometry(_mesh);
     _gpuData = new renderer::VNCT_Vertex[maxParticles];
+    _born.reserve(maxParticles);
 
     std::unique_ptr<uint[]> idat(new uint[maxParticles]);
     for(uint i=0 ; i<_size ; ++i)
@@ -58,11 +59,12 @@ void ParticleMesh::update(float time)
     {
         float nb = time*_flow;
         nbNewParticles = uint(nb);
-        if(_rand.frand() < fmodf(nb, 1.f))
+        if(_rand.next_f() < fmodf(nb, 1.f))
             ++nbNewParticles;
     }
     else nbNewParticles = 0xffff;
 
+    _born.clear();
     for(uint i=0 ; i<_size ; ++i)
     {
         if(_particles[i].lifeTime > 0)
@@ -75,11 +77,14 @@ void ParticleMesh::update(float time)
         {
             _particles[i].id = _currentId++;
             _particles[i].bornTime = 0;
-            _funCreate(_particles[i], _totalTime, _rand);
+            _born.push_back(&_particles[i]);
             --nbNewParticles;
         }
     }
 
+    if(!_born.empty())
+        _funCreate(_born, _totalTime, _rand);
+
 }
 
 void ParticleMesh::reset()
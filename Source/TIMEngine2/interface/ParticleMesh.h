@@ -19,8 +19,9 @@ namespace interface
     public:
 
         using TypeFunc = void(Particle&, float, Rand&);
+        using CreateFunc = void(std::span<Particle* const>, float, Rand&); // all the particles born in the update
 
-        ParticleMesh(uint, const std::function<TypeFunc>&, const std::function<TypeFunc>&, int seed=0);
+        ParticleMesh(uint, const std::function<CreateFunc>&, const std::function<TypeFunc>&, int seed=0);
         virtual ~ParticleMesh();
 
 //        void benchVolume(float time = 5, float tps = 0.1);
@@ -52,8 +53,9 @@ namespace interface
 
         float _flow = -1; // particles / sec
 
-        std::function<TypeFunc> _funCreate;
+        std::function<CreateFunc> _funCreate;
         std::function<TypeFunc> _funUpdate;
+        vector<Particle*> _born; // reserved for every particle
 
         #include "MemoryLoggerOff.h"
         ParticleMesh& operator=(const ParticleMesh&) = delete;
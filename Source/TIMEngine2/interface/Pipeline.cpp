@@ -47,19 +47,33 @@ void Pipeline::setOutputNode(Pipeline::TerminalNode& node)
 
 void Pipeline::prepare()
 {
+    TIM_ALLOC_SCOPE("Pipeline::prepare");
+    const AllocCounter::Stats start = AllocCounter::thread();
+
     for(uint i=0 ; i<_allProcessNodes.size() ; ++i)
         _allProcessNodes[i]->reset();
 
+    // previous frame is rendered, its temporaries can go
+    _frameArena.reset();
+
     if(_outputNode)
         _outputNode->prepare();
+
+    _prepareAllocs = AllocCounter::thread() - start;
 }
 
 void Pipeline::render()
 {
+    TIM_ALLOC_SCOPE("Pipeline::render");
+    const AllocCounter::Stats start = AllocCounter::thread();
+
     if(_outputNode)
         _outputNode->render();
 
     renderer::openGL.execAllGLTask();
+
+    _lastFrameAllocs = _prepareAllocs;
+    _lastFrameAllocs += AllocCounter::thread() - start;
 }
 
 void Pipeline::SceneView::offset(vec3 o)
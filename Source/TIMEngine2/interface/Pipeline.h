@@ -2,6 +2,7 @@
 #define PIPELINE_H
 
 #include "SpinLock.h"
+#include "LinearArena.h"
 #include "core.h"
 #include "Camera.h"
 #include "renderer/renderer.h"
@@ -42,6 +43,11 @@ namespace interface
         {
             SceneType scene;
             GlobalLight globalLight;
+
+            /* Cleared with the scene, the asynchronous loads into it (XmlSceneLoader::loadSceneAsync) check it before touching its objects */
+            std::shared_ptr<bool> alive = std::make_shared<bool>(true);
+
+            ~SceneEntity() { *alive = false; }
         };
 
         struct SceneView
@@ -105,6 +111,10 @@ namespace interface
             virtual void reset() { _alreadyPrepared = false; }
             virtual ~ProcessNode() {}
 
+            /* Temporaries of the node, valid until the next Pipeline::prepare() */
+            FrameArena& frameArena() const { TIM_ASSERT(_frameArena); return *_frameArena; }
+            FrameArena* _frameArena = nullptr;
+
             mutable SpinLock _preparedLock;
             mutable bool _alreadyPrepared = false;
 
@@ -123,7 +133,7 @@ namespace interface
         template<class Type>
         class CollectObjectNode : public ProcessNode
         {
-        public : virtual const vector<std::reference_wrapper<Type>>& get(int index = 0) const = 0;
+        public : virtual const ArenaVector<std::reference_wrapper<Type>>& get(int index = 0) const = 0;
         };
 
         class RendererNode : virtual public ProcessNode
@@ -307,7 +317,7 @@ namespace interface
         Pipeline();
         ~Pipeline();
 
-        void registerNode(ProcessNode* node) { _allProcessNodes.push_back(node); }
+        void registerNode(ProcessNode* node) { node->_frameArena = &_frameArena; _allProcessNodes.push_back(node); }
 
         renderer::MeshRenderer& meshRenderer();
 
@@ -317,7 +327,7 @@ namespace interface
         typename std::enable_if<std::is_default_constructible<T>::value, T>::type& createNode()
         {
             T* node = new T;
-            _allProcessNodes.push_back(node);
+            registerNode(node);
             return *node;
         }
 
@@ -325,7 +335,7 @@ namespace interface
         typename std::enable_if<std::is_constructible<T, renderer::MeshRenderer&>::value, T>::type& createNode()
         {
             T* node = new T(_meshRenderer);
-            _allProcessNodes.push_back(node);
+            registerNode(node);
             return *node;
         }
 
@@ -333,7 +343,7 @@ namespace interface
         typename std::enable_if<std::is_constructible<T, const renderer::FrameParameter&>::value, T>::type& createNode()
         {
             T* node = new T(_meshRenderer.frameParameter());
-            _allProcessNodes.push_back(node);
+            registerNode(node);
             return *node;
         }
 
@@ -342,13 +352,21 @@ namespace interface
         void prepare();
         void render();
 
+        /* Heap allocations done by prepare() and render() for the last frame (0 if not TIM_MEMORY_TRACKING) */
+        AllocCounter::Stats lastFrameAllocations() const { return _lastFrameAllocs; }
+
+        const FrameArena& frameArena() const { return _frameArena; }
+
     private:
         renderer::MeshRenderer _meshRenderer;
 
         std::map<std::tuple<uivec2,bool,bool,int>, std::unique_ptr<DeferredRendererEntity>> _deferredRendererEntity;
 
         vector<ProcessNode*> _allProcessNodes;
+        FrameArena _frameArena;
         TerminalNode* _outputNode = nullptr;
+
+        AllocCounter::Stats _prepareAllocs, _lastFrameAllocs;
     };
 
 }
@@ -0,0 +1,288 @@
+#include "RayCaster.h"
+#include "ThreadPool.h"
+
+#include "MemoryLoggerOn.h"
+namespace tim
+{
+    using namespace core;
+namespace interface
+{
+
+namespace
+{
+    const uint MAX_DEPTH = 64;
+
+    /* Entry distance of the ray in the box, FLT_MAX if missed */
+    float hitBox(const vec3& boxMin, const vec3& boxMax, const vec3& origin, const vec3& invDir, float maxDist)
+    {
+        float tmin = 0, tmax = maxDist;
+        for(int i=0 ; i<3 ; ++i)
+        {
+            float t0 = (boxMin[i] - origin[i]) * invDir[i];
+            float t1 = (boxMax[i] - origin[i]) * invDir[i];
+            if(t0 > t1) std::swap(t0, t1);
+
+            // NaN (0 * inf, on the plane of a face) is ignored by the comparisons
+            tmin = t0 > tmin ? t0 : tmin;
+            tmax = t1 < tmax ? t1 : tmax;
+        }
+        return tmin <= tmax ? tmin : FLT_MAX;
+    }
+
+    /* Same convention as Sphere::collide: the entry point, the exit point if the origin is inside */
+    bool hitSphere(const Sphere& s, const vec3& o, const vec3& dir, float& t)
+    {
+        const vec3 diff = o - s.center();
+        const float dotLD = dir.dot(diff);
+        const float toSqrt = dotLD*dotLD - diff.length2() + s.radius()*s.radius();
+        if(toSqrt < 0)
+            return false;
+
+        t = -dotLD - sqrtf(toSqrt);
+        if(t < 0)
+            t = -dotLD + sqrtf(toSqrt);
+        return t >= 0;
+    }
+
+    /* Moller-Trumbore, both faces */
+    bool hitTriangle(const vec3& o, const vec3& dir, const vec3& a, const vec3& b, const vec3& c, float& t)
+    {
+        const vec3 e1 = b - a, e2 = c - a;
+        const vec3 p = dir.cross(e2);
+        const float det = e1.dot(p);
+        if(fabsf(det) < 1e-12f)
+            return false;
+
+        const float invDet = 1.f / det;
+        const vec3 s = o - a;
+        const float u = s.dot(p) * invDet;
+        if(u < 0 || u > 1)
+            return false;
+
+        const vec3 q = s.cross(e1);
+        const float v = dir.dot(q) * invDet;
+        if(v < 0 || u + v > 1)
+            return false;
+
+        t = e2.dot(q) * invDet;
+        return t >= 0;
+    }
+}
+
+void RayCaster::build(const SimpleScene& scene)
+{
+    _nodes.clear();
+    _instances.clear();
+
+    for(scene::Transformable* t : scene.objects<MeshInstance>())
+    {
+        MeshInstance* inst = static_cast<MeshInstance*>(t);
+        if(inst->enabled())
+            _instances.push_back({ inst, inst->volume(), inst->matrix().inverted() });
+    }
+
+    if(!_instances.empty())
+    {
+        _nodes.reserve(2 * (_instances.size() / LEAF_SIZE + 1));
+        buildNode(0, _instances.size());
+    }
+}
+
+void RayCaster::buildNode(uint begin, uint end)
+{
+    vec3 boxMin = vec3::construct(FLT_MAX), boxMax = vec3::construct(-FLT_MAX);
+    vec3 cMin = boxMin, cMax = boxMax;
+    for(uint i=begin ; i<end ; ++i)
+    {
+        const Sphere& s = _instances[i].volume;
+        for(int j=0 ; j<3 ; ++j)
+        {
+            boxMin[j] = std::min(boxMin[j], s.center()[j] - s.radius());
+            boxMax[j] = std::max(boxMax[j], s.center()[j] + s.radius());
+            cMin[j] = std::min(cMin[j], s.center()[j]);
+            cMax[j] = std::max(cMax[j], s.center()[j]);
+        }
+    }
+
+    const uint index = _nodes.size();
+    _nodes.push_back({ boxMin, boxMax, begin, end - begin });
+
+    if(end - begin <= LEAF_SIZE)
+        return;
+
+    // median split on the longest axis of the centers
+    const vec3 extent = cMax - cMin;
+    const int axis = extent.x() > extent.y() ? (extent.x() > extent.z() ? 0 : 2) : (extent.y() > extent.z() ? 1 : 2);
+    const uint mid = (begin + end) / 2;
+    std::nth_element(_instances.begin() + begin, _instances.begin() + mid, _instances.begin() + end,
+                     [axis](const Instance& a, const Instance& b) { return a.volume.center()[axis] < b.volume.center()[axis]; });
+
+    buildNode(begin, mid);
+    _nodes[index].first = _nodes.size();
+    _nodes[index].count = 0;
+    buildNode(mid, end);
+}
+
+bool RayCaster::hitInstance(const Instance& inst, const Ray& ray, Precision prec, float maxDist, RayHit& hit) const
+{
+    // the sphere bounds the triangles, a ray missing it can't hit them
+    float t;
+    if(!hitSphere(inst.volume, ray.origin, ray.dir, t))
+        return false;
+
+    const Mesh& mesh = inst.instance->mesh();
+
+    if(prec == TRIANGLE)
+    {
+        // the ray in the space of the mesh, the distances stay the same since the direction isn't normalized
+        const vec3 o = inst.invMatrix * ray.origin;
+        const vec3 dir = inst.invMatrix.down<1>() * ray.dir;
+
+        bool found = false, sphereFallback = false;
+        for(uint e=0 ; e<mesh.nbElements() ; ++e)
+        {
+            const Mesh::Element& elem = mesh.element(e);
+            if(!elem.isEnable())
+                continue;
+
+            const renderer::MeshData* data = elem.geometry().isEmpty() ? nullptr : elem.geometry().meshData();
+            if(!data || !data->vData || !data->indexData)
+            {
+                sphereFallback = true;
+                continue;
+            }
+
+            for(uint i=0 ; i+2<data->nbIndex ; i+=3)
+            {
+                const vec3& a = data->vData[data->indexData[i]].v;
+                const vec3& b = data->vData[data->indexData[i+1]].v;
+                const vec3& c = data->vData[data->indexData[i+2]].v;
+
+                float tt;
+                if(hitTriangle(o, dir, a, b, c, tt) && tt <= maxDist)
+                {
+                    maxDist = tt;
+                    found = true;
+                    hit.element = e;
+                    hit.triangle = i / 3;
+
+                    // normals go back to world space with the inverse transpose
+                    const vec3 n = (b - a).cross(c - a);
+                    hit.normal = inst.invMatrix.down<1>().transposed() * n;
+                }
+            }
+        }
+
+        if(found)
+        {
+            hit.instance = inst.instance;
+            hit.distance = maxDist;
+            hit.position = ray.origin + ray.dir * maxDist;
+            hit.normal.normalize();
+            if(hit.normal.dot(ray.dir) > 0)
+                hit.normal = -hit.normal;
+            return true;
+        }
+
+        if(!sphereFallback)
+            return false;
+    }
+
+    if(t > maxDist)
+        return false;
+
+    hit.instance = inst.instance;
+    hit.distance = t;
+    hit.position = ray.origin + ray.dir * t;
+    hit.normal = (hit.position - inst.volume.center()).normalized();
+    hit.element = hit.triangle = 0;
+    return true;
+}
+
+RayHit RayCaster::cast(const Ray& ray, Mode mode, Precision prec) const
+{
+    RayHit best;
+    if(_nodes.empty())
+        return best;
+
+    vec3 invDir;
+    for(int i=0 ; i<3 ; ++i)
+        invDir[i] = 1.f / ray.dir[i];
+
+    float maxDist = ray.maxDistance;
+
+    // nodes to visit with the entry distance in their box, the ones beyond the nearest hit are skipped
+    struct Entry { uint node; float t; };
+    Entry stack[MAX_DEPTH];
+    uint stackSize = 0;
+
+    const float tRoot = hitBox(_nodes[0].boxMin, _nodes[0].boxMax, ray.origin, invDir, maxDist);
+    if(tRoot != FLT_MAX)
+        stack[stackSize++] = { 0, tRoot };
+
+    while(stackSize > 0)
+    {
+        const Entry entry = stack[--stackSize];
+        if(entry.t > maxDist)
+            continue;
+
+        const Node& node = _nodes[entry.node];
+
+        if(node.count > 0)
+        {
+            for(uint i=node.first ; i<node.first+node.count ; ++i)
+            {
+                RayHit hit;
+                if(hitInstance(_instances[i], ray, prec, maxDist, hit))
+                {
+                    best = hit;
+                    maxDist = hit.distance;
+                    if(mode == ANY)
+                        return best;
+                }
+            }
+        }
+        else
+        {
+            // the nearest child is popped first so the farther one is likely pruned
+            const uint left = entry.node + 1, right = node.first;
+            const float tl = hitBox(_nodes[left].boxMin, _nodes[left].boxMax, ray.origin, invDir, maxDist);
+            const float tr = hitBox(_nodes[right].boxMin, _nodes[right].boxMax, ray.origin, invDir, maxDist);
+
+            if(tl <= tr)
+            {
+                if(tr != FLT_MAX) stack[stackSize++] = { right, tr };
+                if(tl != FLT_MAX) stack[stackSize++] = { left, tl };
+            }
+            else
+            {
+                if(tl != FLT_MAX) stack[stackSize++] = { left, tl };
+                stack[stackSize++] = { right, tr };
+            }
+        }
+    }
+
+    return best;
+}
+
+void RayCaster::cast(std::span<const Ray> rays, std::span<RayHit> hits, Mode mode, Precision prec, ThreadPool* pool) const
+{
+    TIM_ASSERT(hits.size() >= rays.size());
+
+    if(pool && rays.size() >= 256)
+        pool->parallelFor(0, rays.size(), 64, [&](size_t i) { hits[i] = cast(rays[i], mode, prec); });
+    else
+    {
+        for(size_t i=0 ; i<rays.size() ; ++i)
+            hits[i] = cast(rays[i], mode, prec);
+    }
+}
+
+bool RayCaster::occluded(const vec3& a, const vec3& b, Precision prec) const
+{
+    return cast(Ray::segment(a, b), ANY, prec).hit();
+}
+
+}
+}
+#include "MemoryLoggerOff.h"
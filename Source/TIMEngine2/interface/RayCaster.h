@@ -0,0 +1,87 @@
+#ifndef RAYCASTER_H_INCLUDED
+#define RAYCASTER_H_INCLUDED
+
+#include <cfloat>
+#include <span>
+#include "core.h"
+#include "MeshInstance.h"
+
+#include "MemoryLoggerOn.h"
+namespace tim
+{
+    using namespace core;
+namespace interface
+{
+    struct Ray
+    {
+        Ray() = default;
+        Ray(const vec3& o, const vec3& d, float maxDist = FLT_MAX) : origin(o), dir(d.normalized()), maxDistance(maxDist) {}
+
+        static Ray segment(const vec3& a, const vec3& b) { return Ray(a, b-a, (b-a).length()); }
+
+        vec3 origin, dir; // dir is normalized
+        float maxDistance = FLT_MAX;
+    };
+
+    struct RayHit
+    {
+        MeshInstance* instance = nullptr;
+        float distance = FLT_MAX;
+        vec3 position, normal;
+
+        /* Hit triangle, only with TRIANGLE precision */
+        uint element = 0, triangle = 0;
+
+        bool hit() const { return instance != nullptr; }
+    };
+
+    /* Ray casts against the MeshInstances of a scene, accelerated by a BVH on their bounding volumes.
+     * The BVH is a snapshot: build() again when instances are added, removed or moved.
+     * SPHERE precision hits the bounding spheres, TRIANGLE precision refines to the triangles of the cpu data
+     * of the geometries (elements without cpu data are hit on their instance sphere).
+     * Casts are const and can run from several threads at once. */
+    class RayCaster
+    {
+    public:
+        enum Mode { NEAREST, ANY };
+        enum Precision { SPHERE, TRIANGLE };
+
+        static constexpr uint LEAF_SIZE = 4;
+
+        void build(const SimpleScene&);
+
+        RayHit cast(const Ray&, Mode mode = NEAREST, Precision prec = TRIANGLE) const;
+
+        /* hits[i] is the result of rays[i], big batches are split on the pool if one is given */
+        void cast(std::span<const Ray> rays, std::span<RayHit> hits, Mode mode = NEAREST, Precision prec = TRIANGLE, ThreadPool* pool = nullptr) const;
+
+        /* Any hit on the segment [a,b], for line of sight tests */
+        bool occluded(const vec3& a, const vec3& b, Precision prec = TRIANGLE) const;
+
+        size_t size() const { return _instances.size(); }
+
+    private:
+        struct Node
+        {
+            vec3 boxMin, boxMax;
+            uint first, count; // leaf: range in _instances, inner (count == 0): first is the right child, the left one is the next node
+        };
+
+        struct Instance
+        {
+            MeshInstance* instance;
+            Sphere volume;
+            mat4 invMatrix;
+        };
+
+        vector<Node> _nodes;
+        vector<Instance> _instances;
+
+        void buildNode(uint begin, uint end);
+        bool hitInstance(const Instance&, const Ray&, Precision, float maxDist, RayHit&) const;
+    };
+}
+}
+#include "MemoryLoggerOff.h"
+
+#endif // RAYCASTER_H_INCLUDED
@@ -45,6 +45,7 @@ namespace interface
         inline static const renderer::Texture::GenTexParam sDefaultConfig = Texture::genParam(true, true, true, 4);
 
         uint64_t handle() const { return _ptr->handle(); }
+        size_t bytes() const { if(!texture()) return 0; return _ptr->bytes(); }
 
     protected:
         renderer::Texture* texture() const { return _ptr.get(); }
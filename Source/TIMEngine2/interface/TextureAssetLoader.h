@@ -18,30 +18,58 @@ namespace resource
         template<bool async>
         Option<interface::Texture> operator()(std::string file, renderer::Texture::GenTexParam param)
         {
-            static_assert(!async, "Async texture loading not supported");
+            static_assert(!async, "Async texture loading not supported, use AssetManager::loadAsync");
+
+            Staged staged = prepare(file, param);
+            return finish(staged);
+        }
+
+        /* Load in two parts for the LoadQueue */
+        struct Staged
+        {
+            renderer::Texture::GenTexParam param;
+            TextureLoader::ImageFormat format;
+            ubyte* data = nullptr;
+        };
+
+        /* Decode, any thread */
+        static Staged prepare(std::string file, renderer::Texture::GenTexParam param)
+        {
+            Staged staged;
+            staged.param = param;
 
             if(resource::textureLoader == nullptr)
             {
                 LOG_EXT("resource::textureLoader is null");
-                return Option<interface::Texture>();
+                return staged;
             }
 
-            TextureLoader::ImageFormat imgLoaded;
-            ubyte* texData = resource::textureLoader->loadImage(file, imgLoaded);
-            param.size = uivec3(imgLoaded.size,0);
+            staged.data = resource::textureLoader->loadImage(file, staged.format);
+            staged.param.size = uivec3(staged.format.size,0);
 
-            if(!texData)
-            {
+            if(!staged.data)
                 LOG_EXT("Unable to load texture ", file);
+            return staged;
+        }
+
+        /* Upload, gl thread */
+        static Option<interface::Texture> finish(Staged& staged)
+        {
+            if(!staged.data)
                 return Option<interface::Texture>();
-            }
 
-            renderer::Texture* tex = renderer::Texture::genTexture2D(param, texData, imgLoaded.nbComponent);
+            renderer::Texture* tex = renderer::Texture::genTexture2D(staged.param, staged.data, staged.format.nbComponent);
             tex->makeBindless();
-            delete[] texData;
+            discard(staged);
             return Option<interface::Texture>(tex);
         }
 
+        static void discard(Staged& staged)
+        {
+            delete[] staged.data;
+            staged.data = nullptr;
+        }
+
         template<bool async>
         Option<interface::Texture> operator()(const vector<std::string>& file, renderer::Texture::GenTexParam param)
         {
@@ -2,6 +2,8 @@
 
 #include "interface/ShaderPool.h"
 #include "resource/AssetManager.h"
+#include "resource/MeshLoader.h"
+#include "FileSystem.h"
 
 #include "MemoryLoggerOn.h"
 namespace tim
@@ -19,7 +21,11 @@ bool XmlMeshAssetLoader::load(std::string filename)
     TiXmlDocument doc(filename);
     _xmlFile = filename;
 
-    if (!doc.LoadFile()) {
+    std::string text;
+    if (FileSystem::readText(filename, text))
+        doc.Parse(text.c_str());
+
+    if (text.empty() || doc.Error()) {
         LOG("Fail to load xml file ", filename);
         return false;
     }
@@ -64,42 +70,109 @@ interface::Mesh XmlMeshAssetLoader::constructMesh(const vector<MeshElementModel>
     Mesh mesh;
     for(uint i=0 ; i<model.size() ; ++i)
     {
-        Mesh::Element elem;
+        Option<Geometry> geometry;
+        Option<Texture> textures[3];
         if(model[i].type==0)
         {
-            elem.setColor(vec4(model[i].color,1));
-            elem.setRoughness(model[i].material[0]);
-            elem.setMetallic(model[i].material[1]);
-            elem.setSpecular(model[i].material[2]);
-            elem.setEmissive(model[i].material[3]);
-            elem.setTextureScale(model[i].textureScale);
-
             if(!model[i].geometry.empty())
-                elem.setGeometry(resource::AssetManager<Geometry>::instance().load<false>(model[i].geometry, loadMeshMode).value());
+                geometry = resource::AssetManager<Geometry>::instance().load<false>(model[i].geometry, loadMeshMode, model[i].geometryFlags);
 
             for(int j=0 ; j<3 ; ++j)
             {
                 if(!model[i].textures[j].empty())
-                    elem.setTexture(resource::AssetManager<Texture>::instance().load<false>(model[i].textures[j], texParam).value(), j);
+                    textures[j] = resource::AssetManager<Texture>::instance().load<false>(model[i].textures[j], texParam);
             }
+        }
+        mesh.addElement(constructElement(model[i], geometry, textures));
+    }
 
-            if(!model[i].useAdvanced)
-                elem.drawState().setShader(interface::ShaderPool::instance().get("gPass"));
-            else
+    return mesh;
+}
+
+resource::LoadQueue::Group XmlMeshAssetLoader::constructMeshAsync(const vector<MeshElementModel>& model, const renderer::Texture::GenTexParam& texParam,
+                                                                  std::function<void(interface::Mesh)> f, int priority, bool loadMeshMode)
+{
+    struct ElementHandles
+    {
+        resource::AssetManager<Geometry>::Handle geometry;
+        resource::AssetManager<Texture>::Handle textures[3];
+    };
+    auto handles = std::make_shared<vector<ElementHandles>>(model.size());
+
+    // an element is a group of its geometry and textures, the mesh the group of all of them
+    resource::LoadQueue::Group group;
+    for(uint i=0 ; i<model.size() ; ++i)
+    {
+        if(model[i].type != 0)
+            continue;
+
+        ElementHandles& h = (*handles)[i];
+        if(!model[i].geometry.empty())
+        {
+            h.geometry = resource::AssetManager<Geometry>::instance().loadAsync(priority, model[i].geometry, loadMeshMode, model[i].geometryFlags);
+            group.add(h.geometry);
+        }
+
+        for(int j=0 ; j<3 ; ++j)
+        {
+            if(!model[i].textures[j].empty())
             {
-                elem.drawState() = model[i].advanced;
-                if(model[i].advancedShader.empty())
-                    elem.drawState().setShader(interface::ShaderPool::instance().get("gPass"));
-                else
-                    elem.drawState().setShader(interface::ShaderPool::instance().get(model[i].advancedShader));
+                h.textures[j] = resource::AssetManager<Texture>::instance().loadAsync(priority, model[i].textures[j], texParam);
+                group.add(h.textures[j]);
             }
         }
-        elem.setCastShadow(model[i].castShadow);
-        elem.setCubemapAffected(model[i].cmAffected);
-        mesh.addElement(elem);
     }
 
-    return mesh;
+    group.onComplete([model, handles, f](bool)
+    {
+        Mesh mesh;
+        for(uint i=0 ; i<model.size() ; ++i)
+        {
+            const ElementHandles& h = (*handles)[i];
+            Option<Texture> textures[3] = { h.textures[0].value(), h.textures[1].value(), h.textures[2].value() };
+            mesh.addElement(constructElement(model[i], h.geometry.value(), textures));
+        }
+        f(mesh);
+    });
+
+    return group;
+}
+
+Mesh::Element XmlMeshAssetLoader::constructElement(const MeshElementModel& model, const Option<Geometry>& geometry, const Option<Texture> textures[3])
+{
+    Mesh::Element elem;
+    if(model.type==0)
+    {
+        elem.setColor(vec4(model.color,1));
+        elem.setRoughness(model.material[0]);
+        elem.setMetallic(model.material[1]);
+        elem.setSpecular(model.material[2]);
+        elem.setEmissive(model.material[3]);
+        elem.setTextureScale(model.textureScale);
+
+        if(geometry)
+            elem.setGeometry(geometry.value());
+
+        for(int j=0 ; j<3 ; ++j)
+        {
+            if(textures[j])
+                elem.setTexture(textures[j].value(), j);
+        }
+
+        if(!model.useAdvanced)
+            elem.drawState().setShader(interface::ShaderPool::instance().get("gPass"));
+        else
+        {
+            elem.drawState() = model.advanced;
+            if(model.advancedShader.empty())
+                elem.drawState().setShader(interface::ShaderPool::instance().get("gPass"));
+            else
+                elem.drawState().setShader(interface::ShaderPool::instance().get(model.advancedShader));
+        }
+    }
+    elem.setCastShadow(model.castShadow);
+    elem.setCubemapAffected(model.cmAffected);
+    return elem;
 }
 
 vector<XmlMeshAssetLoader::MeshElementModel> XmlMeshAssetLoader::parseMeshAssetElement(TiXmlElement* node, std::string& name)
@@ -125,7 +198,13 @@ vector<XmlMeshAssetLoader::MeshElementModel> XmlMeshAssetLoader::parseMeshAssetE
                     if(StringUtils(elem->ValueStr()).toLower().str() == "color")
                         elementModel.color = toColor(StringUtils::str(elem->GetText()));
                     else if(StringUtils(elem->ValueStr()).toLower().str() == "geometry")
+                    {
                         elementModel.geometry = StringUtils::str(elem->GetText());
+                        if(StringUtils(StringUtils::str(elem->Attribute("ritterSphere"))).toBool())
+                            elementModel.geometryFlags |= resource::MeshLoader::RITTER_SPHERE;
+                        if(StringUtils(StringUtils::str(elem->Attribute("packed"))).toBool())
+                            elementModel.geometryFlags |= resource::MeshLoader::PACKED_VERTEX;
+                    }
 
                     else if(StringUtils(elem->ValueStr()).toLower().str() == "roughness")
                         elementModel.material[0] = StringUtils(StringUtils::str(elem->GetText())).toFloat();
@@ -5,6 +5,7 @@
 #include "core/core.h"
 #include "interface/Mesh.h"
 #include "renderer/DrawState.h"
+#include "resource/LoadQueue.h"
 
 #include "MemoryLoggerOn.h"
 #undef interface
@@ -26,6 +27,7 @@ namespace interface
             float textureScale = 1;
             std::string textures[3];
             std::string geometry;
+            uint geometryFlags = 0; // resource::MeshLoader::LoadFlags
 
             bool useAdvanced = false;
             std::string advancedShader;
@@ -42,6 +44,11 @@ namespace interface
 
         static interface::Mesh constructMesh(const vector<MeshElementModel>&, const renderer::Texture::GenTexParam&, bool keepData=true);
 
+        /* Same on the LoadQueue: the geometries and textures load in parallel, f gets the mesh on the gl thread once they're
+         * all finished (an asset failing is left empty). The group can be reprioritized or cancelled while it loads. */
+        static resource::LoadQueue::Group constructMeshAsync(const vector<MeshElementModel>&, const renderer::Texture::GenTexParam&,
+                                                             std::function<void(interface::Mesh)> f, int priority = 0, bool keepData=true);
+
         const std::map<std::string, vector<MeshElementModel>>& allAssets() const { return _models; }
 
         static vector<MeshElementModel> parseMeshAssetElement(TiXmlElement*, std::string& name);
@@ -51,6 +58,7 @@ namespace interface
         std::map<std::string, vector<MeshElementModel>> _models;
 
         static vec3 toColor(std::string);
+        static Mesh::Element constructElement(const MeshElementModel&, const Option<Geometry>&, const Option<Texture> textures[3]);
     };
 
 }
@@ -1,5 +1,6 @@
 #include "XmlSceneLoader.h"
 #include "ShaderPool.h"
+#include "FileSystem.h"
 
 #include "MemoryLoggerOn.h"
 namespace tim
@@ -8,10 +9,28 @@ namespace interface
 {
 
 bool XmlSceneLoader::loadScene(std::string file, interface::Scene& scene, vector<ObjectLoaded>& objects)
+{
+    return load(file, scene, objects, nullptr, 0);
+}
+
+resource::LoadQueue::Group XmlSceneLoader::loadSceneAsync(std::string file, interface::Scene& scene, vector<ObjectLoaded>& objects, int priority)
+{
+    resource::LoadQueue::Group group;
+    if(!load(file, scene, objects, &group, priority))
+        return resource::LoadQueue::Group();
+    return group;
+}
+
+bool XmlSceneLoader::load(std::string file, interface::Scene& scene, vector<ObjectLoaded>& objects, resource::LoadQueue::Group* async, int priority)
 {
     TiXmlDocument doc(file);
 
-    if (!doc.LoadFile()) {
+    // through FileSystem, the file can be in a mounted archive
+    std::string text;
+    if (FileSystem::readText(file, text))
+        doc.Parse(text.c_str());
+
+    if (text.empty() || doc.Error()) {
         LOG("Fail to load scene ", file);
         return false;
     }
@@ -60,6 +79,7 @@ bool XmlSceneLoader::loadScene(std::string file, interface::Scene& scene, vector
 
     elem = root;
     vector<std::string> skybox;
+    std::map<int, vector<MeshInstance*>> asyncInstances; // by mesh asset, constructed once for all its objects
 
     while(elem)
     {
@@ -102,7 +122,13 @@ bool XmlSceneLoader::loadScene(std::string file, interface::Scene& scene, vector
             obj.translation = tr;
             obj.rotation = rot;
 
-            if (isVisible) {
+            if (isVisible && async) {
+                obj.meshInstance = &scene.scene.add<MeshInstance>(mat4::constructTransformation(rot, tr, sc));
+                obj.meshInstance->setUseShadowLOD(useShadowLOD);
+                obj.meshInstance->setUseVisualLOD(useVisualLOD);
+                asyncInstances[index].push_back(obj.meshInstance);
+            }
+            else if (isVisible) {
                 obj.meshInstance = &scene.scene.add<MeshInstance>(XmlMeshAssetLoader::constructMesh(meshAssets[index], Texture::genParam(true, true, true, 0), false),
                                                                   mat4::constructTransformation(rot, tr, sc));
                 obj.meshInstance->setUseShadowLOD(useShadowLOD);
@@ -121,6 +147,23 @@ bool XmlSceneLoader::loadScene(std::string file, interface::Scene& scene, vector
         elem=elem->NextSiblingElement();
     }
 
+    for(auto& instances : asyncInstances)
+    {
+        resource::LoadQueue::Group meshGroup = XmlMeshAssetLoader::constructMeshAsync(meshAssets[instances.first], Texture::genParam(true, true, true, 0),
+            [inst = std::move(instances.second), alive = scene.alive](Mesh mesh)
+            {
+                // the scene can be gone before its meshes are loaded
+                if(!*alive)
+                    return;
+
+                for(MeshInstance* m : inst)
+                    m->setMesh(mesh);
+            }, priority, false);
+
+        // the meshes are set before the scene group completes, their callbacks are registered first
+        async->add(meshGroup);
+    }
+
     if(skybox.size() == 6)
     {
         scene.globalLight.skybox = renderer::IndirectLightRenderer::loadAndProcessSkybox(skybox, ShaderPool::instance().get("processSpecularCubeMap"));
@@ -48,10 +48,17 @@ namespace interface
 
         static bool loadScene(std::string, interface::Scene&, vector<ObjectLoaded>&);
 
+        /* Same, the objects are added right away with an empty mesh which is set once its assets are loaded on the LoadQueue
+         * (XmlMeshAssetLoader::constructMeshAsync). The group is complete when every mesh is set, the objects must stay
+         * in the scene until then; the meshes are dropped if the scene is destroyed before. Empty group if the file can't be read. */
+        static resource::LoadQueue::Group loadSceneAsync(std::string, interface::Scene&, vector<ObjectLoaded>&, int priority = 0);
+
         static void parseTransformation(TiXmlElement* elem, vec3& tr, vec3& sc, mat3& rot, Collider* collider);
         static vector<std::string> parseSkyboxXmlElement(TiXmlElement* elem);
 
     private:
+        static bool load(std::string, interface::Scene&, vector<ObjectLoaded>&, resource::LoadQueue::Group* async, int priority);
+
         #include "MemoryLoggerOff.h"
         XmlSceneLoader() = delete;
         #include "MemoryLoggerOn.h"
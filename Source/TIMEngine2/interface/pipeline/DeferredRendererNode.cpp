@@ -31,9 +31,10 @@ void DeferredRendererNode::setScissorTest(bool b, vec2 coord, vec2 size)
 void DeferredRendererNode::prepare()
 {
     if(!tryPrepare()) return;
+    TIM_ALLOC_SCOPE("DeferredRendererNode::prepare");
 
-    _culledLight.clear();
-    _toDraw.clear();
+    _culledLight = frameArena().makeVector<std::reference_wrapper<LightInstance>>(_culledLight.size());
+    _toDraw = frameArena().makeVector<ElementInstance>(_toDraw.size());
 
     for(size_t i=0 ; i<_meshInstanceSource.size() ; ++i)
     {
@@ -74,6 +75,7 @@ void DeferredRendererNode::prepare()
 void DeferredRendererNode::render()
 {
     if(!tryRender()) return;
+    TIM_ALLOC_SCOPE("DeferredRendererNode::render");
 
     if(_rendererEntity == nullptr)
         return;
@@ -106,15 +108,18 @@ void DeferredRendererNode::render()
         if(_useClipPlan[i]) glEnable(GL_CLIP_DISTANCE0+i);
         else glDisable(GL_CLIP_DISTANCE0+i);
 
-    std::set<Shader*> alreadyUsed;
+    LinearArena& arena = frameArena().local();
+    ArenaVector<Shader*> alreadyUsed{ArenaAllocator<Shader*>(arena)};
 
     if(!_toDraw.empty())
     {
-        vector<mat4> accMatr;
-        vector<renderer::MeshBuffers*> accMesh;
-        vector<renderer::DummyMaterial> accMate;
-        vector<vector<uint>> accExtraUbo;
-        vector<bool> accUseIndexBufferLOD;
+        // batches are consecutive in _toDraw, so the arrays are reused from the start for each batch
+        std::span<mat4> accMatr = arena.allocArray<mat4>(_toDraw.size());
+        std::span<renderer::MeshBuffers*> accMesh = arena.allocArray<renderer::MeshBuffers*>(_toDraw.size());
+        std::span<renderer::DummyMaterial> accMate = arena.allocArray<renderer::DummyMaterial>(_toDraw.size());
+        std::span<const vector<uint>*> accExtraUbo = arena.allocArray<const vector<uint>*>(_toDraw.size());
+        std::span<bool> accUseIndexBufferLOD = arena.allocArray<bool>(_toDraw.size());
+        uint accSize = 0;
         renderer::DrawState curDrawState = _toDraw[0].elem->drawState();
         uint curIndex=0;
 
@@ -126,9 +131,9 @@ void DeferredRendererNode::render()
 
                 if(curDrawState.shader())
                 {
-                    if(alreadyUsed.find(curDrawState.shader()) == alreadyUsed.end())
+                    if(std::find(alreadyUsed.begin(), alreadyUsed.end(), curDrawState.shader()) == alreadyUsed.end())
                     {
-                        alreadyUsed.insert(curDrawState.shader());
+                        alreadyUsed.push_back(curDrawState.shader());
                         curDrawState.shader()->bind();
                         for(int i=0 ; i<NB_CLIP_PLAN ; ++i)
                         {
@@ -139,33 +144,31 @@ void DeferredRendererNode::render()
                     }
                 }
 
-                _meshDrawer.draw(accMesh, accMatr, accMate, accExtraUbo, accUseIndexBufferLOD);
-                accMesh.resize(0);
-                accMatr.resize(0);
-                accMate.resize(0);
-                accUseIndexBufferLOD.resize(0);
-                accExtraUbo.resize(0);
+                _meshDrawer.draw(accMesh.first(accSize), accMatr.first(accSize), accMate.first(accSize),
+                                 accExtraUbo.first(accSize), accUseIndexBufferLOD.first(accSize));
+                accSize = 0;
                 curDrawState = _toDraw[curIndex].elem->drawState();
             }
 
             if(_toDraw[curIndex].elem->geometry().buffers() && !_toDraw[curIndex].elem->geometry().buffers()->isNull())
             {
-                accMatr.push_back(_toDraw[curIndex].matrix->transposed());
-                accMesh.push_back(_toDraw[curIndex].elem->geometry().buffers());
-                accMate.push_back(_toDraw[curIndex].elem->dummyMaterial());
-                accExtraUbo.push_back(*(_toDraw[curIndex].extraUbo));
-                accUseIndexBufferLOD.push_back(_toDraw[curIndex].useLOD);
+                accMatr[accSize] = _toDraw[curIndex].matrix->transposed();
+                accMesh[accSize] = _toDraw[curIndex].elem->geometry().buffers();
+                accMate[accSize] = _toDraw[curIndex].elem->dummyMaterial();
+                accExtraUbo[accSize] = _toDraw[curIndex].extraUbo;
+                accUseIndexBufferLOD[accSize] = _toDraw[curIndex].useLOD;
+                ++accSize;
             }
         }
-        if(!accMesh.empty())
+        if(accSize > 0)
         {
             _meshDrawer.setDrawState(curDrawState);
 
             if(curDrawState.shader())
             {
-                if(alreadyUsed.find(curDrawState.shader()) == alreadyUsed.end())
+                if(std::find(alreadyUsed.begin(), alreadyUsed.end(), curDrawState.shader()) == alreadyUsed.end())
                 {
-                    alreadyUsed.insert(curDrawState.shader());
+                    alreadyUsed.push_back(curDrawState.shader());
                     curDrawState.shader()->bind();
                     for(int i=0 ; i<NB_CLIP_PLAN ; ++i)
                     {
@@ -176,7 +179,8 @@ void DeferredRendererNode::render()
                 }
             }
 
-            _meshDrawer.draw(accMesh, accMatr, accMate, accExtraUbo, accUseIndexBufferLOD);
+            _meshDrawer.draw(accMesh.first(accSize), accMatr.first(accSize), accMate.first(accSize),
+                             accExtraUbo.first(accSize), accUseIndexBufferLOD.first(accSize));
         }
     }
 
@@ -184,7 +188,7 @@ void DeferredRendererNode::render()
         if(_useClipPlan[i])
             glDisable(GL_CLIP_DISTANCE0+i);
 
-    vector<LightContextRenderer::Light> lights(_culledLight.size());
+    std::span<LightContextRenderer::Light> lights = arena.allocArray<LightContextRenderer::Light>(_culledLight.size());
     for(uint i=0 ; i<lights.size() ; ++i)
         lights[i] = _culledLight[i].get().get();
 
@@ -34,7 +34,7 @@ namespace pipeline
     private:
         renderer::MeshRenderer& _meshDrawer;
 
-        vector<std::reference_wrapper<LightInstance>> _culledLight;
+        ArenaVector<std::reference_wrapper<LightInstance>> _culledLight;
 
         bool _useScissor = false;
         vec2 _coordScissor = {0,0};
@@ -50,7 +50,7 @@ namespace pipeline
         };
 
         using ElementInstance = EInst;
-        vector<ElementInstance> _toDraw;
+        ArenaVector<ElementInstance> _toDraw;
 
         Pipeline::DeferredRendererEntity* _rendererEntity = nullptr;
         renderer::FrameBuffer* _copyToFBO = nullptr;
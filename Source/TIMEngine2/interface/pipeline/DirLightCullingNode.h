@@ -31,9 +31,10 @@ namespace pipeline
         void prepare() override
         {
             if(!Pipeline::CollectObjectNode<Type>::tryPrepare()) return;
+            TIM_ALLOC_SCOPE("DirLightCullingNode::prepare");
 
             for(uint i=0 ; i<renderer::MAX_SHADOW_MAP_LVL ; ++i)
-                _results[i].clear();
+                _results[i] = this->frameArena().template makeVector<std::reference_wrapper<Type>>(_results[i].size());
 
             if(!_scene || !_sceneView) return;
 
@@ -48,11 +49,11 @@ namespace pipeline
                                                      _sceneView->dirLightView.realPos[i] + _sceneView->dirLightView.lightDir,
                                                      _sceneView->dirLightView.up));
 
-                _scene->scene.template query<Type>(FrustumCulling(frustum), VectorInserter<vector<std::reference_wrapper<Type>>>(_results[i]));
+                _scene->scene.template query<Type>(FrustumCulling(frustum), VectorInserter<ArenaVector<std::reference_wrapper<Type>>>(_results[i]), renderer::globalThreadPool);
             }
         }
 
-        const vector<std::reference_wrapper<Type>>& get(int index) const override
+        const ArenaVector<std::reference_wrapper<Type>>& get(int index) const override
         {
             return _results[index];
         }
@@ -60,7 +61,7 @@ namespace pipeline
     private:
         using SceneCullingNode<MeshInstance, SceneType>::_scene;
         using SceneCullingNode<MeshInstance, SceneType>::_sceneView;
-        vector<std::reference_wrapper<Type>> _results[renderer::MAX_SHADOW_MAP_LVL];
+        ArenaVector<std::reference_wrapper<Type>> _results[renderer::MAX_SHADOW_MAP_LVL];
         std::vector<float> _orthoRange = {50,150,500};
         uint _depthMapResolution = 1024;
 
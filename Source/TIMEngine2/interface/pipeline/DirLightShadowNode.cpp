@@ -92,16 +92,14 @@ renderer::Texture* DirLightShadowNode::buffer(uint index) const
 void DirLightShadowNode::prepare()
 {
     if(!tryPrepare()) return;
+    TIM_ALLOC_SCOPE("DirLightShadowNode::prepare");
+
+    for (uint i = 0; i < renderer::MAX_SHADOW_MAP_LVL; ++i)
+        _toDraw[i] = frameArena().makeVector<ElementInstance>(_toDraw[i].size());
 
     if(!_sceneView)
         return;
 
-
-    for (uint i = 0; i < renderer::MAX_SHADOW_MAP_LVL; ++i) {
-        _toDraw[i].clear();
-        _useShadowLOD[i].clear();
-    }
-
     for(size_t i=0 ; i<_meshInstanceSource.size() ; ++i)
     {
         if(!_meshInstanceSource[i]) continue;
@@ -115,8 +113,7 @@ void DirLightShadowNode::prepare()
             {
                 for (uint i = 0; i < m.mesh().nbElements(); ++i) {
                     if (m.mesh().element(i).isEnable() && m.mesh().element(i).castShadow()) {
-                        _toDraw[j].push_back({ &(m.mesh().element(i)), &(m.matrix()) });
-                        _useShadowLOD[j].push_back(m.useShadowLOD());
+                        _toDraw[j].push_back({ &(m.mesh().element(i)), &(m.matrix()), m.useShadowLOD() });
                     }
                 }
             }
@@ -127,6 +124,7 @@ void DirLightShadowNode::prepare()
 void DirLightShadowNode::render()
 {
     if(!tryRender()) return;
+    TIM_ALLOC_SCOPE("DirLightShadowNode::render");
 
     if(!_sceneView)
         return;
@@ -146,28 +144,31 @@ void DirLightShadowNode::render()
 
         if(!_toDraw[i].empty())
         {
-            vector<mat4> accMatr;
-            vector<renderer::MeshBuffers*> accMesh;
-            vector<bool> accUseIndexBufferLOD;
+            LinearArena& arena = frameArena().local();
+            std::span<mat4> accMatr = arena.allocArray<mat4>(_toDraw[i].size());
+            std::span<renderer::MeshBuffers*> accMesh = arena.allocArray<renderer::MeshBuffers*>(_toDraw[i].size());
+            std::span<bool> accUseIndexBufferLOD = arena.allocArray<bool>(_toDraw[i].size());
+            uint accSize = 0;
 
             for(uint index=0 ; index < _toDraw[i].size() ; ++index)
             {
-                if(_toDraw[i][index].first->geometry().buffers() && !_toDraw[i][index].first->geometry().buffers()->isNull())
+                if(_toDraw[i][index].elem->geometry().buffers() && !_toDraw[i][index].elem->geometry().buffers()->isNull())
                 {
-                    renderer::MeshBuffers* pMeshBuffers = _toDraw[i][index].first->geometry().buffers();
+                    renderer::MeshBuffers* pMeshBuffers = _toDraw[i][index].elem->geometry().buffers();
 
                     if (pMeshBuffers->hasSecondaryIndexBuffer()) {
                         // Slightly shift the LOD to avoid self shadowing issue, this value should be mesh dependent
-                        accMatr.push_back(_toDraw[i][index].second->translated(_sceneView->dirLightView.lightDir * 0.02f).transposed());
+                        accMatr[accSize] = _toDraw[i][index].matrix->translated(_sceneView->dirLightView.lightDir * 0.02f).transposed();
                     } else {
-                        accMatr.push_back(_toDraw[i][index].second->transposed());
+                        accMatr[accSize] = _toDraw[i][index].matrix->transposed();
                     }
 
-                    accMesh.push_back(pMeshBuffers);
-                    accUseIndexBufferLOD.push_back(_useShadowLOD[i][index]);
+                    accMesh[accSize] = pMeshBuffers;
+                    accUseIndexBufferLOD[accSize] = _toDraw[i][index].useLOD;
+                    ++accSize;
                 }
             }
-            if(!accMesh.empty())
+            if(accSize > 0)
             {
                 _meshDrawer.setDrawState(_defaultDrawState);
 
@@ -180,7 +181,7 @@ void DirLightShadowNode::render()
                 _defaultDrawState.shader()->setUniform(projView,
                                                        _defaultDrawState.shader()->engineUniformId(renderer::Shader::PROJVIEW));
 
-                _meshDrawer.draw(accMesh, accMatr, {}, {}, accUseIndexBufferLOD, false);
+                _meshDrawer.draw(accMesh.first(accSize), accMatr.first(accSize), {}, {}, accUseIndexBufferLOD.first(accSize), false);
             }
         }
 
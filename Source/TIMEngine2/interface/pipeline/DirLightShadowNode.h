@@ -32,12 +32,16 @@ namespace pipeline
     private:
         renderer::MeshRenderer& _meshDrawer;
 
-        using ElementInstance = std::pair<const Mesh::Element*, const mat4*>;
+        struct ElementInstance
+        {
+            const Mesh::Element* elem;
+            const mat4* matrix;
+            bool useLOD;
+        };
 
         vec3 _sizeOrtho[renderer::MAX_SHADOW_MAP_LVL];
         mat4 _orthoMatrix[renderer::MAX_SHADOW_MAP_LVL];
-        vector<ElementInstance> _toDraw[renderer::MAX_SHADOW_MAP_LVL];
-        vector<bool> _useShadowLOD[renderer::MAX_SHADOW_MAP_LVL];
+        ArenaVector<ElementInstance> _toDraw[renderer::MAX_SHADOW_MAP_LVL];
 
         bool _needUpdate = true;
         int _counter = 0;
@@ -4,6 +4,7 @@
 #include "interface/Pipeline.h"
 #include "Camera.h"
 #include "Frustum.h"
+#include "scene/IncrementalCulling.h"
 
 #include "MemoryLoggerOn.h"
 namespace tim
@@ -20,22 +21,31 @@ namespace pipeline
         SceneCullingNode(Pipeline::SceneEntity<SceneType>& scene, Pipeline::SceneView& view) : _scene(&scene), _sceneView(&view) {}
         SceneCullingNode() : _scene(nullptr), _sceneView(nullptr) {}
 
-        void setScene(Pipeline::SceneEntity<SceneType>& scene) { _scene = &scene; }
-        void setSceneView(Pipeline::SceneView& view) { _sceneView = &view; }
+        void setScene(Pipeline::SceneEntity<SceneType>& scene) { _scene = &scene; _incrementalCulling.invalidate(); }
+        void setSceneView(Pipeline::SceneView& view) { _sceneView = &view; _incrementalCulling.invalidate(); }
+
+        /* Reuse the culling of the previous frames, same result, call invalidateCulling() when the camera jumps */
+        void setIncrementalCulling(bool b) { _incremental = b; _incrementalCulling.invalidate(); }
+        void invalidateCulling() { _incrementalCulling.invalidate(); }
+        const scene::IncrementalCulling::Stats& cullingStats() const { return _incrementalCulling.stats(); }
 
         virtual void prepare() override
         {
             if(!Pipeline::CollectObjectNode<Type>::tryPrepare()) return;
+            TIM_ALLOC_SCOPE("SceneCullingNode::prepare");
 
-            _result.clear();
+            _result = this->frameArena().template makeVector<std::reference_wrapper<Type>>(_result.size());
             if(!_scene || !_sceneView) return;
 
             Frustum frustum;
             frustum.buildCameraFrustum(_sceneView->camera);
-            _scene->scene.template query<Type>(FrustumCulling(frustum), VectorInserter<vector<std::reference_wrapper<Type>>>(_result));
+            if(_incremental)
+                _incrementalCulling.template query<Type>(_scene->scene, frustum, VectorInserter<ArenaVector<std::reference_wrapper<Type>>>(_result));
+            else
+                _scene->scene.template query<Type>(FrustumCulling(frustum), VectorInserter<ArenaVector<std::reference_wrapper<Type>>>(_result), renderer::globalThreadPool);
         }
 
-        virtual const vector<std::reference_wrapper<Type>>& get(int) const override
+        virtual const ArenaVector<std::reference_wrapper<Type>>& get(int) const override
         {
             return _result;
         }
@@ -44,7 +54,10 @@ namespace pipeline
          Pipeline::SceneEntity<SceneType>* _scene;
          Pipeline::SceneView* _sceneView;
 
-         vector<std::reference_wrapper<Type>> _result;
+         ArenaVector<std::reference_wrapper<Type>> _result;
+
+         bool _incremental = false;
+         scene::IncrementalCulling _incrementalCulling;
     };
 
     using SimpleSceneMeshCullingNode = SceneCullingNode<MeshInstance, SimpleScene>;
@@ -1,10 +1,12 @@
 
 #include "Sampler.hpp"
 #include "core/Logger.h"
+#include "core/FileSystem.h"
 
 #include <cstdlib>
 #include <cstdio>
 #include <cstring>
+#include <algorithm>
 
 #ifndef NO_OGG_VORBIS
 #define OV_EXCLUDE_STATIC_CALLBACKS
@@ -89,23 +91,26 @@ Sampler::Reader * Sampler::createWav(std::string const & path) {
     // http://unusedino.de/ec64/technical/formats/wav.html
     
     struct WavReader : Reader {
-        FILE * file;
+        // read in memory, the file can be in a mounted archive
+        tim::core::FileData file;
         uint32_t start;
+        size_t pos;
         
         WavReader(std::string const & path) {
             
             // Open file
-            file = fopen(path.c_str(), "rb");
-            if (!file)
+            file = tim::core::FileSystem::read(path);
+            if (!file.isOpen())
                 return;
             
             // Read header
             char header[36];
-            if (fread(header, sizeof(header), 1, file) != 1) {
-                fclose(file);
-                file = nullptr;
+            if (file.size < sizeof(header)) {
+                file = tim::core::FileData();
                 return;
             }
+            memcpy(header, file.data, sizeof(header));
+            pos = sizeof(header);
             
             // Check PCM header
             if (header[0] != 'R' || header[1] != 'I' || header[2] != 'F' || header[3] != 'F' ||
@@ -113,8 +118,7 @@ Sampler::Reader * Sampler::createWav(std::string const & path) {
                     header[12] != 'f' || header[13] != 'm' || header[14] != 't' || header[15] != ' ' ||
                     *(uint32_t *)(header + 16) != 16 || *(uint16_t *)(header + 20) != 1) {
                 LOG(path, " is not a valid RIFF WAVE PCM");
-                fclose(file);
-                file = nullptr;
+                file = tim::core::FileData();
                 return;
             }
             
@@ -123,8 +127,7 @@ Sampler::Reader * Sampler::createWav(std::string const & path) {
             channels = *(uint16_t *)(header + 22);
             if ((bits != 8 && bits != 16) || (channels != 1 && channels != 2)) {
                 LOG(path, " invalid WAV format, only mono/stereo 8/16 bits is supported");
-                fclose(file);
-                file = nullptr;
+                file = tim::core::FileData();
                 return;
             }
             frequency = *(uint32_t *)(header + 24);
@@ -133,44 +136,44 @@ Sampler::Reader * Sampler::createWav(std::string const & path) {
             start = 0;
             char chunk[8];
             while (start == 0) {
-                if (fread(chunk, sizeof(chunk), 1, file) != 1)
+                if (file.size - pos < sizeof(chunk))
                     break;
+                memcpy(chunk, file.data + pos, sizeof(chunk));
+                pos += sizeof(chunk);
                 size = *(uint32_t*)(chunk + 4);
                 if (chunk[0] == 'd' && chunk[1] == 'a' && chunk[2] == 't' && chunk[3] == 'a') {
-                    start = ftell(file);
+                    start = uint32_t(pos);
                     break;
                 } else
-                    fseek(file, size, SEEK_CUR);
+                    pos = std::min<size_t>(pos + size, file.size);
             }
             if (start == 0) {
                 LOG("wav data chunk not found");
-                fclose(file);
-                file = nullptr;
+                file = tim::core::FileData();
                 return;
             }
             offset = 0;
+            size = uint32_t(std::min<size_t>(size, file.size - start));
             size /= channels * bits / 8;
         }
         
-        ~WavReader() {
-            if (file)
-                fclose(file);
-        }
-        
         void rewind() {
-            fseek(file, start, SEEK_SET);
+            pos = start;
             offset = 0;
         }
         
         uint32_t read(void * buffer, uint32_t samples) {
-            samples = fread(buffer, channels * bits / 8, std::min(samples, size - offset), file);
+            const uint32_t sampleSize = channels * bits / 8;
+            samples = std::min(samples, size - offset);
+            memcpy(buffer, file.data + pos, size_t(samples) * sampleSize);
+            pos += size_t(samples) * sampleSize;
             offset += samples;
             return samples;
         }
         
     };
     WavReader * reader = new WavReader(path);
-    if (reader->file)
+    if (reader->file.isOpen())
         return reader;
     delete reader;
     return nullptr;
@@ -183,21 +186,44 @@ Sampler::Reader * Sampler::createOgg(std::string const & path) {
 
 #ifndef NO_OGG_VORBIS
     struct OggReader : Reader {
-        FILE * file;
+        // decoded from memory, the file can be in a mounted archive
+        tim::core::FileData file;
+        size_t pos = 0;
         OggVorbis_File vorbis;
         
+        static size_t readFunc(void * ptr, size_t size, size_t nmemb, void * source) {
+            OggReader * r = static_cast<OggReader *>(source);
+            size_t n = size == 0 ? 0 : std::min(nmemb, (r->file.size - r->pos) / size);
+            memcpy(ptr, r->file.data + r->pos, n * size);
+            r->pos += n * size;
+            return n;
+        }
+        
+        static int seekFunc(void * source, ogg_int64_t offset, int whence) {
+            OggReader * r = static_cast<OggReader *>(source);
+            ogg_int64_t p = whence == SEEK_SET ? offset : whence == SEEK_CUR ? ogg_int64_t(r->pos) + offset : ogg_int64_t(r->file.size) + offset;
+            if (p < 0 || p > ogg_int64_t(r->file.size))
+                return -1;
+            r->pos = size_t(p);
+            return 0;
+        }
+        
+        static long tellFunc(void * source) {
+            return long(static_cast<OggReader *>(source)->pos);
+        }
+        
         OggReader(std::string const & path) {
             
             // Open file
-            file = fopen(path.c_str(), "rb");
-            if (!file)
+            file = tim::core::FileSystem::read(path);
+            if (!file.isOpen())
                 return;
             
             // Create Vorbis object
-            if (ov_open(file, &vorbis, NULL, 0) < 0) {
+            ov_callbacks callbacks = { readFunc, seekFunc, nullptr, tellFunc };
+            if (ov_open_callbacks(this, &vorbis, NULL, 0, callbacks) < 0) {
                 ov_clear(&vorbis);
-                fclose(file);
-                file = nullptr;
+                file = tim::core::FileData();
                 return;
             }
             
@@ -211,10 +237,8 @@ Sampler::Reader * Sampler::createOgg(std::string const & path) {
         }
         
         ~OggReader() {
-            if (file) {
+            if (file.isOpen())
                 ov_clear(&vorbis);
-                fclose(file);
-            }
         }
         
         void rewind() {
@@ -239,7 +263,7 @@ Sampler::Reader * Sampler::createOgg(std::string const & path) {
         
     };
     OggReader * reader = new OggReader(path);
-    if (reader->file)
+    if (reader->file.isOpen())
         return reader;
     delete reader;
 #endif
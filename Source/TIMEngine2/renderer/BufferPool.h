@@ -1,6 +1,7 @@
 #ifndef MESHBUFFERPOOL_H
 #define MESHBUFFERPOOL_H
 
+#include <functional>
 #include "core/RangeAllocator.h"
 #include "IndexBuffer.h"
 #include "GenericVertexBuffer.h"
@@ -28,13 +29,13 @@ namespace renderer
 
             void bind() const
             {
-                _pool._buffer.bind();
+                _pool.buffer().bind();
             }
 
             void flush(const InternBufferType* data, size_t begin, size_t size) const
             {
                 size = std::min(size, _capacity);
-                _pool._buffer.flush(data, begin+_begin, size);
+                _pool.buffer().flush(data, begin+_begin, size);
             }
 
             ~Instance()
@@ -49,6 +50,8 @@ namespace renderer
             size_t capacity() const { return _capacity; }
             size_t elementSize() const { return _elementSize; }
 
+            const BufferType& buffer() const { return _pool.buffer(); }
+
         private:
             Instance(size_t begin, size_t capacity, size_t elementSize, BufferPool& mbp)
                 : _begin(begin), _size(capacity), _capacity(capacity), _elementSize(elementSize), _pool(mbp) {}
@@ -61,15 +64,34 @@ namespace renderer
         BufferPool(size_t, Args... args);
         ~BufferPool() = default;
 
+        /* The gl buffer is only created by the first use of the buffer (gl thread), the allocations can be done before from any thread.
+         * elementSize is the one the buffer will have. */
+        template<class... Args>
+        static BufferPool* deferred(size_t elementSize, size_t size, Args... args);
+
         Instance* alloc(size_t);
 
         const AllocatorType& allocator() const { return _bufferAllocator; }
 
-        const BufferType& buffer() const { return _buffer; }
+        const BufferType& buffer() const
+        {
+            if(_createBuffer)
+            {
+                _createBuffer();
+                _createBuffer = nullptr;
+            }
+            return _buffer;
+        }
+
+        bool isCreated() const { return !_createBuffer; }
 
     private:
         AllocatorType _bufferAllocator;
-        BufferType _buffer;
+        mutable BufferType _buffer;
+        size_t _elementSize;
+        mutable std::function<void()> _createBuffer; // deferred creation of _buffer
+
+        BufferPool(size_t size) : _bufferAllocator(size), _buffer() {}
     };
 
     template<class BufferType, uint SIZE_BLOCK>
@@ -77,13 +99,24 @@ namespace renderer
     BufferPool<BufferType, SIZE_BLOCK>::BufferPool(size_t size, Args... args) : _bufferAllocator(size), _buffer()
     {
         _buffer.create(size, nullptr, args...);
+        _elementSize = _buffer.elementSize();
+    }
+
+    template<class BufferType, uint SIZE_BLOCK>
+    template<class... Args>
+    BufferPool<BufferType, SIZE_BLOCK>* BufferPool<BufferType, SIZE_BLOCK>::deferred(size_t elementSize, size_t size, Args... args)
+    {
+        BufferPool* pool = new BufferPool(size);
+        pool->_elementSize = elementSize;
+        pool->_createBuffer = [pool, size, args...]() { pool->_buffer.create(size, nullptr, args...); };
+        return pool;
     }
 
     template<class BufferType, uint SIZE_BLOCK>
     typename BufferPool<BufferType, SIZE_BLOCK>::Instance* BufferPool<BufferType, SIZE_BLOCK>::alloc(size_t size)
     {
         typename AllocatorType::addr addr = _bufferAllocator.alloc(size);
-        return new typename BufferPool<BufferType, SIZE_BLOCK>::Instance(addr, size, _buffer.elementSize(), *this);
+        return new typename BufferPool<BufferType, SIZE_BLOCK>::Instance(addr, size, _elementSize, *this);
     }
 
 }
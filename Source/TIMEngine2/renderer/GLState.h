@@ -222,37 +222,34 @@ namespace renderer
         _glTask.push(f);
     }
 
+    /* The tasks run outside of the lock so they can push other tasks (a destructor of a gl object) */
     inline void GLState::execAllGLTask()
     {
-        std::lock_guard<std::mutex> guard(_glTaskAccess);
-        while(!_glTask.empty())
-        {
-            _glTask.front()();
-            _glTask.pop();
-        }
+        while(execOneGLTask() > 0) {}
     }
 
     inline size_t GLState::execOneGLTask()
     {
-        std::lock_guard<std::mutex> guard(_glTaskAccess);
-        if(_glTask.empty())
-            return _glTask.size();
+        std::function<void()> task;
+        {
+            std::lock_guard<std::mutex> guard(_glTaskAccess);
+            if(_glTask.empty())
+                return 0;
+
+            task = std::move(_glTask.front());
+            _glTask.pop();
+        }
 
-        _glTask.front()();
-        _glTask.pop();
+        task();
 
+        std::lock_guard<std::mutex> guard(_glTaskAccess);
         return _glTask.size();
     }
 
     template <class F>
     void GLState::execGLTaskWhile(const F& f)
     {
-        std::lock_guard<std::mutex> guard(_glTaskAccess);
-        while(!_glTask.empty() && f())
-        {
-            _glTask.front()();
-            _glTask.pop();
-        }
+        while(f() && execOneGLTask() > 0) {}
     }
 
     inline void GLState::glSet(uint s, bool b)
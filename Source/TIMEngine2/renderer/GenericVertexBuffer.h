@@ -38,6 +38,7 @@ namespace renderer
         #include "MemoryLoggerOn.h"
 
         void bindVertexAttrib(uint, uint, uint) const;
+        void bindPackedVertexAttrib(uint, uint, GLenum, bool, uint) const;
 
     private:
         using GpuBuffer<T, GpuBufferPolicy::ArrayBuffer>::_elementSize;
@@ -74,6 +75,15 @@ namespace renderer
 
             case VEC1:
                 bindVertexAttrib(offset+0, 1, 0);
+                break;
+
+            case VNCT_PACKED:
+                bindVertexAttrib(offset+0, 3, 0);
+                bindPackedVertexAttrib(offset+1, 4, GL_INT_2_10_10_10_REV, true, 3);
+                bindPackedVertexAttrib(offset+2, 2, GL_HALF_FLOAT, false, 4);
+                bindPackedVertexAttrib(offset+3, 4, GL_INT_2_10_10_10_REV, true, 5);
+                break;
+
             default: break;
         }
     }
@@ -95,6 +105,16 @@ namespace renderer
             glVertexAttribDivisor(position, 1);
     }
 
+    /* An attribute stored in another type than T, converted to float by the vertex fetch */
+    template <class T> void GenericVertexBuffer<T>::bindPackedVertexAttrib(uint position, uint nbComponent, GLenum type, bool normalized, uint offset) const
+    {
+        glEnableVertexAttribArray(position);
+        glVertexAttribPointer(position, nbComponent, type, normalized, _elementSize*sizeof(T), BUFFER_OFFSET(offset*sizeof(T)));
+
+        if(_useInstancedAttrib)
+            glVertexAttribDivisor(position, 1);
+    }
+
 }
 }
 #include "MemoryLoggerOff.h"
@@ -4,6 +4,7 @@
 #include "renderer.h"
 #include "MeshBuffers.h"
 #include "core/Rand.h"
+#include "core/FileSystem.h"
 
 #include "MemoryLoggerOn.h"
 namespace tim
@@ -48,8 +49,9 @@ IndirectLightRenderer::IndirectLightRenderer(LightContextRenderer& context) : _c
     param.nbLevels = 1;
     param.size = uivec3(256,256,1);
     float* dat = new float[256*256*3];
-    std::ifstream inDat("shader/brdf_256.dat", std::ios_base::binary);
-    if(!inDat)
+    FileData brdfFile = FileSystem::read("shader/brdf_256.dat");
+    MemoryStream inDat(brdfFile);
+    if(!brdfFile.isOpen())
     {
         LOG("shader/brdf_256.dat does not exist.");
         TIM_ASSERT(false);
@@ -1,9 +1,11 @@
 #ifndef MESHBUFFERS_H_INCLUDED
 #define MESHBUFFERS_H_INCLUDED
 
+#include <memory>
 #include "renderer.h"
 #include "VAO.h"
 #include "Sphere.h"
+#include "Box.h"
 
 #include "MemoryLoggerOn.h"
 namespace tim
@@ -26,14 +28,29 @@ namespace renderer
         uint nbVertex = 0;
         DataType* vData = nullptr;
 
+        /* Pre-computed by the exporter (.tim v2), to compute when hasBounds is false */
+        bool hasBounds = false;
+        Sphere sphere;
+        Box box;
+        uint64_t contentHash = 0;
+
+        /* When set the arrays point into it (a mapped file) and are read only */
+        std::shared_ptr<void> storage;
+
         void clear()
         {
+            hasBounds=false;
+            contentHash=0;
             nbIndex=0;
             nbSecondaryIndex=0;
             nbVertex=0;
-            delete[] indexData;
-            delete[] secondaryIndexData;
-            delete[] vData;
+            if(!storage)
+            {
+                delete[] indexData;
+                delete[] secondaryIndexData;
+                delete[] vData;
+            }
+            storage.reset();
             indexData=nullptr;
             secondaryIndexData = nullptr;
             vData=nullptr;
@@ -49,9 +66,12 @@ namespace renderer
         ~MeshBuffers()
         {
             freeCpuData();
-            delete _vb;
-            delete _ib;
-            delete _ib2;
+            if(!_owner)
+            {
+                delete _vb;
+                delete _ib;
+                delete _ib2;
+            }
         }
 
         void draw(size_t s, VertexMode primitive, size_t nbInstance, const VAO* vao = nullptr) const
@@ -65,11 +85,17 @@ namespace renderer
             s = std::min(s, _ib->size());
 
             if(nbInstance>0)
-                glDrawElementsInstancedBaseVertex(IndexBuffer::GLPrimitive[primitive], s, GL_UNSIGNED_INT, BUFFER_OFFSET(_ib->offset()*sizeof(IBuffer::Type)), nbInstance, _vb->offset());
+                glDrawElementsInstancedBaseVertex(IndexBuffer::GLPrimitive[primitive], s, indexType(), BUFFER_OFFSET(_ib->offset()*sizeof(IBuffer::Type)), nbInstance, _vb->offset());
             else
-                glDrawElementsBaseVertex(IndexBuffer::GLPrimitive[primitive], s, GL_UNSIGNED_INT, BUFFER_OFFSET(_ib->offset()*sizeof(IBuffer::Type)), _vb->offset());
+                glDrawElementsBaseVertex(IndexBuffer::GLPrimitive[primitive], s, indexType(), BUFFER_OFFSET(_ib->offset()*sizeof(IBuffer::Type)), _vb->offset());
         }
 
+        /* 16 bits indices are stored by pairs in the uint of the index buffers: their size() is the number of indices,
+         * their capacity() and offset() are in uint */
+        void setShortIndex(bool b) { _shortIndex = b; }
+        bool shortIndex() const { return _shortIndex; }
+        GLenum indexType() const { return _shortIndex ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT; }
+
         VBuffer* vb() const { return _vb; }
         IBuffer* ib(bool useSecondary = false) const { return !_ib2 ? _ib : (useSecondary ? _ib2 : _ib); }
 
@@ -86,9 +112,50 @@ namespace renderer
             std::swap(_ib2, buf._ib2);
             std::swap(_volume, buf._volume);
             std::swap(_cpuData, buf._cpuData);
+            std::swap(_shortIndex, buf._shortIndex);
+            std::swap(_owner, buf._owner);
+        }
+
+        /* Draw with the buffers of another MeshBuffers (which must own them) and see its cpu data, it's kept alive by this one.
+         * The current buffers are released. */
+        void share(const std::shared_ptr<MeshBuffers>& owner)
+        {
+            MeshBuffers released(nullptr, nullptr);
+            swap(released);
+
+            _vb = owner->_vb;
+            _ib = owner->_ib;
+            _ib2 = owner->_ib2;
+            _volume = owner->_volume;
+            _shortIndex = owner->_shortIndex;
+            _owner = owner;
         }
 
-        MeshData* cpuData() const { return _cpuData; }
+        bool isShared() const { return _owner != nullptr; }
+
+        /* Memory owned: the buffers (unless shared, they are counted with their owner) and the cpu data */
+        size_t bytes() const
+        {
+            size_t b = 0;
+            if(!_owner)
+            {
+                if(_vb) b += _vb->capacity() * _vb->elementSize() * sizeof(VBuffer::Type);
+                if(_ib) b += _ib->capacity() * _ib->elementSize() * sizeof(IBuffer::Type);
+                if(_ib2) b += _ib2->capacity() * _ib2->elementSize() * sizeof(IBuffer::Type);
+            }
+            if(_cpuData)
+                b += sizeof(MeshData::DataType)*_cpuData->nbVertex + sizeof(uint)*(_cpuData->nbIndex + _cpuData->nbSecondaryIndex);
+            return b;
+        }
+
+        MeshData* cpuData() const { return _cpuData ? _cpuData : (_owner ? _owner->_cpuData : nullptr); }
+        /* Take the ownership of the data if there was none, return false otherwise */
+        bool setCpuData(MeshData* data)
+        {
+            if(_cpuData) return false;
+            _cpuData = data;
+            return true;
+        }
         void freeCpuData()
         {
             if(_cpuData)
@@ -106,6 +173,8 @@ namespace renderer
 
         Sphere _volume;
         MeshData* _cpuData = nullptr; // optional, use to keep track of the initial data, can be freed at any moment
+        bool _shortIndex = false;
+        std::shared_ptr<MeshBuffers> _owner; // of the buffers when shared
     };
 }
 }
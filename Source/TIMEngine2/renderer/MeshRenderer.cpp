@@ -1,4 +1,5 @@
 #include "MeshRenderer.h"
+#include "core/AllocCounter.h"
 
 #include "MemoryLoggerOn.h"
 namespace tim
@@ -33,6 +34,7 @@ MeshRenderer::MeshRenderer()
 MeshRenderer::~MeshRenderer()
 {
     delete _vao;
+    delete _packedVao;
 }
 
 void MeshRenderer::bind() const
@@ -46,9 +48,16 @@ void MeshRenderer::setDrawState(const DrawState& s)
     _states = s;
 }
 
-int MeshRenderer::draw(const vector<MeshBuffers*>& meshs, const vector<mat4>& models, const vector<DummyMaterial>& materials,
-                       const vector<vector<uint>>& extraUbo, const vector<bool>& useIndexBufferLOD, bool useCameraUbo)
+int MeshRenderer::draw(std::span<MeshBuffers* const> meshs, std::span<const mat4> models, std::span<const DummyMaterial> materials,
+                       std::span<const vector<uint>* const> extraUbo, std::span<const bool> useIndexBufferLOD, bool useCameraUbo)
 {
+    // the packed pool has no buffer until a packed mesh is uploaded
+    if(!_packedVao && packedVertexBufferPool->isCreated())
+        _packedVao = new VAO(packedVertexBufferPool->buffer(), _drawIdBuffer);
+
+    // called for each pass of each frame, the buffers are created once
+    TIM_NO_ALLOC_SCOPE();
+
     if(meshs.empty() || models.size() != meshs.size() || (!materials.empty() && materials.size() < meshs.size())
        || (!extraUbo.empty() && extraUbo.size() < meshs.size()))
         return 0;
@@ -72,6 +81,7 @@ int MeshRenderer::draw(const vector<MeshBuffers*>& meshs, const vector<mat4>& mo
     if(models.size()%_maxUboMat4 > 0) nbLoop++;
 
     IndirectDrawParmeter drawParam[_maxUboMat4];
+    const VAO* boundVao = _vao; // follows the vertex format of the meshes, the index buffer is the same for all
     for(uint i=0 ; i<nbLoop ; ++i)
     {
         uint innerLoop = std::min<uint>(_maxUboMat4, models.size() - i*_maxUboMat4);
@@ -99,33 +109,55 @@ int MeshRenderer::draw(const vector<MeshBuffers*>& meshs, const vector<mat4>& mo
 
         if(!extraUbo.empty())
         {
-            for(uint j=0 ; j<extraUbo[i].size() ; ++j)
-                openGL.bindUniformBuffer(extraUbo[i][j], 3+j);
+            for(uint j=0 ; j<extraUbo[i]->size() ; ++j)
+                openGL.bindUniformBuffer((*extraUbo[i])[j], 3+j);
         }
 
         if(!materials.empty())
             openGL.bindUniformBuffer(_materialBuffer.id(), 2);
 
 #if 1
-        for (uint j = 0; j < innerLoop; ++j)
+        // the draws go by vertex format, the bound one first, so the vao changes at most once per chunk.
+        // The order doesn't matter: each draw finds its model and material with its base instance.
+        const VAO* passVao[2] = { boundVao, boundVao == _vao ? _packedVao : _vao };
+        for(int pass=0 ; pass<2 ; ++pass)
         {
-            _stats._numDrawCalls++;
-            _stats._numTriangles += (drawParam[j].count / 3);
-
-            glDrawElementsInstancedBaseVertexBaseInstance(DrawState::toGLPrimitive(_states.primitive()), 
-                                                          drawParam[j].count,
-                                                          GL_UNSIGNED_INT, 
-                                                          BUFFER_OFFSET(drawParam[j].firstIndex * 4),
-                                                          1,
-                                                          drawParam[j].baseVertex,
-                                                          j);
+            for (uint j = 0; j < innerLoop; ++j)
+            {
+                const MeshBuffers* mesh = meshs[_maxUboMat4*i+j];
+                const VAO* vao = mesh->vb()->buffer().format() == VNCT_PACKED ? _packedVao : _vao;
+                if(!vao || vao != passVao[pass]) // no vao: packed, drawn before the first packed upload
+                    continue;
+
+                if(vao != boundVao)
+                {
+                    vao->bind();
+                    indexBufferPool->buffer().bind();
+                    boundVao = vao;
+                }
+
+                _stats._numDrawCalls++;
+                _stats._numTriangles += (drawParam[j].count / 3);
+
+                glDrawElementsInstancedBaseVertexBaseInstance(DrawState::toGLPrimitive(_states.primitive()), 
+                                                              drawParam[j].count,
+                                                              mesh->indexType(),
+                                                              BUFFER_OFFSET(drawParam[j].firstIndex * 4),
+                                                              1,
+                                                              drawParam[j].baseVertex,
+                                                              j);
+            }
         }
 #else
+        // only valid if all the meshes are VNCT with 32 bits indices
         _drawIndirectBuffer.flush(drawParam, 0, innerLoop);
         openGL.bindDrawIndirectBuffer(_drawIndirectBuffer.id());
         glMultiDrawElementsIndirect(DrawState::toGLPrimitive(_states.primitive()), GL_UNSIGNED_INT, nullptr, innerLoop, 0);
 #endif
     }
+
+    if(boundVao != _vao)
+        bind();
 #else
     openGL.bindUniformBuffer(_uboParameter.id(), 0);
     openGL.bindShaderStorageBuffer(_modelBuffer.id(), 1);
@@ -1,6 +1,7 @@
 #ifndef MESHRENDERER_H
 #define MESHRENDERER_H
 
+#include <span>
 #include "GLState.h"
 #include "DrawState.h"
 #include "GpuBuffer.h"
@@ -30,8 +31,8 @@ namespace renderer
         const Stats& getStats() const { return _stats; }
 
         void bind() const;
-        int draw(const vector<MeshBuffers*>&, const vector<mat4>&, const vector<DummyMaterial>& mat = {},
-                 const vector<vector<uint>>& extraUbo = {}, const vector<bool>& useLOD = {}, bool useCameraUbo = true);
+        int draw(std::span<MeshBuffers* const>, std::span<const mat4>, std::span<const DummyMaterial> mat = {},
+                 std::span<const vector<uint>* const> extraUbo = {}, std::span<const bool> useLOD = {}, bool useCameraUbo = true);
 
         void setDrawState(const DrawState&);
 
@@ -52,6 +53,7 @@ namespace renderer
 
         GenericVertexBuffer<int> _drawIdBuffer;
         VAO* _vao = nullptr;
+        VAO* _packedVao = nullptr; // meshes of the packedVertexBufferPool, created with its buffer
 
 #ifdef USE_SSBO_MODELS
         ShaderStorageBuffer<mat4> _modelBuffer;
@@ -90,6 +90,7 @@ Texture* Texture::genTexture2D(uint dataType, const GenTexParam& param, const vo
     tex->_format = param.format;
     tex->_id = idTex;
     tex->_size = param.size;
+    tex->_nbLevels = level;
     tex->_type = TEXTURE_2D;
     return tex;
 }
@@ -124,6 +125,7 @@ Texture* Texture::genTextureCube(const GenTexParam& param, const vector<ubyte*>&
     tex->_format = param.format;
     tex->_id = idTex;
     tex->_size = param.size;
+    tex->_nbLevels = level;
     tex->_type = CUBE_MAP;
     return tex;
 }
@@ -152,6 +154,7 @@ Texture* Texture::genTextureArray2D(uint dataType, const GenTexParam& param, con
     tex->_format = param.format;
     tex->_id = idTex;
     tex->_size = param.size;
+    tex->_nbLevels = level;
     tex->_type = ARRAY_2D;
     return tex;
 }
@@ -80,12 +80,17 @@ namespace renderer
 
         uivec2 resolution() const;
         uivec3 size() const;
+        uint nbLevels() const;
+
+        /* Gpu storage, mipmaps included */
+        size_t bytes() const;
 
     private:
         uint _id=0;
         uivec3 _size;
         Type _type=TEXTURE_2D;
         Format _format=Format::RGB;
+        uint _nbLevels = 1;
 
         mutable uint64_t _handle = 0;
         mutable bool _isBindless = false;
@@ -106,6 +111,16 @@ namespace renderer
     inline Texture::Format Texture::format() const { return _format; }
     inline uivec2 Texture::resolution() const { return _size.to<2>(); }
     inline uivec3 Texture::size() const { return _size; }
+    inline uint Texture::nbLevels() const { return _nbLevels; }
+
+    inline size_t Texture::bytes() const
+    {
+        const size_t layers = _type == CUBE_MAP ? 6 : std::max(_size.z(), 1u);
+        size_t b = 0;
+        for(uint i=0 ; i<_nbLevels ; ++i)
+            b += size_t(std::max(_size.x() >> i, 1u)) * std::max(_size.y() >> i, 1u) * layers * bytePerPixel(_format);
+        return b;
+    }
 
     inline GLenum Texture::toGLType(Type t)
     {
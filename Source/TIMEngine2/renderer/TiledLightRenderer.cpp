@@ -1,6 +1,7 @@
 #include "TiledLightRenderer.h"
 #include "ShaderCompiler.h"
 #include "renderer.h"
+#include "core/FileSystem.h"
 
 #include "MemoryLoggerOn.h"
 namespace tim
@@ -38,7 +39,8 @@ TiledLightRenderer::TiledLightRenderer(DeferredRenderer& deferred, bool) : Light
     param.nbLevels = 1;
     param.size = uivec3(256,256,1);
     float* dat = new float[256*256*3];
-    std::ifstream inDat("shader/brdf_256.dat", std::ios_base::binary);
+    FileData brdfFile = FileSystem::read("shader/brdf_256.dat");
+    MemoryStream inDat(brdfFile);
     inDat.read((char*)dat, sizeof(float)*256*256*3);
     _processedBrdf = Texture::genTexture2D(param, dat, 3);
     delete[] dat;
@@ -50,8 +52,9 @@ TiledLightRenderer::~TiledLightRenderer()
     delete _computeShader;
 }
 
-void TiledLightRenderer::draw(const vector<Light>& lights, Texture* processedSkybox)
+void TiledLightRenderer::draw(std::span<const Light> lights, Texture* processedSkybox)
 {
+    TIM_ALLOC_SCOPE("TiledLightRenderer::draw");
     createLigthBuffer(lights);
     _lightBuffer.bind(0);
 
@@ -94,7 +97,7 @@ void TiledLightRenderer::draw(const vector<Light>& lights, Texture* processedSky
     glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
 }
 
-void TiledLightRenderer::createLigthBuffer(const vector<Light>& lights)
+void TiledLightRenderer::createLigthBuffer(std::span<const Light> lights)
 {
     if(lights.empty())
         return;
@@ -103,7 +106,8 @@ void TiledLightRenderer::createLigthBuffer(const vector<Light>& lights)
         _lightBuffer.create(lights.size(), nullptr, DYNAMIC);
 
     int indexTexture = 0;
-    vector<Std140LightData> data(lights.size());
+    _lightData.resize(lights.size());
+    Std140LightData* data = _lightData.data();
     for(uint i=0 ; i<lights.size() ; ++i)
     {
         data[i].head = vec4(static_cast<float>(lights[i].type), lights[i].radius, lights[i].power, static_cast<float>(indexTexture));
@@ -114,7 +118,7 @@ void TiledLightRenderer::createLigthBuffer(const vector<Light>& lights)
             indexTexture ++;
     }
 
-     _lightBuffer.flush(&data[0], 0, lights.size());
+     _lightBuffer.flush(data, 0, lights.size());
 }
 
 }
@@ -1,6 +1,7 @@
 #ifndef TILEDLIGHTRENDERER_H
 #define TILEDLIGHTRENDERER_H
 
+#include <span>
 #include "LightContextRenderer.h"
 #include "Shader.h"
 #include "GpuBuffer.h"
@@ -18,7 +19,7 @@ namespace renderer
         TiledLightRenderer(DeferredRenderer&, bool hdr=false);
         ~TiledLightRenderer();
 
-        void draw(const vector<Light>&, Texture*);
+        void draw(std::span<const Light>, Texture*);
 
     private:
         const uivec2 TILE_SIZE = {32,30};
@@ -34,11 +35,12 @@ namespace renderer
             vec4 spot;
         };
         renderer::ShaderStorageBuffer<Std140LightData> _lightBuffer;
+        vector<Std140LightData> _lightData; // staging, kept to not allocate each frame
         int _nbLightUniformId = -1;
 
         Texture* _processedBrdf = nullptr;
 
-        void createLigthBuffer(const vector<Light>&);
+        void createLigthBuffer(std::span<const Light>);
     };
 
 }
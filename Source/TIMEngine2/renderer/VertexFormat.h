@@ -1,6 +1,8 @@
 #ifndef VERTEXFORMAT_H_INCLUDED
 #define VERTEXFORMAT_H_INCLUDED
 
+#include <cmath>
+#include <cstring>
 #include "core/Vector.h"
 
 #include "MemoryLoggerOn.h"
@@ -19,6 +21,7 @@ namespace renderer
         VNCT,
         VC,
         VEC1,
+        VNCT_PACKED, // VNCT_Packed_Vertex
     };
 
     enum VertexMode
@@ -146,6 +149,56 @@ namespace renderer
         }
     };
 
+    /* VNCT in 24 bytes: the normal and the tangent in snorm 10-10-10-2, the uv in half floats.
+     * Expanded to floats by the vertex fetch, the shaders read it as a VNCT */
+    struct VNCT_Packed_Vertex
+    {
+        vec3 v;
+        uint n, c, t;
+    };
+
+    /* Components clamped to [-1,1], w = 0 */
+    inline uint packSnorm1010102(const vec3& v)
+    {
+        uint res = 0;
+        for(int i=0 ; i<3 ; ++i)
+        {
+            const int q = int(std::round(std::max(-1.f, std::min(1.f, v[i])) * 511.f));
+            res |= (uint(q) & 0x3FF) << (10*i);
+        }
+        return res;
+    }
+
+    /* Round to nearest, overflow to inf, denormals kept */
+    inline unsigned short floatToHalf(float f)
+    {
+        uint x;
+        memcpy(&x, &f, sizeof(float));
+
+        const uint sign = (x >> 16) & 0x8000;
+        const uint absx = x & 0x7FFFFFFF;
+        if(absx >= 0x7F800000) // inf, nan
+            return sign | 0x7C00 | (absx > 0x7F800000 ? 0x200 : 0);
+        if(absx >= 0x477FF000) // >= 65520 rounds to inf
+            return sign | 0x7C00;
+        if(absx < 0x38800000) // denormal half
+        {
+            float a;
+            memcpy(&a, &absx, sizeof(float));
+            return sign | uint(std::nearbyint(a * 16777216.f)); // 2^24
+        }
+
+        const uint mant = absx + 0xC8000FFF + ((absx >> 13) & 1); // rebias the exponent and round to nearest even
+        return sign | (mant >> 13);
+    }
+
+    inline uint packHalf2(const vec2& v) { return uint(floatToHalf(v[0])) | (uint(floatToHalf(v[1])) << 16); }
+
+    inline VNCT_Packed_Vertex packVertex(const VNCT_Vertex& v)
+    {
+        return { v.v, packSnorm1010102(v.n), packHalf2(v.c), packSnorm1010102(v.t) };
+    }
+
     inline uint vertexFormatSize(VertexFormat format)
     {
         switch(format)
@@ -156,6 +209,7 @@ namespace renderer
             case VertexFormat::VNC: return 8;
             case VertexFormat::VNCT: return 11;
             case VertexFormat::VEC1: return 1;
+            case VertexFormat::VNCT_PACKED: return 6;
             default: return 0;
         }
     }
@@ -170,6 +224,7 @@ namespace renderer
             case VertexFormat::VNC: return 3;
             case VertexFormat::VNCT: return 4;
             case VertexFormat::VEC1: return 1;
+            case VertexFormat::VNCT_PACKED: return 4;
             default: return 0;
         }
     }
@@ -60,6 +60,8 @@ bool init()
     texBufferPool = new TextureBufferPool;
 
     vertexBufferPool = new VertexBufferPoolType(2 << 20, VertexFormat::VNCT, DrawMode::DYNAMIC);
+    // only in video memory once a packed mesh is uploaded (MeshLoader::PACKED_VERTEX)
+    packedVertexBufferPool = VertexBufferPoolType::deferred(vertexFormatSize(VertexFormat::VNCT_PACKED), 2 << 20, VertexFormat::VNCT_PACKED, DrawMode::DYNAMIC);
     indexBufferPool = new IndexBufferPoolType(8 << 20, DrawMode::DYNAMIC);
     indexBufferPool->buffer().bind();
 
@@ -140,12 +142,14 @@ bool close()
     delete quadMeshBuffers;
     delete depthPassShader;
     delete vertexBufferPool;
+    delete packedVertexBufferPool;
     delete indexBufferPool;
     GLState::freeInstance();
     return true;
 }
 
 BufferPool<VertexBuffer, 64>* vertexBufferPool = nullptr;
+BufferPool<VertexBuffer, 64>* packedVertexBufferPool = nullptr;
 BufferPool<IndexBuffer, 256>* indexBufferPool = nullptr;
 
 const char* drawQuad_vertex =
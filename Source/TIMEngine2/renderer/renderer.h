@@ -25,6 +25,7 @@ namespace renderer
     using IndexBufferPoolType = BufferPool<IndexBuffer, 256>;
 
     extern VertexBufferPoolType* vertexBufferPool;
+    extern VertexBufferPoolType* packedVertexBufferPool; // VNCT_PACKED, its buffer is created by the first packed upload
     extern IndexBufferPoolType* indexBufferPool;
 
     using VBuffer = VertexBufferPoolType::Instance;
@@ -16,6 +16,7 @@ namespace resource
 
         Asset() : _ptr(nullptr) {}
         Asset(AssetType* ptr) : _ptr(ptr) {}
+        Asset(const std::shared_ptr<AssetType>& ptr) : _ptr(ptr) {}
         Asset(const Asset&) = default;
         Asset(Asset&& asset) : _ptr(std::move(asset._ptr)) {}
 
@@ -26,6 +27,10 @@ namespace resource
 
         bool isNull() const { return _ptr.get() == nullptr; }
 
+        /* Identifies the underlying object, shared by the copies */
+        const void* id() const { return _ptr.get(); }
+        long useCount() const { return _ptr.use_count(); }
+
     protected:
         std::shared_ptr<AssetType> _ptr;
     };
@@ -1,10 +1,16 @@
 #ifndef ASSETMANAGER_H_INCLUDED
 #define ASSETMANAGER_H_INCLUDED
 
+#include <shared_mutex>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <unordered_map>
 #include "core/core.h"
 #include "Asset.h"
 #include "Singleton.h"
 #include "SpinLock.h"
+#include "LoadQueue.h"
 #include "AddYourLoader.h"
 
 namespace tim
@@ -12,16 +18,34 @@ namespace tim
     using namespace core;
 namespace resource
 {
+    /* Cache of the assets of a type, by loading arguments.
+     * The memory of the cached assets is accounted (for the types having a bytes() method). With a budget, the assets
+     * no longer used outside of the cache are evicted in LRU order once it's exceeded. An evicted asset is only dropped
+     * from the cache: one still in use (copied in between) stays valid, the next load of it reads it again. */
     template<class T>
     class AssetManager : public Singleton<AssetManager<T>>
     {
         friend class Singleton<AssetManager<T>>;
 
     public:
+        struct Stats
+        {
+            size_t assets = 0;            // distinct assets cached
+            size_t bytes = 0;
+            size_t unreferenced = 0;      // only kept by the cache
+            size_t unreferencedBytes = 0;
+            size_t evictions = 0;         // since the start
+            size_t evictedBytes = 0;
+            size_t budget = 0;
+        };
+
+        /* Run the release of an evicted asset (the destruction of its last reference). The default one runs it on the gl thread. */
+        using ReleaseHook = std::function<void(std::function<void()>)>;
+
         template <bool async, typename... Args>
         Option<T> load(Args... args)
         {
-            static StaticLoader<Args...> in_loader;
+            StaticLoader<Args...>& in_loader = loader<Args...>();
 
 			Option<T> opt = in_loader.get(args...);
             if(opt) return opt;
@@ -34,11 +58,85 @@ namespace resource
 #endif
 
                 if(opt_dat)
+                {
                     in_loader.add(args..., opt_dat.value());
+                    if(mayExceedBudget())
+                        trim(_budget);
+                }
                 return opt_dat;
             }
         }
 
+        /* Handle of an asset loaded by the LoadQueue, the value is set once it's done */
+        class Handle : public LoadQueue::Handle
+        {
+            friend class AssetManager;
+
+        public:
+            Option<T> value() const { return _result ? *_result : Option<T>(); }
+
+        private:
+            std::shared_ptr<Option<T>> _result;
+        };
+
+        /* Load on the LoadQueue, for the loaders split in prepare (any thread) and finish (gl thread).
+         * A request of an asset already loading gets the handle of that load (cancelling it cancels it for all). */
+        template <typename... Args>
+        Handle loadAsync(int priority, Args... args)
+        {
+            StaticLoader<Args...>& in_loader = loader<Args...>();
+
+            Handle h;
+            h._result = std::make_shared<Option<T>>(in_loader.get(args...));
+            if(*h._result)
+            {
+                static_cast<LoadQueue::Handle&>(h) = LoadQueue::instance().done();
+                return h;
+            }
+
+            std::unique_lock<std::mutex> guard(in_loader._inFlightMutex);
+            auto inFlight = in_loader._inFlight.find(std::make_tuple(args...));
+            if(inFlight != in_loader._inFlight.end())
+                return inFlight->second;
+
+            auto result = h._result;
+            static_cast<LoadQueue::Handle&>(h) = LoadQueue::instance().submit(priority, [=, this, &in_loader]() -> LoadQueue::GlPart
+            {
+                auto staged = std::make_shared<typename AssetLoader<T>::Staged>(AssetLoader<T>::prepare(args...));
+                return [=, this, &in_loader]()
+                {
+                    // loaded in between with load()
+                    *result = in_loader.get(args...);
+                    if(*result)
+                    {
+                        AssetLoader<T>::discard(*staged);
+                        return true;
+                    }
+
+                    *result = AssetLoader<T>::finish(*staged);
+                    if(!*result)
+                        return false;
+
+                    in_loader.add(args..., result->value());
+                    if(mayExceedBudget())
+                        trim(_budget);
+                    return true;
+                };
+            });
+            in_loader._inFlight[std::make_tuple(args...)] = h;
+            guard.unlock();
+
+            // the next requests are served by the cache once it's done
+            h.onComplete([=, &in_loader](LoadQueue::Status)
+            {
+                std::lock_guard<std::mutex> lock(in_loader._inFlightMutex);
+                auto it = in_loader._inFlight.find(std::make_tuple(args...));
+                if(it != in_loader._inFlight.end() && it->second._result == result)
+                    in_loader._inFlight.erase(it);
+            });
+            return h;
+        }
+
         virtual ~AssetManager() { clear(); }
 
         uint nbLoaders() const { return _loaders.size(); }
@@ -48,7 +146,84 @@ namespace resource
             std::for_each(_loaders.begin(), _loaders.end(), [](GenericLoader* l) { l->clear(); });
         }
 
+        /* 0 is unlimited (default) */
+        void setBudget(size_t bytes) { _budget = bytes; }
+        size_t budget() const { return _budget; }
+
+        void setReleaseHook(ReleaseHook hook)
+        {
+            std::lock_guard<std::mutex> guard(_trimMutex);
+            _releaseHook = hook;
+        }
+
+        /* Evict unreferenced assets, least recently used first, until the cache fits in the budget. Return the bytes evicted. */
+        size_t trim() { return _budget > 0 ? trim(_budget) : 0; }
+        size_t trim(size_t maxBytes)
+        {
+            std::lock_guard<std::mutex> guard(_trimMutex);
+
+            size_t total = 0;
+            vector<Cached> cached = collect(total);
+            if(total <= maxBytes)
+                return 0;
+
+            std::sort(cached.begin(), cached.end(), [](const Cached& a, const Cached& b) { return a.lastUse < b.lastUse; });
+
+            vector<T> released;
+            size_t evicted = 0;
+            for(size_t i=0 ; i<cached.size() && total > maxBytes ; ++i)
+            {
+                if(!cached[i].unreferenced())
+                    continue;
+
+                for(GenericLoader* l : _loaders)
+                    l->evict(cached[i].id, released);
+
+                total -= cached[i].bytes;
+                evicted += cached[i].bytes;
+                ++_evictions;
+            }
+            _evictedBytes += evicted;
+
+            for(T& asset : released)
+            {
+                // the last reference, unless it was copied from the cache in between
+                if(asset.useCount() == 1)
+                    _releaseHook([asset]() mutable { asset = T(); });
+            }
+            return evicted;
+        }
+
+        Stats stats()
+        {
+            std::lock_guard<std::mutex> guard(_trimMutex);
+
+            Stats s;
+            vector<Cached> cached = collect(s.bytes);
+            s.assets = cached.size();
+            for(const Cached& c : cached)
+            {
+                s.unreferenced += c.unreferenced() ? 1 : 0;
+                s.unreferencedBytes += c.unreferenced() ? c.bytes : 0;
+            }
+            s.evictions = _evictions;
+            s.evictedBytes = _evictedBytes;
+            s.budget = _budget;
+            return s;
+        }
+
     private:
+        /* An asset of the cache, it can be under several arguments */
+        struct Cached
+        {
+            const void* id;
+            size_t bytes;
+            long useCount, cacheRefs;
+            uint64_t lastUse;
+
+            bool unreferenced() const { return useCount <= cacheRefs; }
+        };
+
         class GenericLoader
         {
         public:
@@ -56,17 +231,84 @@ namespace resource
             virtual ~GenericLoader() = default;
 
             virtual void clear() = 0;
+            virtual void collect(std::unordered_map<const void*, Cached>&) const = 0;
+            virtual void evict(const void* id, vector<T>& released) = 0;
+
+            /* Kept up to date by add and evict, so a load only scans the cache when the budget may be exceeded.
+             * Counted by entry (an asset under several arguments counts for each), it's never below the real total. */
+            mutable std::atomic<size_t> cachedBytes = 0;
+            mutable std::atomic<bool> unsized = false; // an entry still loading with load<true>, the loads scan until it's loaded
         };
 
         vector<GenericLoader*> _loaders;
         SpinLock _lock;
 
+        std::atomic<size_t> _budget = 0;
+        std::mutex _trimMutex;
+        size_t _evictions = 0, _evictedBytes = 0;
+        ReleaseHook _releaseHook = [](std::function<void()> f)
+        {
+            if(renderer::getThreadId() == renderer::openGL.getContextId()) f();
+            else renderer::openGL.pushGLTask(f);
+        };
+
         void addLoaders(GenericLoader* l)
         {
             std::lock_guard<SpinLock> guard(_lock);
             _loaders.push_back(l);
         }
 
+        bool mayExceedBudget() const
+        {
+            const size_t budget = _budget;
+            if(budget == 0)
+                return false;
+
+            size_t total = 0;
+            for(const GenericLoader* l : _loaders)
+            {
+                if(l->unsized) return true;
+                total += l->cachedBytes;
+            }
+            return total > budget;
+        }
+
+        static uint64_t nextUse()
+        {
+            static std::atomic<uint64_t> counter = 0;
+            return ++counter;
+        }
+
+        static size_t bytes(const T& asset)
+        {
+            if constexpr(requires { asset.bytes(); }) return asset.bytes();
+            else return 0;
+        }
+
+        /* False while the asset is loading (load<true>), its size is unknown. Shared buffers are known and can have 0 bytes. */
+        static bool sized(const T& asset)
+        {
+            if constexpr(requires { asset.isEmpty(); }) return !asset.isEmpty();
+            else return true;
+        }
+
+        vector<Cached> collect(size_t& total) const
+        {
+            std::unordered_map<const void*, Cached> byId;
+            for(GenericLoader* l : _loaders)
+                l->collect(byId);
+
+            vector<Cached> cached;
+            cached.reserve(byId.size());
+            total = 0;
+            for(auto& c : byId)
+            {
+                cached.push_back(c.second);
+                total += c.second.bytes;
+            }
+            return cached;
+        }
+
         template <typename... Args>
         class Loader : GenericLoader
         {
@@ -76,29 +318,86 @@ namespace resource
 
             Option<T> get(Args... args) const
             {
-                std::lock_guard<SpinLock> guard(_lock);
+                std::shared_lock<SharedSpinLock> guard(_lock);
                 auto it = _assets.find(std::make_tuple(args...));
                 if(it == _assets.end()) return Option<T>();
-                else return Option<T>(it->second);
+
+                it->second.lastUse = nextUse();
+                return Option<T>(it->second.asset);
             }
 
             void add(Args... args, const T& asset)
             {
-                std::lock_guard<SpinLock> guard(_lock);
-                _assets[std::make_tuple(args...)] = asset;
+                std::lock_guard<SharedSpinLock> guard(_lock);
+                Entry& e = _assets[std::make_tuple(args...)];
+                e.asset = asset;
+                e.lastUse = nextUse();
+                resize(e, AssetManager::bytes(asset));
+                if(!AssetManager::sized(asset))
+                    this->unsized = true;
             }
 
             void clear() override
             {
-                 std::lock_guard<SpinLock> guard(_lock);
+                 std::lock_guard<SharedSpinLock> guard(_lock);
                 _assets.clear();
+                this->cachedBytes = 0;
+                this->unsized = false;
+            }
+
+            void collect(std::unordered_map<const void*, Cached>& byId) const override
+            {
+                std::shared_lock<SharedSpinLock> guard(_lock);
+                this->unsized = false;
+                for(const auto& a : _assets)
+                {
+                    const T& asset = a.second.asset;
+                    resize(a.second, AssetManager::bytes(asset));
+                    if(!AssetManager::sized(asset))
+                        this->unsized = true;
+                    auto it = byId.try_emplace(asset.id(), Cached{ asset.id(), a.second.bytes, asset.useCount(), 0, 0 }).first;
+                    it->second.cacheRefs++;
+                    it->second.lastUse = std::max<uint64_t>(it->second.lastUse, a.second.lastUse);
+                }
+            }
+
+            void evict(const void* id, vector<T>& released) override
+            {
+                std::lock_guard<SharedSpinLock> guard(_lock);
+                for(auto it = _assets.begin() ; it != _assets.end() ; )
+                {
+                    if(it->second.asset.id() == id)
+                    {
+                        resize(it->second, 0);
+                        released.push_back(it->second.asset);
+                        it = _assets.erase(it);
+                    }
+                    else ++it;
+                }
             }
 
             //typename std::map<std::tuple<Args...>, T>::const_iterator begin() const { return _assets.begin(); }
             //typename std::map<std::tuple<Args...>, T>::const_iterator end() const { return _assets.end(); }
 
-            std::map<std::tuple<Args...>, T> _assets;
-            mutable SpinLock _lock;
+            struct Entry
+            {
+                T asset;
+                mutable std::atomic<uint64_t> lastUse = 0; // updated by the hits, under the shared lock
+                mutable size_t bytes = 0;                  // in cachedBytes, updated by collect under the trim mutex
+            };
+
+            void resize(const Entry& e, size_t bytes) const
+            {
+                this->cachedBytes += bytes;
+                this->cachedBytes -= e.bytes;
+                e.bytes = bytes;
+            }
+
+            std::map<std::tuple<Args...>, Entry> _assets;
+            mutable SharedSpinLock _lock; // cache hits only take it shared
+
+            std::map<std::tuple<Args...>, Handle> _inFlight; // loadAsync not finished yet
+            std::mutex _inFlightMutex;
         };
 
 		template <typename... Args>
@@ -107,8 +406,14 @@ namespace resource
 		public:
 			StaticLoader() : Loader<Args...>(), AssetLoader<T>() {}
 		};
-    };
 
+        template <typename... Args>
+        static StaticLoader<Args...>& loader()
+        {
+            static StaticLoader<Args...> in_loader;
+            return in_loader;
+        }
+    };
 
 }
 }
@@ -0,0 +1,255 @@
+#include "LoadQueue.h"
+#include "renderer/renderer.h"
+#include "renderer/DeviceFunctionnality.h"
+
+#include "MemoryLoggerOn.h"
+namespace tim
+{
+    using namespace core;
+namespace resource
+{
+
+namespace
+{
+    void runOnGl(const std::function<void()>& f)
+    {
+        if(renderer::getThreadId() == renderer::openGL.getContextId()) f();
+        else renderer::openGL.pushGLTask(f);
+    }
+}
+
+LoadQueue::Status LoadQueue::Handle::status() const
+{
+    std::lock_guard<std::mutex> guard(_queue->_mutex);
+    return _state->status;
+}
+
+int LoadQueue::Handle::priority() const
+{
+    std::lock_guard<std::mutex> guard(_queue->_mutex);
+    return _state->priority;
+}
+
+void LoadQueue::Handle::setPriority(int p)
+{
+    std::lock_guard<std::mutex> guard(_queue->_mutex);
+    _state->priority = p;
+}
+
+bool LoadQueue::Handle::cancel()
+{
+    {
+        std::lock_guard<std::mutex> guard(_queue->_mutex);
+        if(_state->status != PENDING)
+            return false;
+
+        auto it = std::find(_queue->_pending.begin(), _queue->_pending.end(), _state);
+        if(it != _queue->_pending.end())
+            _queue->_pending.erase(it);
+        --_queue->_progress.pending;
+        ++_queue->_progress.loading; // finish() moves it to cancelled
+        _state->job = nullptr;
+    }
+
+    _queue->finish(_state, CANCELLED);
+    return true;
+}
+
+void LoadQueue::Handle::onComplete(std::function<void(Status)> f) const
+{
+    std::unique_lock<std::mutex> guard(_queue->_mutex);
+    const Status s = _state->status;
+    if(s == PENDING || s == LOADING)
+    {
+        _state->callbacks.push_back(f);
+        return;
+    }
+
+    guard.unlock();
+    runOnGl([=]() { f(s); });
+}
+
+LoadQueue::Group::Group() : _shared(std::make_shared<Shared>())
+{
+
+}
+
+void LoadQueue::Group::add(const Handle& h)
+{
+    {
+        std::lock_guard<std::mutex> guard(_shared->mutex);
+        ++_shared->remaining;
+    }
+    _handles.push_back(h);
+
+    auto shared = _shared;
+    h.onComplete([shared](Status s)
+    {
+        vector<std::function<void(bool)>> callbacks;
+        bool allDone;
+        {
+            std::lock_guard<std::mutex> guard(shared->mutex);
+            shared->allDone = shared->allDone && s == DONE;
+            allDone = shared->allDone;
+            if(--shared->remaining == 0)
+                callbacks.swap(shared->callbacks);
+        }
+
+        for(auto& f : callbacks)
+            f(allDone);
+    });
+}
+
+void LoadQueue::Group::add(const Group& g)
+{
+    for(const Handle& h : g._handles)
+        add(h);
+}
+
+void LoadQueue::Group::onComplete(std::function<void(bool)> f)
+{
+    std::unique_lock<std::mutex> guard(_shared->mutex);
+    if(_shared->remaining > 0)
+    {
+        _shared->callbacks.push_back(f);
+        return;
+    }
+
+    const bool allDone = _shared->allDone;
+    guard.unlock();
+    runOnGl([=]() { f(allDone); });
+}
+
+void LoadQueue::Group::setPriority(int p)
+{
+    for(Handle& h : _handles)
+        h.setPriority(p);
+}
+
+void LoadQueue::Group::cancel()
+{
+    for(Handle& h : _handles)
+        h.cancel();
+}
+
+float LoadQueue::Group::progress() const
+{
+    if(_handles.empty())
+        return 1;
+
+    std::lock_guard<std::mutex> guard(_shared->mutex);
+    return float(_handles.size() - _shared->remaining) / _handles.size();
+}
+
+LoadQueue::Handle LoadQueue::submit(int priority, Job job)
+{
+    Handle h;
+    h._queue = this;
+    h._state = std::make_shared<State>();
+    h._state->job = std::move(job);
+    h._state->priority = priority;
+
+    std::unique_lock<std::mutex> guard(_mutex);
+    h._state->order = _nextOrder++;
+    _pending.push_back(h._state);
+    ++_progress.total;
+    ++_progress.pending;
+
+    startJobs(guard);
+    return h;
+}
+
+LoadQueue::Handle LoadQueue::done(bool success)
+{
+    Handle h;
+    h._queue = this;
+    h._state = std::make_shared<State>();
+    h._state->status = success ? DONE : FAILED;
+    return h;
+}
+
+void LoadQueue::startJobs(std::unique_lock<std::mutex>& guard)
+{
+    vector<std::shared_ptr<State>> toRun;
+    while(_loading < _maxLoading && !_pending.empty())
+    {
+        auto best = _pending.begin();
+        for(auto it = _pending.begin() ; it != _pending.end() ; ++it)
+        {
+            if((*it)->priority > (*best)->priority || ((*it)->priority == (*best)->priority && (*it)->order < (*best)->order))
+                best = it;
+        }
+
+        (*best)->status = LOADING;
+        toRun.push_back(*best);
+        _pending.erase(best);
+
+        ++_loading;
+        --_progress.pending;
+        ++_progress.loading;
+    }
+
+    guard.unlock();
+    for(auto& state : toRun)
+        renderer::globalThreadPool.schedule([this, state]() { run(state); });
+    guard.lock();
+}
+
+void LoadQueue::run(std::shared_ptr<State> state)
+{
+    GlPart gl = state->job();
+    state->job = nullptr;
+
+    {
+        // the next job can start while this one waits for the gl thread
+        std::unique_lock<std::mutex> guard(_mutex);
+        --_loading;
+        startJobs(guard);
+    }
+
+    if(!gl)
+    {
+        finish(state, FAILED);
+        return;
+    }
+
+    runOnGl([this, state, gl]() { finish(state, gl() ? DONE : FAILED); });
+}
+
+void LoadQueue::finish(const std::shared_ptr<State>& state, Status status)
+{
+    vector<std::function<void(Status)>> callbacks;
+    {
+        std::lock_guard<std::mutex> guard(_mutex);
+        state->status = status;
+        callbacks.swap(state->callbacks);
+
+        --_progress.loading;
+        if(status == DONE) ++_progress.done;
+        else if(status == FAILED) ++_progress.failed;
+        else ++_progress.cancelled;
+    }
+
+    runOnGl([=]()
+    {
+        for(auto& f : callbacks)
+            f(status);
+    });
+}
+
+LoadQueue::Progress LoadQueue::progress() const
+{
+    std::lock_guard<std::mutex> guard(_mutex);
+    return _progress;
+}
+
+void LoadQueue::resetProgress()
+{
+    std::lock_guard<std::mutex> guard(_mutex);
+    _progress.total = _progress.pending + _progress.loading;
+    _progress.done = _progress.failed = _progress.cancelled = 0;
+}
+
+}
+}
+#include "MemoryLoggerOff.h"
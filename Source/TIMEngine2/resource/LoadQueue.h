@@ -0,0 +1,143 @@
+#ifndef LOADQUEUE_H_INCLUDED
+#define LOADQUEUE_H_INCLUDED
+
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include "core/core.h"
+#include "Singleton.h"
+#include "ThreadPool.h"
+
+#include "MemoryLoggerOn.h"
+namespace tim
+{
+    using namespace core;
+namespace resource
+{
+    /* Asynchronous loads by priority. A job runs in two parts: the first one on the thread pool (reading, decoding),
+     * which returns the second one, run on the gl thread (upload) and returning whether it succeeded.
+     * Pending jobs start by decreasing priority (FIFO for the same priority), their priority can be changed or they
+     * can be cancelled until they start. The completion callbacks are called on the gl thread.
+     * The assets are requested with AssetManager::loadAsync, which fills the cache. */
+    class LoadQueue : public Singleton<LoadQueue>
+    {
+        friend class Singleton<LoadQueue>;
+
+    public:
+        enum Status { PENDING, LOADING, DONE, FAILED, CANCELLED };
+
+        using GlPart = std::function<bool()>;
+        using Job = std::function<GlPart()>;
+
+        struct Progress
+        {
+            size_t total = 0; // since the last resetProgress
+            size_t pending = 0, loading = 0, done = 0, failed = 0, cancelled = 0;
+
+            size_t finished() const { return done + failed + cancelled; }
+            float ratio() const { return total == 0 ? 1 : float(finished()) / total; }
+        };
+
+    private:
+        struct State
+        {
+            Job job;
+            int priority;
+            uint64_t order;
+            Status status = PENDING;
+            vector<std::function<void(Status)>> callbacks;
+        };
+
+    public:
+        /* A submitted job */
+        class Handle
+        {
+            friend class LoadQueue;
+
+        public:
+            Handle() = default;
+
+            bool isNull() const { return _state == nullptr; }
+
+            Status status() const;
+            bool finished() const { Status s = status(); return s == DONE || s == FAILED || s == CANCELLED; }
+
+            int priority() const;
+            /* No effect once started */
+            void setPriority(int);
+            /* Return false if it's already started */
+            bool cancel();
+
+            /* f(Status) on the gl thread, right away if it's finished */
+            void onComplete(std::function<void(Status)> f) const;
+
+        protected:
+            std::shared_ptr<State> _state;
+            LoadQueue* _queue = nullptr;
+        };
+
+        /* Jobs depending on each other, complete when all of them are finished */
+        class Group
+        {
+        public:
+            Group();
+
+            void add(const Handle&);
+            /* The jobs of another group */
+            void add(const Group&);
+
+            /* f(bool allDone) on the gl thread once every job added is finished, allDone is false if one failed or was cancelled.
+             * To call after the adds, right away if they're all finished. */
+            void onComplete(std::function<void(bool)> f);
+
+            void setPriority(int);
+            void cancel();
+
+            /* Part of the jobs whose completion callback ran */
+            float progress() const;
+            size_t size() const { return _handles.size(); }
+
+        private:
+            struct Shared
+            {
+                std::mutex mutex;
+                size_t remaining = 0;
+                bool allDone = true;
+                vector<std::function<void(bool)>> callbacks;
+            };
+
+            vector<Handle> _handles;
+            std::shared_ptr<Shared> _shared;
+        };
+
+        /* priority: higher first */
+        Handle submit(int priority, Job job);
+
+        /* Handle already finished, for the requests served without loading */
+        Handle done(bool success = true);
+
+        Progress progress() const;
+        void resetProgress();
+
+        /* Number of jobs run at once on the pool, the others wait in the queue so a bumped priority is taken into account */
+        void setMaxLoading(uint n) { _maxLoading = std::max(n, 1u); }
+
+    private:
+        LoadQueue() = default;
+        ~LoadQueue() = default;
+
+        mutable std::mutex _mutex;
+        vector<std::shared_ptr<State>> _pending;
+        uint64_t _nextOrder = 0;
+        uint _maxLoading = 2, _loading = 0;
+        Progress _progress;
+
+        void startJobs(std::unique_lock<std::mutex>&);
+        void run(std::shared_ptr<State>);
+        void finish(const std::shared_ptr<State>&, Status);
+    };
+}
+}
+#include "MemoryLoggerOff.h"
+
+#endif // LOADQUEUE_H_INCLUDED
@@ -0,0 +1,61 @@
+#include "MeshAnalysis.h"
+#include "MeshLoader.h"
+#include <meshoptimizer.h>
+
+#include "MemoryLoggerOn.h"
+namespace tim
+{
+    using namespace core;
+namespace resource
+{
+
+namespace
+{
+    MeshAnalysis::Lod analyzeLod(const renderer::MeshData& data, const uint* indices, uint nbIndex)
+    {
+        MeshAnalysis::Lod lod;
+        lod.nbTriangle = nbIndex / 3;
+        if(!lod.nbTriangle)
+            return lod;
+
+        const meshopt_VertexCacheStatistics cache = meshopt_analyzeVertexCache(indices, nbIndex, data.nbVertex, MeshAnalysis::CACHE_SIZE, 0, 0);
+        const meshopt_OverdrawStatistics overdraw = meshopt_analyzeOverdraw(indices, nbIndex, &data.vData[0].v[0], data.nbVertex, sizeof(renderer::MeshData::DataType));
+        const meshopt_VertexFetchStatistics fetch = meshopt_analyzeVertexFetch(indices, nbIndex, data.nbVertex, sizeof(renderer::MeshData::DataType));
+
+        lod.acmr = cache.acmr;
+        lod.atvr = cache.atvr;
+        lod.overdraw = overdraw.overdraw;
+        lod.overfetch = fetch.overfetch;
+        return lod;
+    }
+}
+
+MeshAnalysis analyzeMesh(const renderer::MeshData& data)
+{
+    MeshAnalysis res;
+    res.nbVertex = data.nbVertex;
+    if(!data.nbVertex || !data.nbIndex)
+        return res;
+
+    res.lods.push_back(analyzeLod(data, data.indexData, data.nbIndex));
+    if(data.secondaryIndexData)
+        res.lods.push_back(analyzeLod(data, data.secondaryIndexData, data.nbSecondaryIndex));
+
+    res.storedBounds = data.hasBounds;
+    res.sphere = MeshLoader::volume(data);
+    res.box = Box::computeBox(reinterpret_cast<const real*>(data.vData), data.nbVertex, sizeof(renderer::MeshData::DataType)/sizeof(float));
+
+    const float boxRadius = (res.box.max() - res.box.min()).length() * 0.5f;
+    res.sphereToBoxRatio = boxRadius > 0 ? res.sphere.radius() / boxRadius : 1;
+
+    // a little slack for the rounding of the fit
+    const float maxDist = res.sphere.radius() * 1.0001f + 1e-5f;
+    for(uint i=0 ; i<data.nbVertex && res.containsAll ; ++i)
+        res.containsAll = (data.vData[i].v - res.sphere.center()).length2() <= maxDist*maxDist;
+
+    return res;
+}
+
+}
+}
+#include "MemoryLoggerOff.h"
@@ -0,0 +1,44 @@
+#ifndef MESHANALYSIS_H_INCLUDED
+#define MESHANALYSIS_H_INCLUDED
+
+#include "core/core.h"
+#include "renderer/MeshBuffers.h"
+
+#include "MemoryLoggerOn.h"
+namespace tim
+{
+    using namespace core;
+namespace resource
+{
+    /* Efficiency of the gpu data of a mesh, with the meshoptimizer analyzers */
+    struct MeshAnalysis
+    {
+        static constexpr uint CACHE_SIZE = 16; // fifo cache, as on most desktop gpus
+
+        struct Lod
+        {
+            uint nbTriangle = 0;
+            float acmr = 0;      // transformed vertices per triangle, 0.5 best, 3 worst
+            float atvr = 0;      // transformed vertices per vertex, 1 best
+            float overdraw = 0;  // shaded pixels per covered pixel from random views, 1 best
+            float overfetch = 0; // fetched bytes per vertex byte, 1 best
+        };
+
+        uint nbVertex = 0;
+        vector<Lod> lods; // the index buffer then the secondary one
+
+        /* Bounding sphere used by the engine (MeshLoader::volume) against the circumsphere of the box of the vertices:
+         * under 1 the sphere is tighter than the box one. containsAll is false if a vertex is outside of it. */
+        Sphere sphere;
+        Box box;
+        float sphereToBoxRatio = 0;
+        bool containsAll = true;
+        bool storedBounds = false; // the bounds came from the file (.tim v2)
+    };
+
+    MeshAnalysis analyzeMesh(const renderer::MeshData&);
+}
+}
+#include "MemoryLoggerOff.h"
+
+#endif // MESHANALYSIS_H_INCLUDED
@@ -1,7 +1,15 @@
 #include "MeshLoader.h"
 #include "core/core.h"
 #include "Sphere.h"
+#include "Box.h"
+#include "Hash.h"
+#include "FileSystem.h"
 #include <fstream>
+#include <charconv>
+#include <chrono>
+#include <atomic>
+#include <climits>
+#include <mutex>
 #include <meshoptimizer.h>
 
 #include "MemoryLoggerOn.h"
@@ -24,9 +32,8 @@ renderer::MeshData MeshLoader::importObj(const std::string& file, bool tangent)
     if(!loadObjData(file, buf))
         return meshData;
 
-    VNC_Map mapIndex;
-
-    size_t nbVertex = computeObjVertexMap(buf, meshData, mapIndex);
+    vector<uivec3> vertices;
+    size_t nbVertex = computeObjVertexMap(buf, meshData, vertices);
 
     if(buf.nbNormal && buf.nbTexCoord && tangent)
             meshData.format = renderer::VertexFormat::VNCT;
@@ -40,12 +47,13 @@ renderer::MeshData MeshLoader::importObj(const std::string& file, bool tangent)
     meshData.nbVertex = nbVertex;
     meshData.vData = new renderer::MeshData::DataType[nbVertex];
 
-	for (auto it : mapIndex)
-	{
-        meshData.vData[it.second] = { it.first[0]==0 ? vec3(0,0,0) : buf.vbuffer[it.first[0]-1],
-                                      it.first[2]==0 ? vec3(0,0,0) : buf.nbuffer[it.first[2]-1],
-                                      it.first[1]==0 ? vec2(0,0)   : buf.tbuffer[it.first[1]-1], vec3() };
-	}
+    renderer::globalThreadPool.parallelFor(0, nbVertex, 1 << 14, [&](size_t i)
+    {
+        const uivec3& v = vertices[i];
+        meshData.vData[i] = { v[0]==0 ? vec3(0,0,0) : buf.vbuffer[v[0]-1],
+                              v[2]==0 ? vec3(0,0,0) : buf.nbuffer[v[2]-1],
+                              v[1]==0 ? vec2(0,0)   : buf.tbuffer[v[1]-1], vec3() };
+    });
 
     if(meshData.format == renderer::VertexFormat::VNCT)
     {
@@ -68,102 +76,288 @@ renderer::MeshBuffers* MeshLoader::createMeshBuffers(renderer::MeshData& data, r
         if (ib2) {
             ib2->flush(data.secondaryIndexData, 0, data.nbSecondaryIndex);
         }
-        return new renderer::MeshBuffers(vb, ib, ib2, Sphere::computeSphere(reinterpret_cast<real*>(data.vData), data.nbVertex,
-                                                                            sizeof(renderer::MeshData::DataType)/sizeof(float)));
+        return new renderer::MeshBuffers(vb, ib, ib2, volume(data));
     }
     else return nullptr;
 
 }
 
-#include "MemoryLoggerOff.h"
-class IterateLine
+namespace
 {
-public:
-    IterateLine() = delete;
-    IterateLine(const IterateLine&) = delete;
+    std::mutex gpuStatsMutex;
+    MeshLoader::GpuFormatStats gpuStats;
 
-    IterateLine(std::unique_ptr<char[]>&& buf, size_t size) : buffer(std::move(buf)), sizeBuf(size) {}
+    void packIndices(const uint* indices, uint nb, vector<uint>& out)
+    {
+        out.assign((nb+1) / 2, 0);
+        unsigned short* ptr = reinterpret_cast<unsigned short*>(out.data());
+        for(uint i=0 ; i<nb ; ++i)
+            ptr[i] = static_cast<unsigned short>(indices[i]);
+    }
+}
 
-    bool nextLine(std::string& str)
+MeshLoader::GpuData MeshLoader::prepareGpuData(const renderer::MeshData& data, bool packVertex)
+{
+    GpuData gpu;
+    gpu.vData = reinterpret_cast<const float*>(data.vData);
+    gpu.indexData = data.indexData;
+    gpu.secondaryIndexData = data.secondaryIndexData;
+    gpu.nbVertex = data.nbVertex;
+    gpu.nbIndex = data.nbIndex;
+    gpu.nbSecondaryIndex = data.secondaryIndexData ? data.nbSecondaryIndex : 0;
+
+    if(packVertex)
     {
-        str.clear();
-        while(index < sizeBuf)
+        bool fit = true;
+        for(uint i=0 ; i<data.nbVertex && fit ; ++i)
         {
-            if(finish)
-                return false;
+            const renderer::MeshData::DataType& v = data.vData[i];
+            for(int j=0 ; j<3 ; ++j)
+                fit = fit && fabsf(v.n[j]) <= 1.001f && fabsf(v.t[j]) <= 1.001f;
+            fit = fit && fabsf(v.c[0]) <= PACKED_MAX_UV && fabsf(v.c[1]) <= PACKED_MAX_UV;
+        }
 
-            if(buffer[index] == '\n')
-            {
-                ++index; return true;
-            }
-            else if(buffer[index] == '\0')
-            {
-                finish = true;
-                return str.size() > 0;
-            }
+        if(fit)
+        {
+            gpu.format = renderer::VNCT_PACKED;
+            gpu.packedVertex.resize(data.nbVertex);
+            for(uint i=0 ; i<data.nbVertex ; ++i)
+                gpu.packedVertex[i] = renderer::packVertex(data.vData[i]);
+            gpu.vData = reinterpret_cast<const float*>(gpu.packedVertex.data());
+        }
+    }
 
-            str += buffer[index++];
+    if(data.nbVertex <= 65536)
+    {
+        gpu.shortIndex = true;
+        packIndices(data.indexData, gpu.nbIndex, gpu.packedIndex);
+        gpu.indexData = gpu.packedIndex.data();
+        if(gpu.secondaryIndexData)
+        {
+            packIndices(data.secondaryIndexData, gpu.nbSecondaryIndex, gpu.packedSecondaryIndex);
+            gpu.secondaryIndexData = gpu.packedSecondaryIndex.data();
         }
+    }
+
+    const size_t fullSize = sizeof(renderer::VNCT_Vertex)*gpu.nbVertex + sizeof(uint)*(gpu.nbIndex + gpu.nbSecondaryIndex);
+    const size_t size = gpu.bytes();
+
+    std::lock_guard<std::mutex> guard(gpuStatsMutex);
+    ++gpuStats.meshes;
+    gpuStats.packedMeshes += gpu.format == renderer::VNCT_PACKED ? 1 : 0;
+    gpuStats.shortIndexMeshes += gpu.shortIndex ? 1 : 0;
+    gpuStats.bytes += size;
+    gpuStats.bytesSaved += fullSize - size;
+    return gpu;
+}
+
+size_t MeshLoader::GpuData::bytes() const
+{
+    return sizeof(float)*renderer::vertexFormatSize(format)*nbVertex +
+           sizeof(uint)*(shortIndex ? packedIndex.size() + packedSecondaryIndex.size() : nbIndex + nbSecondaryIndex);
+}
+
+renderer::MeshBuffers* MeshLoader::allocMeshBuffers(const GpuData& gpu, const Sphere& volume, renderer::MeshData* cpuData)
+{
+    renderer::VertexBufferPoolType* vpool = gpu.format == renderer::VNCT_PACKED ? renderer::packedVertexBufferPool : renderer::vertexBufferPool;
+    const uint nbIndexSlot = gpu.shortIndex ? gpu.packedIndex.size() : gpu.nbIndex;
+    const uint nbSecondaryIndexSlot = gpu.shortIndex ? gpu.packedSecondaryIndex.size() : gpu.nbSecondaryIndex;
+
+    renderer::VBuffer* vb = vpool->alloc(gpu.nbVertex);
+    renderer::IBuffer* ib = renderer::indexBufferPool->alloc(nbIndexSlot);
+    renderer::IBuffer* ib2 = gpu.secondaryIndexData ? renderer::indexBufferPool->alloc(nbSecondaryIndexSlot) : nullptr;
+
+    // the number of indices to draw
+    ib->setSize(gpu.nbIndex);
+    if(ib2) ib2->setSize(gpu.nbSecondaryIndex);
+
+    renderer::MeshBuffers* mb = new renderer::MeshBuffers(vb, ib, ib2, volume, cpuData);
+    mb->setShortIndex(gpu.shortIndex);
+    return mb;
+}
+
+void MeshLoader::flushMeshBuffers(const GpuData& gpu, const renderer::MeshBuffers& mb)
+{
+    mb.vb()->flush(gpu.vData, 0, gpu.nbVertex);
+    mb.ib()->flush(gpu.indexData, 0, mb.ib()->capacity());
+    if(mb.hasSecondaryIndexBuffer())
+        mb.ib(true)->flush(gpu.secondaryIndexData, 0, mb.ib(true)->capacity());
+}
+
+MeshLoader::GpuFormatStats MeshLoader::gpuFormatStats()
+{
+    std::lock_guard<std::mutex> guard(gpuStatsMutex);
+    return gpuStats;
+}
 
-        finish = true;
-        return str.size() > 0;
+namespace
+{
+    /* The file is parsed by chunks of whole lines on the thread pool: a first pass counts the elements of each chunk
+     * so the second one knows where to write them. The parsing accepts what the sscanf based loader accepted. */
+    const size_t OBJ_CHUNK_SIZE = 1 << 20;
+
+    struct ObjChunk
+    {
+        const char *begin, *end;
+        size_t nbVertex=0, nbNormal=0, nbTexCoord=0, nbIndex=0; // counts, then offsets of the chunk in the buffers
+    };
+
+    bool isBlank(char c) { return c == ' ' || (c >= '\t' && c <= '\r'); }
+
+    bool startWith(const char* ptr, const char* end, const char* prefix, size_t size)
+    {
+        return size_t(end - ptr) >= size && memcmp(ptr, prefix, size) == 0;
     }
 
-    void reset()
+    template <class F>
+    void forEachLine(const ObjChunk& chunk, F f)
     {
-        index = 0;
-        finish = false;
+        for(const char* line=chunk.begin ; line<chunk.end ; )
+        {
+            const char* eol = static_cast<const char*>(memchr(line, '\n', chunk.end - line));
+            if(!eol) eol = chunk.end;
+            if(!f(line, eol))
+                return;
+            line = eol + 1;
+        }
     }
 
-    static bool startWith(const std::string& str, const std::string& prefix)
+    /* As %f, which also takes a '+' */
+    bool parseFloat(const char*& ptr, const char* end, float& f)
     {
-        if(str.size() < prefix.size())
+        while(ptr < end && isBlank(*ptr)) ++ptr;
+        if(ptr < end && *ptr == '+' && ++ptr < end && *ptr == '-')
+            return false;
+
+        const std::from_chars_result res = std::from_chars(ptr, end, f);
+        if(res.ec != std::errc())
             return false;
-        else return std::equal(prefix.begin(), prefix.end(), str.begin());
+        ptr = res.ptr;
+        return true;
     }
 
-    std::unique_ptr<char[]> buffer;
-    size_t sizeBuf;
-    size_t index=0;
-    bool finish = false;
-};
-#include "MemoryLoggerOn.h"
+    /* As %u, but a negative index is relative to the count of elements read so far (obj convention) */
+    bool parseIndex(const char*& ptr, const char* end, size_t relativeTo, uint& index)
+    {
+        const bool negative = ptr < end && *ptr == '-';
+        const char* start = ptr + ((negative || (ptr < end && *ptr == '+')) ? 1 : 0);
+
+        uint value;
+        const std::from_chars_result res = std::from_chars(start, end, value);
+        if(res.ec != std::errc())
+            return false;
+
+        ptr = res.ptr;
+        index = negative ? uint(relativeTo + 1 - value) : value;
+        return true;
+    }
+
+    /* Dedupe of the v/t/n triplets: linear probing table of indexes in the vector of the unique triplets */
+    class ObjVertexTable
+    {
+    public:
+        ObjVertexTable(vector<uivec3>& vertices, size_t expected) : _vertices(vertices)
+        {
+            size_t capacity = 16;
+            while(capacity < expected * 2) capacity *= 2;
+            _table.assign(capacity, EMPTY);
+        }
+
+        /* The index of the triplet, added at the end of the vertices if it is new */
+        uint insert(const uivec3& key)
+        {
+            for(size_t i = hash(key) & (_table.size()-1) ; ; i = (i+1) & (_table.size()-1))
+            {
+                if(_table[i] == EMPTY)
+                {
+                    _table[i] = _vertices.size();
+                    _vertices.push_back(key);
+                    if(_vertices.size() * 2 > _table.size())
+                        grow();
+                    return _vertices.size() - 1;
+                }
+                if(_vertices[_table[i]] == key)
+                    return _table[i];
+            }
+        }
+
+    private:
+        static constexpr uint EMPTY = UINT_MAX;
+
+        vector<uivec3>& _vertices;
+        vector<uint> _table;
+
+        static size_t hash(const uivec3& v)
+        {
+            uint64_t h = v[0] * 0x9E3779B97F4A7C15ull ^ v[1] * 0xC2B2AE3D27D4EB4Full ^ v[2] * 0x165667B19E3779F9ull;
+            h ^= h >> 29;
+            h *= 0xBF58476D1CE4E5B9ull;
+            return size_t(h ^ (h >> 32));
+        }
+
+        void grow()
+        {
+            _table.assign(_table.size() * 2, EMPTY);
+            for(uint v=0 ; v<_vertices.size() ; ++v)
+            {
+                size_t i = hash(_vertices[v]) & (_table.size()-1);
+                while(_table[i] != EMPTY)
+                    i = (i+1) & (_table.size()-1);
+                _table[i] = v;
+            }
+        }
+    };
+}
 
 bool MeshLoader::loadObjData(const std::string& file, ObjBuffer& buffer)
 {
-    std::ifstream f_tmp(file, std::ios_base::binary);
-    if(!f_tmp)
+    FileData f = FileSystem::read(file);
+    if(!f.isOpen())
         return false;
 
-    f_tmp.seekg (0, f_tmp.end);
-    size_t sizeFile = f_tmp.tellg();
-    f_tmp.seekg (0, f_tmp.beg);
+    const auto start = std::chrono::steady_clock::now();
 
-    auto buf = std::unique_ptr<char[]>(new char[sizeFile]);
-    f_tmp.read(&buf[0], sizeFile);
-    f_tmp.close();
+    // parsed in place, in the mapping or the decoded archive entry
+    size_t sizeFile = f.size;
 
-    IterateLine iterline(std::move(buf), sizeFile);
+    // the file ends at the first '\0'
+    if(const char* zero = static_cast<const char*>(memchr(f.data, '\0', sizeFile)))
+        sizeFile = zero - f.data;
+
+    vector<ObjChunk> chunks;
+    for(const char* ptr=f.data, *end=f.data+sizeFile ; ptr<end ; )
+    {
+        const char* chunkEnd = ptr + std::min<size_t>(OBJ_CHUNK_SIZE, end - ptr);
+        while(chunkEnd < end && chunkEnd[-1] != '\n')
+            ++chunkEnd;
+        chunks.push_back({ptr, chunkEnd});
+        ptr = chunkEnd;
+    }
 
     buffer.nbVertex=0;
     buffer.nbNormal=0;
     buffer.nbTexCoord=0;
     buffer.nbIndex=0;
 
+    renderer::globalThreadPool.parallelFor(0, chunks.size(), 1, [&](size_t c)
     {
-        std::string s;
-
-        while(iterline.nextLine(s))
+        ObjChunk& chunk = chunks[c];
+        forEachLine(chunk, [&](const char* line, const char* eol)
         {
-            if(IterateLine::startWith(s,"v "))
-                ++buffer.nbVertex;
-            else if(IterateLine::startWith(s,"vn "))
-                ++buffer.nbNormal;
-            else if(IterateLine::startWith(s,"vt "))
-                ++buffer.nbTexCoord;
-            else if(IterateLine::startWith(s,"f "))
-                buffer.nbIndex+=3;
-        }
+            if(startWith(line, eol, "v ", 2)) ++chunk.nbVertex;
+            else if(startWith(line, eol, "vn ", 3)) ++chunk.nbNormal;
+            else if(startWith(line, eol, "vt ", 3)) ++chunk.nbTexCoord;
+            else if(startWith(line, eol, "f ", 2)) chunk.nbIndex += 3;
+            return true;
+        });
+    });
+
+    for(ObjChunk& chunk : chunks)
+    {
+        std::swap(chunk.nbVertex, buffer.nbVertex); buffer.nbVertex += chunk.nbVertex;
+        std::swap(chunk.nbNormal, buffer.nbNormal); buffer.nbNormal += chunk.nbNormal;
+        std::swap(chunk.nbTexCoord, buffer.nbTexCoord); buffer.nbTexCoord += chunk.nbTexCoord;
+        std::swap(chunk.nbIndex, buffer.nbIndex); buffer.nbIndex += chunk.nbIndex;
     }
 
     if(!buffer.nbVertex || !buffer.nbIndex)
@@ -178,172 +372,108 @@ bool MeshLoader::loadObjData(const std::string& file, ObjBuffer& buffer)
     if(buffer.nbTexCoord)
         buffer.tbuffer = new vec2[buffer.nbTexCoord];
 
+    const bool onlyVertex = buffer.nbNormal == 0 && buffer.nbTexCoord == 0;
+    std::atomic<bool> ok = true;
 
-    size_t vindex=0, nindex=0, tindex=0, iindex=0;
-    iterline.reset();
-    std::string s;
-
-    while(iterline.nextLine(s))
+    renderer::globalThreadPool.parallelFor(0, chunks.size(), 1, [&](size_t c)
     {
-        if(IterateLine::startWith(s, "v "))
+        ObjChunk chunk = chunks[c];
+        forEachLine(chunk, [&](const char* line, const char* eol)
         {
-            if(sscanf(s.c_str()+2, "%f %f %f", &(buffer.vbuffer[vindex][0]), &(buffer.vbuffer[vindex][1]), &(buffer.vbuffer[vindex][2])) == 3)
-                ++vindex;
-            else
+            if(startWith(line, eol, "v ", 2))
             {
-                buffer.free();
-                return false;
+                const char* ptr = line + 2;
+                vec3& v = buffer.vbuffer[chunk.nbVertex++];
+                if(!parseFloat(ptr, eol, v[0]) || !parseFloat(ptr, eol, v[1]) || !parseFloat(ptr, eol, v[2]))
+                    ok = false;
             }
-        }
-
-        else if(IterateLine::startWith(s, "vn "))
-        {
-            if(sscanf(s.c_str()+3, "%f %f %f", &(buffer.nbuffer[nindex][0]), &(buffer.nbuffer[nindex][1]), &(buffer.nbuffer[nindex][2])) == 3)
-                ++nindex;
-            else
+            else if(startWith(line, eol, "vn ", 3))
             {
-                buffer.free();
-                return false;
+                const char* ptr = line + 3;
+                vec3& n = buffer.nbuffer[chunk.nbNormal++];
+                if(!parseFloat(ptr, eol, n[0]) || !parseFloat(ptr, eol, n[1]) || !parseFloat(ptr, eol, n[2]))
+                    ok = false;
             }
-        }
-
-        else if(IterateLine::startWith(s, "vt "))
-        {
-            if(sscanf(s.c_str()+3, "%f %f", &(buffer.tbuffer[tindex][0]), &(buffer.tbuffer[tindex][1])) == 2)
-                ++tindex;
-            else
+            else if(startWith(line, eol, "vt ", 3))
             {
-                buffer.free();
-                return false;
+                const char* ptr = line + 3;
+                vec2& t = buffer.tbuffer[chunk.nbTexCoord++];
+                if(!parseFloat(ptr, eol, t[0]) || !parseFloat(ptr, eol, t[1]))
+                    ok = false;
             }
-        }
-        else if(IterateLine::startWith(s, "f "))
-        {
-            char v[3][64];
-            if(sscanf(s.c_str()+2, "%s %s %s", v[0],v[1],v[2]) != 3)
+            else if(startWith(line, eol, "f ", 2))
             {
-                buffer.free();
-                return false;
-            }
-
-            for(size_t i=0 ; i<3 ; ++i)
-            {
-//                bool b=true;
-//                buffer.ibuffer[iindex] = parseObjIndex(str, b, nbSlash);
-//                if(!b || buffer.ibuffer[iindex].x()>buffer.nbVertex || (buffer.ibuffer[iindex].x()==0 && buffer.nbVertex)
-//                      || buffer.ibuffer[iindex].z()>buffer.nbNormal || (buffer.ibuffer[iindex].z()==0 && buffer.nbNormal)
-//                      || buffer.ibuffer[iindex].y()>buffer.nbTexCoord || (buffer.ibuffer[iindex].y()==0 && buffer.nbTexCoord))
-//                {
-//                    buffer.free();
-//                    return false;
-//                }
-
-                buffer.ibuffer[iindex] = {0,0,0};
-                if(buffer.nbNormal == 0 && buffer.nbTexCoord == 0)
-                {
-                    sscanf(v[i], "%u", &buffer.ibuffer[iindex][0]);
-                }
-                else
+                // the first 3 of v, v/t, v/t/n or v//n
+                const char* ptr = line + 2;
+                for(size_t i=0 ; i<3 ; ++i)
                 {
-                    switch(sscanf(v[i], "%u/%u/%u", &(buffer.ibuffer[iindex][0]), &(buffer.ibuffer[iindex][1]), &(buffer.ibuffer[iindex][2])))
+                    while(ptr < eol && isBlank(*ptr)) ++ptr;
+                    const char* tokenEnd = ptr;
+                    while(tokenEnd < eol && !isBlank(*tokenEnd)) ++tokenEnd;
+                    if(ptr == tokenEnd)
                     {
-                    case 0:
-                    default:
-                        buffer.free();
-                        return false;
-
-                    case 1:
-                        buffer.ibuffer[iindex] = {0,0,0};
-                        sscanf(v[i], "%u//%u", &(buffer.ibuffer[iindex][0]), &(buffer.ibuffer[iindex][2]));
+                        ok = false;
+                        break;
+                    }
 
-                    case 2:
-                    case 3:
+                    uivec3& index = buffer.ibuffer[chunk.nbIndex++];
+                    index = {0,0,0};
+                    if(!parseIndex(ptr, tokenEnd, chunk.nbVertex, index[0]) && !onlyVertex)
+                    {
+                        ok = false;
                         break;
                     }
-                }
 
-                ++iindex;
+                    if(!onlyVertex && ptr < tokenEnd && *ptr == '/')
+                    {
+                        ++ptr;
+                        if(parseIndex(ptr, tokenEnd, chunk.nbTexCoord, index[1]))
+                        {
+                            if(ptr < tokenEnd && *ptr == '/')
+                            {
+                                ++ptr;
+                                parseIndex(ptr, tokenEnd, chunk.nbNormal, index[2]);
+                            }
+                        }
+                        else if(ptr < tokenEnd && *ptr == '/')
+                        {
+                            ++ptr;
+                            parseIndex(ptr, tokenEnd, chunk.nbNormal, index[2]);
+                        }
+                    }
+
+                    if(index[0] > buffer.nbVertex || index[1] > buffer.nbTexCoord || index[2] > buffer.nbNormal)
+                        ok = false;
+                    ptr = tokenEnd;
+                }
             }
-        }
-    }
+            return ok.load(std::memory_order_relaxed);
+        });
+    });
 
-//    for(int i=0 ; i<buffer.nbIndex ; ++i)
-//    {
-//        if(buffer.ibuffer[i].z() >  buffer.nbVertex)
-//        {
-//            std::cout << "Bug at " << i << ":" << buffer.ibuffer[i]  << " ; nbV:" << buffer.nbVertex <<std::endl;
-//        }
-//    }
+    if(!ok)
+    {
+        buffer.free();
+        return false;
+    }
 
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    LOG(file, " parsed at ", sizeFile / (seconds * 1e6), " MB/s");
     return true;
 }
 
-size_t MeshLoader::computeObjVertexMap(ObjBuffer& buf, renderer::MeshData& meshData,
-                                       VNC_Map& mapIndex)
+size_t MeshLoader::computeObjVertexMap(ObjBuffer& buf, renderer::MeshData& meshData, vector<uivec3>& vertices)
 {
-    size_t curIndex=0;
     meshData.nbIndex = buf.nbIndex;
     meshData.indexData = new uint[buf.nbIndex];
 
-    //renderer::VNC_Vertex vnc;
+    // the vertices are numbered in order of first use
+    vertices.clear();
+    ObjVertexTable table(vertices, std::max(buf.nbVertex, std::max(buf.nbNormal, buf.nbTexCoord)));
     for(size_t i=0 ; i<buf.nbIndex ; ++i)
-    {
-        //vnc.v = buf.vbuffer[buf.ibuffer[i].x()-1];
-        //vnc.n=vec3(); vnc.c=vec2();
-
-//        if(buf.nbNormal && buf.ibuffer[i].z() > 0)
-//            vnc.n = buf.nbuffer[buf.ibuffer[i].z()-1];
-//        if(buf.nbTexCoord && buf.ibuffer[i].y() > 0)
-//            vnc.c = buf.tbuffer[buf.ibuffer[i].y()-1];
-
-        auto it = mapIndex.find(buf.ibuffer[i]);
-        if(it == mapIndex.end())
-        {
-            mapIndex[buf.ibuffer[i]] = curIndex;
-            meshData.indexData[i] = curIndex;
-            ++curIndex;
-        }
-        else
-        {
-            meshData.indexData[i] = it->second;
-        }
-    }
+        meshData.indexData[i] = table.insert(buf.ibuffer[i]);
 
-    return curIndex;
-}
-
-uivec3 MeshLoader::parseObjIndex(const std::string& str, bool& ok, int nbSlash)
-{
-    if(std::count(str.begin(), str.end(), '/') != nbSlash)
-    {
-        ok=false;
-        return uivec3();
-    }
-
-    uivec3 res;
-
-    std::string buf;
-    size_t index=0;
-
-    for(size_t i=0 ; i<3 ; ++i)
-    {
-        while(index < str.size() && str[index] != '/')
-        {
-            buf+=str[index];
-            ++index;
-        }
-        if(!buf.empty())
-        {
-            if(!StringUtils(buf).isNumber())
-            {
-                ok=false;
-                return uivec3();
-            }
-            res[i] = StringUtils(buf).toInt();
-        }
-        buf.clear(); ++index;
-    }
-    return res;
+    return vertices.size();
 }
 
 void MeshLoader::computeTangent(renderer::MeshData& meshData)
@@ -421,49 +551,464 @@ void MeshLoader::computeTangent(renderer::MeshData& meshData)
 ///** TIM loader **/
 ///****************/
 
+namespace
+{
+    const char TIM_HEADER_V1[4] = {43,42,70,32};
+    const char TIM_HEADER[4] = {43,42,70,33}; // followed by the version
+
+    enum TimFlags : uint
+    {
+        TIM_OPTIMIZED = 1,
+        TIM_COMPRESSED = 2, // meshoptimizer vertex and index codecs, see encodeTimPayload
+        TIM_FILTERED = 4,   // compressed, with normals, tangents and uvs quantized first
+    };
+
+    /* v2: the fixed size header then each array, starting on a TIM_ALIGN boundary so a mapped file can be used in place */
+    const size_t TIM_ALIGN = 16;
+
+    struct TimHeader
+    {
+        uint version, flags;
+        renderer::VertexFormat format;
+        uint nbVertex, nbIndex, nbSecondaryIndex;
+        vec4 sphere;
+        vec3 boxMin, boxMax;
+        uint64_t contentHash;
+    };
+
+    const size_t TIM_HEADER_SIZE = 4 + sizeof(uint)*2 + sizeof(renderer::VertexFormat) + sizeof(uint)*3 + sizeof(vec4) + sizeof(vec3)*2 + sizeof(uint64_t);
+
+    size_t alignTim(size_t offset) { return (offset + TIM_ALIGN - 1) & ~(TIM_ALIGN - 1); }
+
+    template <class T>
+    void get(const char*& ptr, T& data)
+    {
+        memcpy(&data, ptr, sizeof(T));
+        ptr += sizeof(T);
+    }
+
+    /* Parse the first TIM_HEADER_SIZE bytes of a v2 file */
+    bool parseTimHeader(const char* ptr, TimHeader& h)
+    {
+        if(memcmp(ptr, TIM_HEADER, 4) != 0)
+            return false;
+        ptr += 4;
+
+        get(ptr, h.version);
+        get(ptr, h.flags);
+        get(ptr, h.format);
+        get(ptr, h.nbVertex);
+        get(ptr, h.nbIndex);
+        get(ptr, h.nbSecondaryIndex);
+        get(ptr, h.sphere);
+        get(ptr, h.boxMin);
+        get(ptr, h.boxMax);
+        get(ptr, h.contentHash);
+        return h.version == MeshLoader::TIM_VERSION;
+    }
+
+    /* Offsets of the arrays and size of the whole file */
+    void timLayout(const TimHeader& h, size_t& vOffset, size_t& iOffset, size_t& i2Offset, size_t& fileSize)
+    {
+        vOffset = alignTim(TIM_HEADER_SIZE);
+        iOffset = alignTim(vOffset + sizeof(renderer::MeshData::DataType)*h.nbVertex);
+        i2Offset = alignTim(iOffset + sizeof(uint)*h.nbIndex);
+        fileSize = i2Offset + sizeof(uint)*h.nbSecondaryIndex;
+    }
+
+    void setHeaderData(const TimHeader& h, renderer::MeshData& data)
+    {
+        data.format = h.format;
+        data.nbVertex = h.nbVertex;
+        data.nbIndex = h.nbIndex;
+        data.nbSecondaryIndex = h.nbSecondaryIndex;
+        data.contentHash = h.contentHash;
+        data.hasBounds = true;
+        data.sphere = Sphere(h.sphere);
+        data.box = Box(h.boxMin, h.boxMax);
+    }
+
+    /* Filtered vertices are split in streams: the position as is, the normal and the tangent in octahedral
+     * snorm16 (OCT_BITS significant) and the uv with an exponent per component (UV_BITS of mantissa).
+     * The codec compresses each stream better than the interleaved floats. */
+    const int OCT_BITS = 12;
+    const int UV_BITS = 16;
+
+    struct VertexStream
+    {
+        uint vertexSize;
+        vector<unsigned char> data;
+    };
+
+    vector<VertexStream> splitStreams(const renderer::MeshData& data, bool filtered)
+    {
+        const size_t n = data.nbVertex;
+        if(!filtered)
+        {
+            VertexStream s = { sizeof(renderer::MeshData::DataType), vector<unsigned char>(sizeof(renderer::MeshData::DataType)*n) };
+            memcpy(s.data.data(), data.vData, s.data.size());
+            return { std::move(s) };
+        }
+
+        vector<VertexStream> streams = { {sizeof(vec3), {}}, {8, {}}, {8, {}}, {8, {}} };
+        for(VertexStream& s : streams)
+            s.data.resize(s.vertexSize * n);
+
+        vector<float> tmp(4*n);
+        for(size_t i=0 ; i<n ; ++i)
+            memcpy(streams[0].data.data() + i*sizeof(vec3), &data.vData[i].v, sizeof(vec3));
+
+        for(size_t i=0 ; i<n ; ++i)
+            for(int j=0 ; j<4 ; ++j) tmp[i*4+j] = j<3 ? data.vData[i].n[j] : 0;
+        meshopt_encodeFilterOct(streams[1].data.data(), n, 8, OCT_BITS, tmp.data());
+
+        for(size_t i=0 ; i<n ; ++i)
+            for(int j=0 ; j<2 ; ++j) tmp[i*2+j] = data.vData[i].c[j];
+        meshopt_encodeFilterExp(streams[2].data.data(), n, 8, UV_BITS, tmp.data(), meshopt_EncodeExpSeparate);
+
+        for(size_t i=0 ; i<n ; ++i)
+            for(int j=0 ; j<4 ; ++j) tmp[i*4+j] = j<3 ? data.vData[i].t[j] : 0;
+        meshopt_encodeFilterOct(streams[3].data.data(), n, 8, OCT_BITS, tmp.data());
+
+        return streams;
+    }
+
+    /* Inverse of splitStreams, the filters are decoded in place */
+    void mergeStreams(vector<VertexStream>& streams, renderer::MeshData& data)
+    {
+        const size_t n = data.nbVertex;
+        if(streams.size() == 1)
+        {
+            memcpy(data.vData, streams[0].data.data(), streams[0].data.size());
+            return;
+        }
+
+        meshopt_decodeFilterOct(streams[1].data.data(), n, 8);
+        meshopt_decodeFilterExp(streams[2].data.data(), n, 8);
+        meshopt_decodeFilterOct(streams[3].data.data(), n, 8);
+
+        const int16_t* normal = reinterpret_cast<const int16_t*>(streams[1].data.data());
+        const int16_t* tangent = reinterpret_cast<const int16_t*>(streams[3].data.data());
+        for(size_t i=0 ; i<n ; ++i)
+        {
+            renderer::MeshData::DataType& v = data.vData[i];
+            memcpy(&v.v, streams[0].data.data() + i*sizeof(vec3), sizeof(vec3));
+            memcpy(&v.c, streams[2].data.data() + i*8, sizeof(vec2));
+            for(int j=0 ; j<3 ; ++j)
+            {
+                v.n[j] = normal[i*4+j] / 32767.f;
+                v.t[j] = tangent[i*4+j] / 32767.f;
+            }
+        }
+    }
+
+    /* Compressed payload: a block per vertex stream, then the indices and the secondary indices if any.
+     * A block is its size (uint) followed by the encoded bytes. */
+    void writeBlock(std::ostream& os, const vector<unsigned char>& block)
+    {
+        const uint size = block.size();
+        os.write(reinterpret_cast<const char*>(&size), sizeof(uint));
+        os.write(reinterpret_cast<const char*>(block.data()), size);
+    }
+
+    vector<unsigned char> encodeIndices(const uint* indices, uint nbIndex, uint nbVertex)
+    {
+        vector<unsigned char> block(meshopt_encodeIndexBufferBound(nbIndex, nbVertex));
+        block.resize(meshopt_encodeIndexBuffer(block.data(), block.size(), indices, nbIndex));
+        return block;
+    }
+
+    bool readBlock(const char*& ptr, const char* end, const unsigned char*& block, uint& size)
+    {
+        if(end - ptr < ptrdiff_t(sizeof(uint)))
+            return false;
+        memcpy(&size, ptr, sizeof(uint));
+        ptr += sizeof(uint);
+        if(uint(end - ptr) < size)
+            return false;
+        block = reinterpret_cast<const unsigned char*>(ptr);
+        ptr += size;
+        return true;
+    }
+
+    /* Decode a compressed payload in data (its counts set by the header), false if it is corrupted */
+    bool decodeTimPayload(const char* ptr, const char* end, uint flags, renderer::MeshData& data)
+    {
+        vector<VertexStream> streams;
+        if(flags & TIM_FILTERED) streams = { {sizeof(vec3), {}}, {8, {}}, {8, {}}, {8, {}} };
+        else                     streams = { {sizeof(renderer::MeshData::DataType), {}} };
+
+        const unsigned char* block;
+        uint size;
+        for(VertexStream& s : streams)
+        {
+            s.data.resize(s.vertexSize * data.nbVertex);
+            if(!readBlock(ptr, end, block, size) ||
+               meshopt_decodeVertexBuffer(s.data.data(), data.nbVertex, s.vertexSize, block, size) != 0)
+                return false;
+        }
+
+        data.vData = new renderer::MeshData::DataType[data.nbVertex];
+        data.indexData = new uint[data.nbIndex];
+        if(data.nbSecondaryIndex > 0)
+            data.secondaryIndexData = new uint[data.nbSecondaryIndex];
+
+        mergeStreams(streams, data);
+
+        if(!readBlock(ptr, end, block, size) || meshopt_decodeIndexBuffer(data.indexData, data.nbIndex, sizeof(uint), block, size) != 0)
+            return false;
+        if(data.secondaryIndexData &&
+           (!readBlock(ptr, end, block, size) || meshopt_decodeIndexBuffer(data.secondaryIndexData, data.nbSecondaryIndex, sizeof(uint), block, size) != 0))
+            return false;
+
+        return true;
+    }
+}
+
 renderer::MeshData MeshLoader::importTim(const std::string& file)
 {
     renderer::MeshData data;
 
-    std::ifstream fs(file, std::ios_base::binary);
-    if(!fs)
+    FileData f = FileSystem::read(file);
+    if(!f.isOpen())
         return data;
+    MemoryStream fs(f);
 
-    char header[4] = {0,0,0,0};
+    char header[TIM_HEADER_SIZE] = {0};
     fs.read(header,4);
-    if(!(header[0] == 43 && header[1] == 42 && header[2] == 70 && header[3] == 32))
+
+    if(memcmp(header, TIM_HEADER_V1, 4) == 0)
+    {
+        read(fs, data.format);
+        read(fs, data.nbVertex);
+        read(fs, data.nbIndex);
+
+        data.vData = new renderer::MeshData::DataType[data.nbVertex];
+        data.indexData = new uint[data.nbIndex];
+
+        fs.read(reinterpret_cast<char*>(data.vData), sizeof(renderer::MeshData::DataType)*data.nbVertex);
+        fs.read(reinterpret_cast<char*>(data.indexData), sizeof(uint)*data.nbIndex);
+
+        // TODO each mesh may use a different threshold, can be saved in .itim directly
+        optimizeMesh(data, 0.33f);
         return data;
+    }
+
+    fs.read(header+4, TIM_HEADER_SIZE-4);
+    TimHeader h;
+    if(!fs || !parseTimHeader(header, h))
+    {
+        LOG_EXT("Invalid or unsupported .tim file ", file);
+        return data;
+    }
+
+    size_t vOffset, iOffset, i2Offset, fileSize;
+    timLayout(h, vOffset, iOffset, i2Offset, fileSize);
+
+    setHeaderData(h, data);
 
-    read(fs, data.format);
-    read(fs, data.nbVertex);
-    read(fs, data.nbIndex);
+    if(h.flags & TIM_COMPRESSED)
+    {
+        fs.seekg(0, std::ios_base::end);
+        const size_t size = size_t(fs.tellg());
+        vector<char> payload(size > vOffset ? size - vOffset : 0);
+        fs.seekg(vOffset);
+        fs.read(payload.data(), payload.size());
+
+        if(!fs || !decodeTimPayload(payload.data(), payload.data() + payload.size(), h.flags, data))
+        {
+            LOG_EXT("Corrupted .tim file ", file);
+            data.clear();
+        }
+        return data;
+    }
 
     data.vData = new renderer::MeshData::DataType[data.nbVertex];
     data.indexData = new uint[data.nbIndex];
+    if(data.nbSecondaryIndex > 0)
+        data.secondaryIndexData = new uint[data.nbSecondaryIndex];
 
+    fs.seekg(vOffset);
     fs.read(reinterpret_cast<char*>(data.vData), sizeof(renderer::MeshData::DataType)*data.nbVertex);
+    fs.seekg(iOffset);
     fs.read(reinterpret_cast<char*>(data.indexData), sizeof(uint)*data.nbIndex);
+    if(data.secondaryIndexData)
+    {
+        fs.seekg(i2Offset);
+        fs.read(reinterpret_cast<char*>(data.secondaryIndexData), sizeof(uint)*data.nbSecondaryIndex);
+    }
+
+    if(!fs)
+    {
+        LOG_EXT("Truncated .tim file ", file);
+        data.clear();
+        return data;
+    }
+
+    if(!(h.flags & TIM_OPTIMIZED))
+    {
+        data.hasBounds = false;
+        optimizeMesh(data, 1.f);
+    }
+    return data;
+}
+
+renderer::MeshData MeshLoader::mapTim(const std::string& file)
+{
+    // mapping of the loose file or of the archive (stored without compression by AssetPacker)
+    FileData f = FileSystem::read(file);
+
+    TimHeader h;
+    if(!f.isOpen() || f.size < TIM_HEADER_SIZE || !parseTimHeader(f.data, h) || !(h.flags & TIM_OPTIMIZED))
+        return importTim(file);
+
+    size_t vOffset, iOffset, i2Offset, fileSize;
+    timLayout(h, vOffset, iOffset, i2Offset, fileSize);
+
+    renderer::MeshData data;
+
+    // decoded from the mapping, which is released on return
+    if(h.flags & TIM_COMPRESSED)
+    {
+        setHeaderData(h, data);
+        if(f.size < vOffset || !decodeTimPayload(f.data + vOffset, f.data + f.size, h.flags, data))
+        {
+            LOG_EXT("Corrupted .tim file ", file);
+            data.clear();
+        }
+        return data;
+    }
 
-    // TODO each mesh may use a different threshold, can be saved in .itim directly
-    optimizeMesh(data, 0.33f);
+    if(f.size < fileSize)
+    {
+        LOG_EXT("Truncated .tim file ", file);
+        return data;
+    }
+
+    // the pages are read only, nothing may write in the arrays
+    char* base = const_cast<char*>(f.data);
+    setHeaderData(h, data);
+    data.vData = reinterpret_cast<renderer::MeshData::DataType*>(base + vOffset);
+    data.indexData = reinterpret_cast<uint*>(base + iOffset);
+    if(data.nbSecondaryIndex > 0)
+        data.secondaryIndexData = reinterpret_cast<uint*>(base + i2Offset);
+    data.storage = f.storage;
     return data;
 }
 
-void MeshLoader::exportTim(const renderer::MeshData& data, const std::string& file)
+void MeshLoader::exportTim(const renderer::MeshData& input, const std::string& file, float secondaryIbSimplificationThreshold, TimCompression compression,
+                           Sphere::Fit fit)
 {
     std::ofstream fs(file, std::ios_base::binary);
-    if(!fs || !data.nbVertex || !data.nbIndex)
+    if(!fs || !input.nbVertex || !input.nbIndex)
         return;
 
-    char header[4] = {43,42,70,32};
-    fs.write(header,4);
+    // the work done at each load for v1 files
+    renderer::MeshData data;
+    data.name = input.name;
+    data.format = input.format;
+    data.nbVertex = input.nbVertex;
+    data.nbIndex = input.nbIndex;
+    data.vData = new renderer::MeshData::DataType[data.nbVertex];
+    data.indexData = new uint[data.nbIndex];
+    std::copy(input.vData, input.vData + input.nbVertex, data.vData);
+    std::copy(input.indexData, input.indexData + input.nbIndex, data.indexData);
+
+    optimizeMesh(data, secondaryIbSimplificationThreshold);
 
-    write(fs, data.format);
-    write(fs, data.nbVertex);
-    write(fs, data.nbIndex);
+    uint flags = TIM_OPTIMIZED;
+    vector<vector<unsigned char>> blocks;
+    if(compression != TimCompression::NONE)
+    {
+        const bool filtered = compression == TimCompression::FILTERED;
+        flags |= TIM_COMPRESSED | (filtered ? uint(TIM_FILTERED) : 0u);
 
-    fs.write(reinterpret_cast<char*>(data.vData), sizeof(renderer::MeshData::DataType)*data.nbVertex);
-    fs.write(reinterpret_cast<char*>(data.indexData), sizeof(uint)*data.nbIndex);
+        vector<VertexStream> streams = splitStreams(data, filtered);
+        for(const VertexStream& s : streams)
+        {
+            vector<unsigned char> block(meshopt_encodeVertexBufferBound(data.nbVertex, s.vertexSize));
+            block.resize(meshopt_encodeVertexBuffer(block.data(), block.size(), s.data.data(), data.nbVertex, s.vertexSize));
+            blocks.push_back(std::move(block));
+        }
+        blocks.push_back(encodeIndices(data.indexData, data.nbIndex, data.nbVertex));
+        if(data.secondaryIndexData)
+            blocks.push_back(encodeIndices(data.secondaryIndexData, data.nbSecondaryIndex, data.nbVertex));
+
+        // the hash is the one of the data as it will be loaded: quantized, and the index codec may rotate the triangles
+        if(filtered)
+            mergeStreams(streams, data);
+        meshopt_decodeIndexBuffer(data.indexData, data.nbIndex, sizeof(uint), blocks[streams.size()].data(), blocks[streams.size()].size());
+        if(data.secondaryIndexData)
+            meshopt_decodeIndexBuffer(data.secondaryIndexData, data.nbSecondaryIndex, sizeof(uint), blocks.back().data(), blocks.back().size());
+    }
+
+    const uint stride = sizeof(renderer::MeshData::DataType)/sizeof(float);
+    const Sphere sphere = Sphere::computeSphere(reinterpret_cast<real*>(data.vData), data.nbVertex, stride, fit, &renderer::globalThreadPool);
+    const Box box = Box::computeBox(reinterpret_cast<real*>(data.vData), data.nbVertex, stride, &renderer::globalThreadPool);
+
+    TimHeader h = { TIM_VERSION, flags, data.format, data.nbVertex, data.nbIndex, data.nbSecondaryIndex,
+                    sphere.sphere(), box.min(), box.max(), contentHash(data) };
+
+    fs.write(TIM_HEADER,4);
+    write(fs, h.version);
+    write(fs, h.flags);
+    write(fs, h.format);
+    write(fs, h.nbVertex);
+    write(fs, h.nbIndex);
+    write(fs, h.nbSecondaryIndex);
+    write(fs, h.sphere);
+    write(fs, h.boxMin);
+    write(fs, h.boxMax);
+    write(fs, h.contentHash);
+
+    size_t vOffset, iOffset, i2Offset, fileSize;
+    timLayout(h, vOffset, iOffset, i2Offset, fileSize);
+
+    auto writeAt = [&fs](size_t offset, const void* ptr, size_t size)
+    {
+        const char zeros[TIM_ALIGN] = {0};
+        fs.write(zeros, offset - size_t(fs.tellp()));
+        fs.write(reinterpret_cast<const char*>(ptr), size);
+    };
+
+    if(!blocks.empty())
+    {
+        writeAt(vOffset, nullptr, 0);
+
+        size_t rawSize = sizeof(renderer::MeshData::DataType)*data.nbVertex + sizeof(uint)*(data.nbIndex + data.nbSecondaryIndex), size = 0;
+        for(const vector<unsigned char>& block : blocks)
+        {
+            writeBlock(fs, block);
+            size += sizeof(uint) + block.size();
+        }
+        LOG(file, " compressed to ", size, " bytes from ", rawSize, " (", float(size) / rawSize, ")");
+    }
+    else
+    {
+        writeAt(vOffset, data.vData, sizeof(renderer::MeshData::DataType)*data.nbVertex);
+        writeAt(iOffset, data.indexData, sizeof(uint)*data.nbIndex);
+        if(data.secondaryIndexData)
+            writeAt(i2Offset, data.secondaryIndexData, sizeof(uint)*data.nbSecondaryIndex);
+    }
+
+    data.clear();
+}
+
+Sphere MeshLoader::volume(const renderer::MeshData& data, Sphere::Fit fit)
+{
+    if(data.hasBounds && fit == Sphere::Fit::BOX_CENTER)
+        return data.sphere;
+
+    return Sphere::computeSphere(reinterpret_cast<const real*>(data.vData), data.nbVertex,
+                                 sizeof(renderer::MeshData::DataType)/sizeof(float), fit, &renderer::globalThreadPool);
+}
+
+uint64_t MeshLoader::contentHash(const renderer::MeshData& data)
+{
+    uint64_t h = hash64(&data.format, sizeof(data.format));
+    h = hash64(data.vData, sizeof(renderer::MeshData::DataType)*data.nbVertex, h);
+    h = hash64(data.indexData, sizeof(uint)*data.nbIndex, h);
+    return hash64(data.secondaryIndexData, sizeof(uint)*data.nbSecondaryIndex, h);
 }
 
 void MeshLoader::write(std::ostream& os, const std::string& str)
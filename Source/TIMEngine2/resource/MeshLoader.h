@@ -15,12 +15,73 @@ namespace resource
     class MeshLoader
     {
     public:
+        /* Per asset options of the geometry loading, set in the MeshAsset xml */
+        enum LoadFlags : uint
+        {
+            RITTER_SPHERE = 1, // tighter bounding sphere, slower to compute
+            PACKED_VERTEX = 2, // upload in VNCT_PACKED when it fits, the uvs are half floats
+        };
+
         static renderer::MeshData importObj(const std::string&, bool tangent=true);
 
         static renderer::MeshBuffers* createMeshBuffers(renderer::MeshData&, renderer::VertexBufferPoolType*, renderer::IndexBufferPoolType*);
 
+        /* What is uploaded for a mesh. A mesh of less than 65536 vertices gets 16 bits indices. When asked (PACKED_VERTEX),
+         * a mesh whose normals, tangents and uvs fit (|uv| <= PACKED_MAX_UV) goes in VNCT_PACKED, it stays in float otherwise.
+         * Otherwise the arrays point to the MeshData, which must outlive the GpuData. */
+        struct GpuData
+        {
+            renderer::VertexFormat format = renderer::VNCT;
+            bool shortIndex = false;
+
+            const float* vData = nullptr;
+            const uint *indexData = nullptr, *secondaryIndexData = nullptr;
+            uint nbVertex = 0, nbIndex = 0, nbSecondaryIndex = 0;
+
+            // storage of the converted arrays
+            vector<renderer::VNCT_Packed_Vertex> packedVertex;
+            vector<uint> packedIndex, packedSecondaryIndex;
+
+            /* Uploaded */
+            size_t bytes() const;
+        };
+
+        static constexpr float PACKED_MAX_UV = 4;
+
+        static GpuData prepareGpuData(const renderer::MeshData&, bool packVertex = false);
+        /* Allocate in the pools matching the format, any thread */
+        static renderer::MeshBuffers* allocMeshBuffers(const GpuData&, const Sphere&, renderer::MeshData* cpuData = nullptr);
+        /* Upload in buffers made by allocMeshBuffers, gl thread */
+        static void flushMeshBuffers(const GpuData&, const renderer::MeshBuffers&);
+
+        struct GpuFormatStats
+        {
+            size_t meshes = 0, packedMeshes = 0, shortIndexMeshes = 0;
+            size_t bytes = 0;      // uploaded
+            size_t bytesSaved = 0; // compared to VNCT and 32 bits indices
+        };
+        /* Over all the prepareGpuData */
+        static GpuFormatStats gpuFormatStats();
+
+        /* .tim v1 (raw data, optimized at each load) and v2 (optimized, with lod, bounds and content hash, loaded as is) */
         static renderer::MeshData importTim(const std::string&);
-        static void exportTim(const renderer::MeshData&, const std::string&);
+        /* v2 files are mapped and the data points into the mapping (read only), released by MeshData::clear.
+         * Fall back on importTim for the other files. */
+        static renderer::MeshData mapTim(const std::string&);
+        /* Payload of a v2 file: raw (mappable), compressed with the meshoptimizer codecs (lossless), or compressed with the
+         * normals, tangents and uvs quantized first (smaller, about 1e-3 of error on the unit vectors).
+         * Compressed files are decoded on the loading thread. */
+        enum class TimCompression { NONE, LOSSLESS, FILTERED };
+
+        /* Write a v2 file, the optimisation and the lod are done here once for all */
+        static void exportTim(const renderer::MeshData&, const std::string&, float secondaryIbSimplificationThreshold = 0.33f,
+                              TimCompression compression = TimCompression::NONE, Sphere::Fit fit = Sphere::Fit::BOX_CENTER);
+
+        static constexpr uint TIM_VERSION = 2;
+
+        /* The bounding sphere of the data, the pre-computed one if any unless a Ritter sphere is asked */
+        static Sphere volume(const renderer::MeshData&, Sphere::Fit fit = Sphere::Fit::BOX_CENTER);
+        static uint64_t contentHash(const renderer::MeshData&);
 
         static void optimizeMesh(renderer::MeshData&, float secondaryIbSimplificationThreshold = 1.0f);
 
@@ -54,23 +115,8 @@ namespace resource
             }
         };
 
-        struct hash_uivec3
-        {
-        public:
-            std::size_t operator()(const uivec3& v) const
-            {
-                std::hash<uint> hasher;
-
-                return hasher(v[0]) + hasher(v[1]) + hasher(v[2]);
-            }
-        };
-
-        using VNC_Map = std::unordered_map<uivec3, size_t, hash_uivec3>;
-        //using VNC_Map = std::map<uivec3, size_t>;
-
         static bool loadObjData(const std::string&, ObjBuffer&);
-        static size_t computeObjVertexMap(ObjBuffer&, renderer::MeshData&, VNC_Map&);
-        static uivec3 parseObjIndex(const std::string&, bool&, int);
+        static size_t computeObjVertexMap(ObjBuffer&, renderer::MeshData&, vector<uivec3>&);
 
         template<class T> static void write(std::ostream&, const T&);
         template<class T> static void read(std::istream&, T&);
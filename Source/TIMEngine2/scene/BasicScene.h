@@ -2,10 +2,14 @@
 #define SCENECONT_H_INCLUDED
 
 #include <typeindex>
+#include <unordered_map>
 #include <algorithm>
 #include <iterator>
 
 #include "core.h"
+#include "SlabPool.h"
+#include "ThreadPool.h"
+#include "ChangeJournal.h"
 
 #include "MemoryLoggerOn.h"
 namespace tim
@@ -13,6 +17,7 @@ namespace tim
     using namespace core;
 namespace scene
 {
+    /* Objects are stored in one slab pool per type, add and remove never go to the heap once the pool is warm */
     template <class Contained>
     class BasicScene
     {
@@ -21,19 +26,36 @@ namespace scene
 
         ~BasicScene()
         {
-            std::for_each(std::begin(_container), std::end(_container), [](Contained* c) { delete c; });
+            for(auto& typed : _typeContainer)
+            {
+                for(Contained* c : typed.second.objects)
+                {
+                    c->~Contained();
+                    typed.second.pool.free(c);
+                }
+            }
         }
 
         template<class SuperType, class... Args>
         SuperType& add(Args... args)
         {
-            SuperType* obj = new SuperType(args...);
-            _container.push_back(obj);
+            static_assert(std::is_base_of<Contained, SuperType>::value, "SuperType must inherit from Contained");
+
+            TypedStorage& typed = _typeContainer.try_emplace(std::type_index(typeid(SuperType)),
+                                                             sizeof(SuperType), alignof(SuperType)).first->second;
+
+            void* ptr = typed.pool.alloc();
+            SuperType* obj;
+#include "MemoryLoggerOff.h"
+            try { obj = ::new(ptr) SuperType(args...); }
+            catch(...) { typed.pool.free(ptr); throw; }
+#include "MemoryLoggerOn.h"
 
-            vector<Contained*>& cvec = _typeContainer[std::type_index(typeid(SuperType))];
-            cvec.push_back(obj);
+            _container.push_back(obj);
+            typed.objects.push_back(obj);
 
-            _container.back()->_containerInfo = { this, (uint)_container.size() - 1, (uint)cvec.size() - 1};
+            _container.back()->_containerInfo = { this, (uint)_container.size() - 1, (uint)typed.objects.size() - 1, &typed, typename Journal::Stamp() };
+            _journal.record(obj, obj->_containerInfo.stamp, Journal::ADDED);
 
             return *obj;
         }
@@ -44,6 +66,7 @@ namespace scene
                 return;
 
             TransformableInfo& info = obj._containerInfo;
+            _journal.record(&obj, info.stamp, Journal::REMOVED);
 
             if(info.indexInContainer+1 != _container.size())
             {
@@ -52,7 +75,7 @@ namespace scene
             }
             _container.pop_back();
 
-            vector<Contained*>& typedVec = _typeContainer[std::type_index(typeid(obj))];
+            vector<Contained*>& typedVec = info.typed->objects;
             if(info.indexInTypedVector+1 != typedVec.size())
             {
                 typedVec[info.indexInTypedVector] = typedVec.back();
@@ -60,7 +83,9 @@ namespace scene
             }
             typedVec.pop_back();
 
-            delete &obj;
+            SlabPool& pool = info.typed->pool;
+            obj.~Contained();
+            pool.free(&obj);
         }
 
         template<class Type, class Predicat, class Collector>
@@ -71,10 +96,11 @@ namespace scene
 
             if(it == std::end(_typeContainer)) return;
 
-            for(size_t i=0 ; i<it->second.size() ; ++i)
+            const vector<Contained*>& objects = it->second.objects;
+            for(size_t i=0 ; i<objects.size() ; ++i)
             {
-                if(f(static_cast<const Type&>(*(it->second[i]))))
-                    collector(static_cast<Type&>(*(it->second[i])));
+                if(f(static_cast<const Type&>(*(objects[i]))))
+                    collector(static_cast<Type&>(*(objects[i])));
             }
         }
 
@@ -85,16 +111,124 @@ namespace scene
             std::copy_if(std::begin(_container), std::end(_container), collector, f);
         }
 
+        /* Same as query, the objects are split in chunks of grain tested on the pool.
+         * The predicate is called concurrently and must be thread safe, the collector is called from the calling thread
+         * once all chunks are done, in the same order as query. Small sets are queried serially. */
+        template<class Type, class Predicat, class Collector>
+        typename std::enable_if<!std::is_same<Type, Contained>::value>::type
+            query(Predicat f, Collector collector, ThreadPool& pool, size_t grain = DEFAULT_QUERY_GRAIN)
+        {
+            auto it = _typeContainer.find(std::type_index(typeid(Type)));
+
+            if(it == std::end(_typeContainer)) return;
+
+            parallelQuery(it->second.objects, pool, grain,
+                          [&](const Contained* c) { return f(static_cast<const Type&>(*c)); },
+                          [&](Contained* c) { collector(static_cast<Type&>(*c)); });
+        }
+
+        template<class Type, class Predicat, class Collector>
+        typename std::enable_if<std::is_same<Type, Contained>::value>::type
+            query(Predicat f, Collector collector, ThreadPool& pool, size_t grain = DEFAULT_QUERY_GRAIN)
+        {
+            parallelQuery(_container, pool, grain,
+                          [&](const Contained* c) { return f(c); },
+                          [&](Contained* c) { *collector++ = c; });
+        }
+
+        static constexpr size_t DEFAULT_QUERY_GRAIN = 1024;
+
+        /* The objects of exactly Type (all the objects for Contained), the order changes on remove */
+        template<class Type>
+        const vector<Contained*>& objects() const
+        {
+            if(std::is_same<Type, Contained>::value)
+                return _container;
+
+            static const vector<Contained*> empty;
+            auto it = _typeContainer.find(std::type_index(typeid(Type)));
+            return it == std::end(_typeContainer) ? empty : it->second.objects;
+        }
+
+        struct TypedStorage
+        {
+            TypedStorage(size_t size, size_t align) : pool(size, align) {}
+
+            vector<Contained*> objects;
+            SlabPool pool;
+        };
+
+        using Journal = ChangeJournal<Contained>;
+
+        /* Objects added, removed and changed, call journal().nextFrame() once per frame. Recorded while a consumer is registered. */
+        Journal& journal() { return _journal; }
+        const Journal& journal() const { return _journal; }
+
+        /* Changes of the object in the current frame of the journal */
+        uint changes(const Contained& obj) const { return _journal.changes(obj._containerInfo.stamp); }
+
         struct TransformableInfo
         {
-            BasicScene* container;
-            uint indexInContainer;
-            uint indexInTypedVector;
+            BasicScene* container = nullptr;
+            uint indexInContainer = 0;
+            uint indexInTypedVector = 0;
+            TypedStorage* typed = nullptr;
+            typename Journal::Stamp stamp;
         };
 
     protected:
         vector<Contained*> _container;
-        std::unordered_map<std::type_index, vector<Contained*>> _typeContainer;
+        std::unordered_map<std::type_index, TypedStorage> _typeContainer; // nodes are stable, TransformableInfo points into it
+        Journal _journal;
+
+    private:
+        template<class Test, class Output>
+        static void parallelQuery(const vector<Contained*>& objects, ThreadPool& pool, size_t grain, const Test& test, const Output& output)
+        {
+            grain = std::max<size_t>(grain, 1);
+            if(objects.size() < 2*grain)
+            {
+                for(size_t i=0 ; i<objects.size() ; ++i)
+                {
+                    if(test(objects[i]))
+                        output(objects[i]);
+                }
+                return;
+            }
+
+            // chunk c collects its matches in [c*grain, c*grain+counts[c]), chunks are merged in order.
+            // The buffers are per calling thread and moved out while in use, a collector can query again.
+            thread_local vector<Contained*> t_matches;
+            thread_local vector<uint> t_counts;
+
+            const size_t nbChunks = (objects.size() + grain - 1) / grain;
+            vector<Contained*> matches = std::move(t_matches);
+            vector<uint> counts = std::move(t_counts);
+            matches.resize(objects.size());
+            counts.resize(nbChunks);
+
+            pool.parallelFor(0, nbChunks, 1, [&](size_t c)
+            {
+                const size_t first = c*grain;
+                const size_t last = std::min(first + grain, objects.size());
+                uint n = 0;
+                for(size_t i=first ; i<last ; ++i)
+                {
+                    if(test(objects[i]))
+                        matches[first + n++] = objects[i];
+                }
+                counts[c] = n;
+            });
+
+            for(size_t c=0 ; c<nbChunks ; ++c)
+            {
+                for(size_t i=0 ; i<counts[c] ; ++i)
+                    output(matches[c*grain + i]);
+            }
+
+            t_matches = std::move(matches);
+            t_counts = std::move(counts);
+        }
     };
 
 }
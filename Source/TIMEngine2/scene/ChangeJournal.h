@@ -0,0 +1,168 @@
+#ifndef CHANGEJOURNAL_H_INCLUDED
+#define CHANGEJOURNAL_H_INCLUDED
+
+#include <deque>
+#include <cstdint>
+#include "core.h"
+
+#include "MemoryLoggerOn.h"
+namespace tim
+{
+    using namespace core;
+namespace scene
+{
+    /* Changes of the objects of a scene, by frame.
+     * An object has at most one record per frame (its changes are merged) unless a consumer read the journal
+     * in between, so the cost is O(1) per change and the size is bounded by the number of objects changed per frame.
+     * Consumers keep their own Cursor and read what happened since, records older than the history are dropped
+     * by nextFrame(): a consumer too late has to consider everything changed.
+     * Records are only kept while a consumer is registered, the changes of the frame (stamps) are always tracked.
+     * Not thread safe. */
+    template <class Contained>
+    class ChangeJournal
+    {
+    public:
+        enum Change : uint
+        {
+            ADDED    = 1,
+            REMOVED  = 2, // the object is destroyed, the pointer is only an identifier
+            MOVED    = 4, // transform or volume
+            ENABLED  = 8, // setEnable
+            PROPERTY = 16 // anything else (mesh, light color ..)
+        };
+
+        static constexpr uint64_t NO_RECORD = UINT64_MAX;
+
+        struct Record
+        {
+            const Contained* object;
+            uint64_t frame;
+            uint changes;
+        };
+
+        /* Stored in each object */
+        struct Stamp
+        {
+            uint64_t record = NO_RECORD; // absolute index of its last record
+            uint64_t frame = 0;
+            uint changes = 0;            // changes of the frame
+        };
+
+        /* Absolute index of the next record to read */
+        using Cursor = uint64_t;
+
+        ChangeJournal() { _frameBegin.push_back(0); }
+
+        uint64_t frame() const { return _frame; }
+
+        void nextFrame()
+        {
+            ++_frame;
+            _frameBegin.push_back(end());
+
+            while(_frameBegin.size() > _history)
+            {
+                _records.erase(_records.begin(), _records.begin() + (_frameBegin[1] - _base));
+                _base = _frameBegin[1];
+                _frameBegin.pop_front();
+            }
+        }
+
+        /* Number of frames kept, the current one included */
+        void setHistory(uint nbFrames) { _history = std::max(nbFrames, 1u); }
+
+        /* Start recording, the cursor is at the current end */
+        Cursor addConsumer()
+        {
+            ++_consumers;
+            return end();
+        }
+
+        /* The records are dropped with the last consumer */
+        void removeConsumer()
+        {
+            if(_consumers == 0 || --_consumers > 0)
+                return;
+
+            _base = end();
+            _records.clear();
+            _frameBegin.assign(1, _base);
+        }
+
+        uint consumers() const { return _consumers; }
+
+        /* Cursor at the current end, the next read gets what comes after */
+        Cursor cursor() const { return end(); }
+
+        /* Cursor at the beginning of a frame, if the frame is gone from the history the read will fail */
+        Cursor cursorAt(uint64_t frame) const
+        {
+            const uint64_t first = _frame + 1 - _frameBegin.size();
+            if(frame < first) return 0;
+            if(frame > _frame) return end();
+            return _frameBegin[frame - first];
+        }
+
+        /* Call f(const Record&) for each record since the cursor and move it to the end.
+         * Return false without calling f if the cursor is older than the history. */
+        template <class F>
+        bool read(Cursor& cursor, F f)
+        {
+            _readMark = end();
+            if(cursor < _base)
+            {
+                cursor = end();
+                return false;
+            }
+
+            for(uint64_t i=cursor ; i<end() ; ++i)
+                f(static_cast<const Record&>(_records[i - _base]));
+
+            cursor = end();
+            return true;
+        }
+
+        void record(const Contained* obj, Stamp& stamp, uint changes)
+        {
+            if(stamp.frame != _frame)
+            {
+                stamp.frame = _frame;
+                stamp.changes = 0;
+            }
+            stamp.changes |= changes;
+
+            if(_consumers == 0)
+                return;
+
+            // merged in its record of the frame if nobody read it yet
+            if(stamp.record != NO_RECORD && stamp.record >= std::max(_readMark, _base) && _records[stamp.record - _base].frame == _frame)
+            {
+                _records[stamp.record - _base].changes |= changes;
+                return;
+            }
+
+            stamp.record = end();
+            _records.push_back({ obj, _frame, changes });
+        }
+
+        /* Changes of the object in the current frame */
+        uint changes(const Stamp& stamp) const { return stamp.frame == _frame ? stamp.changes : 0; }
+
+        size_t size() const { return _records.size(); }
+
+    private:
+        std::deque<Record> _records;
+        std::deque<uint64_t> _frameBegin; // absolute index of the first record of each frame kept
+        uint64_t _base = 0;               // absolute index of _records[0]
+        uint64_t _readMark = 0;           // records before it may have been read and can't be modified
+        uint64_t _frame = 0;
+        uint _history = 8;
+        uint _consumers = 0;
+
+        uint64_t end() const { return _base + _records.size(); }
+    };
+}
+}
+#include "MemoryLoggerOff.h"
+
+#endif // CHANGEJOURNAL_H_INCLUDED
@@ -0,0 +1,158 @@
+#ifndef INCREMENTALCULLING_H_INCLUDED
+#define INCREMENTALCULLING_H_INCLUDED
+
+#include <cfloat>
+#include <cmath>
+#include "core.h"
+#include "Frustum.h"
+#include "BasicScene.h"
+
+#include "MemoryLoggerOn.h"
+namespace tim
+{
+    using namespace core;
+namespace scene
+{
+    /* Frustum culling reusing the result of the previous frames, gives exactly what
+     * query(FrustumCulling(frustum), collector) gives.
+     * Each object is classified against a reference frustum and keeps its distance to the decision boundary (the slack).
+     * While the camera stays close to the reference, a plane distance can't move by more than
+     * |delta normal| * |center| + |delta w|, an object whose slack is bigger keeps its cached result.
+     * The others (moved, added, near a plane) are tested against the current frustum.
+     * The reference is rebuilt when the camera drifts too far or too many objects have to be tested again,
+     * call invalidate() when the view jumps (portal transition, teleport) to rebuild it on the next query.
+     * One instance per view and per queried type, the objects must have volume() and enabled(). */
+    class IncrementalCulling
+    {
+    public:
+        struct Stats
+        {
+            uint objects = 0;
+            uint tested = 0;   // tested against the current frustum this frame
+            bool rebuilt = false;
+        };
+
+        /* Translation of the planes and rotation of their normals (length of the difference) above which the reference is rebuilt */
+        void setRebuildThreshold(float distance, float normal) { _maxPlanDrift = distance; _maxNormalDrift = normal; }
+        /* Fraction of tested objects from which the next query rebuilds the reference */
+        void setRebuildRatio(float ratio) { _rebuildRatio = ratio; }
+
+        void invalidate() { _refPlans.clear(); }
+
+        const Stats& stats() const { return _stats; }
+
+        template<class Type, class Contained, class Collector>
+        void query(const BasicScene<Contained>& scene, const Frustum& frustum, Collector collector)
+        {
+            const vector<Contained*>& objects = scene.template objects<Type>();
+
+            float normalDrift = 0, planDrift = 0, maxW = 0;
+            bool rebuild = _needRebuild || _refPlans.size() != frustum.nbPlan();
+            for(size_t i=0 ; i<frustum.nbPlan() && !rebuild ; ++i)
+            {
+                const vec4& cur = frustum.plan(i).plan();
+                const vec4& ref = _refPlans[i];
+                normalDrift = std::max(normalDrift, (cur.down<1>() - ref.down<1>()).length());
+                planDrift = std::max(planDrift, fabsf(cur.w() - ref.w()));
+                maxW = std::max(maxW, std::max(fabsf(cur.w()), fabsf(ref.w())));
+            }
+            rebuild = rebuild || normalDrift > _maxNormalDrift || planDrift > _maxPlanDrift;
+
+            _stats = { uint(objects.size()), 0, rebuild };
+
+            if(rebuild)
+            {
+                _refPlans.resize(frustum.nbPlan());
+                for(size_t i=0 ; i<frustum.nbPlan() ; ++i)
+                    _refPlans[i] = frustum.plan(i).plan();
+                _entries.clear();
+            }
+            _entries.resize(objects.size());
+
+            for(size_t i=0 ; i<objects.size() ; ++i)
+            {
+                Contained& obj = *objects[i];
+                Entry& e = _entries[i];
+                const Sphere& s = obj.volume();
+
+                bool visible;
+                if(e.obj == &obj && e.volume == s.sphere())
+                {
+                    // the rounding of both plane distances is covered by a few hundred ulp
+                    const float drift = normalDrift * e.centerLength + planDrift +
+                                        1e-5f * (e.centerLength + maxW + fabsf(s.radius()));
+                    if(drift < e.slack)
+                        visible = e.visible;
+                    else
+                    {
+                        visible = frustum.collide(s) != OUTSIDE;
+                        ++_stats.tested;
+                    }
+                }
+                else
+                {
+                    // new, moved or swapped in by a remove: classify against the reference
+                    e.obj = &obj;
+                    e.volume = s.sphere();
+                    e.centerLength = s.center().length();
+                    classify(e, s);
+
+                    if(rebuild) visible = e.visible;
+                    else
+                    {
+                        visible = frustum.collide(s) != OUTSIDE;
+                        ++_stats.tested;
+                    }
+                }
+
+                if(visible && obj.enabled())
+                    collector(static_cast<Type&>(obj));
+            }
+
+            if(rebuild) _stats.tested = _stats.objects;
+            _needRebuild = !rebuild && _stats.tested > _rebuildRatio * _stats.objects;
+        }
+
+    private:
+        struct Entry
+        {
+            const void* obj = nullptr;
+            vec4 volume;
+            float centerLength;
+            float slack;   // min over the planes of |distance + radius| with the reference planes
+            bool visible;  // against the reference planes
+        };
+
+        vector<vec4> _refPlans;
+        vector<Entry> _entries;
+        bool _needRebuild = false;
+        Stats _stats;
+
+        float _maxPlanDrift = 5;
+        float _maxNormalDrift = 0.05f;
+        float _rebuildRatio = 0.25f;
+
+        /* Same test as Frustum::collide(Sphere) != OUTSIDE */
+        void classify(Entry& e, const Sphere& s) const
+        {
+            e.visible = true;
+            e.slack = FLT_MAX;
+            for(size_t i=0 ; i<_refPlans.size() ; ++i)
+            {
+                const vec4& p = _refPlans[i];
+                const float d = p.x()*s.center().x() + p.y()*s.center().y() + p.z()*s.center().z() + p.w() + s.radius();
+                if(d < 0)
+                {
+                    e.visible = false;
+                    e.slack = -d;
+                    return;
+                }
+                e.slack = std::min(e.slack, d);
+            }
+        }
+    };
+}
+}
+#include "MemoryLoggerOff.h"
+
+#endif // INCREMENTALCULLING_H_INCLUDED
@@ -18,11 +18,22 @@ namespace scene
     public:
         const Sphere& volume() const { return _volume; }
 
-        void setEnable(bool b) { _enable=b; }
+        void setEnable(bool b)
+        {
+            if(b != _enable) markChanged(BasicScene<Transformable>::Journal::ENABLED);
+            _enable=b;
+        }
         bool enabled() const { return _enable; }
 
     protected:
-        void setVolume(const Sphere& s) { _volume = s; }
+        void setVolume(const Sphere& s) { _volume = s; markChanged(BasicScene<Transformable>::Journal::MOVED); }
+
+        /* Record a change in the journal of the scene, nothing until the object is added */
+        void markChanged(uint changes)
+        {
+            if(_containerInfo.container)
+                _containerInfo.container->journal().record(this, _containerInfo.stamp, changes);
+        }
 
         Transformable() = default;
         virtual ~Transformable() = 0;
@@ -47,7 +47,8 @@ int main(int argc, char* argv[])
             view.camera.clipDist = vec2(0.1f, 100.f);
 
             std::vector<XmlSceneLoader::ObjectLoaded> objects;
-            XmlSceneLoader::loadScene("testScene.xml", scene, objects);
+            // the meshes show up as they're loaded
+            XmlSceneLoader::loadSceneAsync("testScene.xml", scene, objects);
             renderingPipeline.setScene(scene, view, 0);
 
             float timeElapsed = 0, totalTime = 0;
@@ -56,6 +57,7 @@ int main(int argc, char* argv[])
             {
                 SDLTimer timer;
                 input.getEvent();
+                openGL.execAllGLTask();
 
                 freeCamera.update(timeElapsed, view.camera);
 
@@ -63,6 +65,8 @@ int main(int argc, char* argv[])
                 renderingPipeline.pipeline()->render();
 
                 SDL_GL_SwapWindow(g_pWindow);
+                AllocCounter::nextFrame();
+                scene.scene.journal().nextFrame();
 
                 timeElapsed = timer.elapsed() * 0.001;
                 totalTime += timeElapsed;
@@ -0,0 +1,78 @@
+#include "UnitTest.h"
+#include "scene/ChangeJournal.h"
+
+#include <vector>
+
+using namespace tim::scene;
+using namespace unitTest;
+
+/* Records merged by frame, read by a cursor, dropped out of the history and when nobody consumes them */
+
+namespace
+{
+    struct Object {};
+    using Journal = ChangeJournal<Object>;
+
+    std::vector<Journal::Record> readAll(Journal& journal, Journal::Cursor& cursor, bool& ok)
+    {
+        std::vector<Journal::Record> res;
+        ok = journal.read(cursor, [&](const Journal::Record& r) { res.push_back(r); });
+        return res;
+    }
+}
+
+int unitTest::changeJournal()
+{
+    bool ok = true, readOk = false;
+    Journal journal;
+    Object a, b;
+    Journal::Stamp sa, sb;
+
+    // without consumer only the stamps are updated
+    journal.record(&a, sa, Journal::ADDED);
+    ok = check(journal.size() == 0, "recorded without consumer") && ok;
+    ok = check(journal.changes(sa) == Journal::ADDED, "stamp not updated without consumer") && ok;
+
+    Journal::Cursor cursor = journal.addConsumer();
+    Journal::Cursor late = cursor;
+
+    // merged in the same frame until read
+    journal.record(&a, sa, Journal::MOVED);
+    journal.record(&b, sb, Journal::ADDED);
+    journal.record(&a, sa, Journal::PROPERTY);
+    ok = check(journal.size() == 2, "changes of a frame not merged") && ok;
+
+    std::vector<Journal::Record> records = readAll(journal, cursor, readOk);
+    ok = check(readOk && records.size() == 2, "wrong number of records read") && ok;
+    ok = check(records.size() == 2 && records[0].object == &a && records[0].changes == (Journal::MOVED | Journal::PROPERTY), "wrong merged record") && ok;
+    ok = check(journal.changes(sa) == (Journal::ADDED | Journal::MOVED | Journal::PROPERTY), "wrong changes of the frame") && ok;
+
+    // a record read is not modified anymore
+    journal.record(&a, sa, Journal::ENABLED);
+    records = readAll(journal, cursor, readOk);
+    ok = check(readOk && records.size() == 1 && records[0].changes == Journal::ENABLED, "read record modified") && ok;
+
+    // the frames out of the history are dropped
+    journal.setHistory(2);
+    for(int i=0 ; i<3 ; ++i)
+    {
+        journal.nextFrame();
+        journal.record(&b, sb, Journal::MOVED);
+    }
+    ok = check(journal.size() == 2, "history not trimmed") && ok;
+    ok = check(journal.changes(sa) == 0 && journal.changes(sb) == Journal::MOVED, "stamps not reset by the frame") && ok;
+
+    records = readAll(journal, late, readOk);
+    ok = check(!readOk && records.empty() && late == journal.cursor(), "late cursor not detected") && ok;
+
+    cursor = journal.cursorAt(journal.frame() - 1);
+    records = readAll(journal, cursor, readOk);
+    ok = check(readOk && records.size() == 2, "cursor in the history not read") && ok;
+
+    // dropped with the last consumer
+    journal.removeConsumer();
+    journal.record(&a, sa, Journal::MOVED);
+    ok = check(journal.size() == 0 && journal.consumers() == 0, "records kept without consumer") && ok;
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,97 @@
+#include "UnitTest.h"
+#include "core/Cache.h"
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace tim::core;
+using namespace unitTest;
+
+/* Least recently used entries evicted first, capacity in entries or in cost, concurrent misses computed once */
+
+int unitTest::lruCache()
+{
+    bool ok = true;
+
+    // one shard: the eviction order is the order of use
+    {
+        LruCache<int, int> cache(3, 1);
+        cache.put(1, 10);
+        cache.put(2, 20);
+        cache.put(3, 30);
+        ok = check(cache.get(1) && cache.get(1).value() == 10, "entry not found") && ok;
+
+        cache.put(4, 40); // 2 is the least recently used
+        ok = check(!cache.get(2), "least recently used entry not evicted") && ok;
+        ok = check(cache.get(1) && cache.get(3) && cache.get(4), "recently used entry evicted") && ok;
+
+        cache.put(3, 31); // updating is a use
+        cache.put(5, 50);
+        ok = check(!cache.get(1) && cache.get(3).value() == 31 && cache.get(4) && cache.get(5), "wrong eviction after an update") && ok;
+
+        const LruCache<int, int>::Stats st = cache.stats();
+        ok = check(st.size == 3 && st.evictions == 2, "wrong size or evictions") && ok;
+
+        ok = check(cache.erase(5) && !cache.erase(5) && cache.stats().size == 2, "wrong erase") && ok;
+        cache.clear();
+        ok = check(cache.stats().size == 0 && !cache.get(3), "not cleared") && ok;
+    }
+
+    // capacity in cost, the newest entry is kept even if it doesn't fit alone
+    {
+        LruCache<int, std::string> cache(10, 1, [](const int&, const std::string& s) { return s.size(); });
+        cache.put(1, "aaaa");
+        cache.put(2, "bbbb");
+        cache.put(3, "cc");
+        ok = check(cache.stats().cost == 10 && cache.stats().size == 3, "wrong cost") && ok;
+
+        cache.put(4, "d");
+        ok = check(!cache.get(1) && cache.get(2) && cache.stats().cost == 7, "wrong eviction by cost") && ok;
+
+        cache.put(5, std::string(16, 'e'));
+        ok = check(cache.stats().size == 1 && cache.get(5), "entry larger than the capacity not kept alone") && ok;
+    }
+
+    // several shards: the total stays in the capacity
+    {
+        LruCache<int, int> cache(64, 4);
+        for(int i=0 ; i<1000 ; ++i)
+            cache.put(i, i);
+        ok = check(cache.capacity() == 64 && cache.stats().size <= 64 && cache.get(999), "capacity exceeded") && ok;
+    }
+
+    // concurrent misses on a key wait for the first computation
+    {
+        LruCache<int, int> cache(16, 2);
+        std::atomic<int> computed = 0;
+        std::vector<std::thread> threads;
+        std::vector<int> results(8, 0);
+
+        for(int i=0 ; i<8 ; ++i)
+        {
+            threads.emplace_back([&, i]()
+            {
+                results[i] = cache.getOrCompute(7, [&]()
+                {
+                    ++computed;
+                    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+                    return 49;
+                });
+            });
+        }
+        for(std::thread& t : threads)
+            t.join();
+
+        bool allSame = true;
+        for(int r : results)
+            allSame = allSame && r == 49;
+
+        const LruCache<int, int>::Stats st = cache.stats();
+        ok = check(computed == 1 && allSame, "computed more than once") && ok;
+        ok = check(st.misses == 1 && st.hits + st.waits == 7, "wrong hits and waits") && ok;
+    }
+
+    return ok ? 0 : 1;
+}
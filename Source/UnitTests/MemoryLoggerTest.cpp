@@ -0,0 +1,58 @@
+#include "UnitTest.h"
+#include "core/core.h"
+
+#include <cstring>
+
+using namespace tim::core;
+using namespace unitTest;
+
+/* The new-expressions following MemoryLoggerOn.h reach the MemoryLogger in profile builds:
+ * the call site must appear in the histogram with its live and peak bytes. */
+
+namespace
+{
+    bool findSite(size_t line, MemoryLogger::SiteStats& res)
+    {
+        for(const MemoryLogger::SiteStats& s : MemoryLogger::instance().siteStats())
+        {
+            if(s.line == line && strstr(s.file, "MemoryLoggerTest") != nullptr)
+            {
+                res = s;
+                return true;
+            }
+        }
+        return false;
+    }
+}
+
+int unitTest::memoryLogger()
+{
+#ifndef TIM_MEMORY_PROFILE
+    std::cout << "configure with ENABLE_MEMORY_PROFILE to run the MemoryLogger test" << std::endl;
+    return SKIPPED;
+#else
+    MemoryLogger::instance().setSamplingRate(1);
+
+    #include "MemoryLoggerOn.h"
+    const size_t line = __LINE__ + 1;
+    int* array = new int[64];
+    #include "MemoryLoggerOff.h"
+
+    bool ok = true;
+    MemoryLogger::SiteStats site;
+    ok = check(findSite(line, site), "the allocation site is not recorded") && ok;
+    ok = check(site.count == 1 && site.totalBytes == 64 * sizeof(int), "wrong count or bytes") && ok;
+    ok = check(site.liveCount == 1 && site.liveBytes == 64 * sizeof(int), "wrong live bytes") && ok;
+
+    delete[] array;
+
+    ok = check(findSite(line, site), "the allocation site is lost after delete") && ok;
+    ok = check(site.liveCount == 0 && site.liveBytes == 0, "the delete is not tracked") && ok;
+    ok = check(site.peakBytes == 64 * sizeof(int), "wrong peak bytes") && ok;
+
+    MemoryLogger::instance().printHistogram();
+    MemoryLogger::freeInstance();
+
+    return ok ? 0 : 1;
+#endif
+}
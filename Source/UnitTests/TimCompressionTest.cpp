@@ -0,0 +1,137 @@
+#include "UnitTest.h"
+#include "resource/MeshLoader.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+using namespace tim;
+using namespace unitTest;
+using resource::MeshLoader;
+
+/* A mesh exported compressed reads back as the uncompressed export: the same vertices (quantized for FILTERED)
+ * and the same triangles, which the index codec may rotate. By importTim and by mapTim. */
+
+namespace
+{
+    using Triangle = std::array<uint, 3>;
+
+    /* A bumpy grid, with the lod of exportTim */
+    renderer::MeshData gridMesh(uint n)
+    {
+        renderer::MeshData data;
+        data.nbVertex = (n+1)*(n+1);
+        data.nbIndex = n*n*6;
+        data.vData = new renderer::MeshData::DataType[data.nbVertex];
+        data.indexData = new uint[data.nbIndex];
+
+        for(uint y=0 ; y<=n ; ++y)
+            for(uint x=0 ; x<=n ; ++x)
+        {
+            renderer::MeshData::DataType& v = data.vData[y*(n+1)+x];
+            const float h = 0.1f * sinf(x * 0.7f) * cosf(y * 0.5f);
+            v.v = vec3(float(x), float(y), h);
+            v.n = vec3(-0.07f * cosf(x * 0.7f), 0.05f * sinf(y * 0.5f), 1).normalized();
+            v.c = vec2(float(x) / n, float(y) / n);
+            v.t = vec3(1, 0, 0.07f * cosf(x * 0.7f)).normalized();
+        }
+
+        uint* ptr = data.indexData;
+        for(uint y=0 ; y<n ; ++y)
+            for(uint x=0 ; x<n ; ++x)
+        {
+            const uint i = y*(n+1)+x;
+            *ptr++ = i; *ptr++ = i+1; *ptr++ = i+n+2;
+            *ptr++ = i; *ptr++ = i+n+2; *ptr++ = i+n+1;
+        }
+        return data;
+    }
+
+    /* Smallest index first, so a rotated triangle compares equal */
+    std::vector<Triangle> triangles(const uint* indices, uint nb)
+    {
+        std::vector<Triangle> res;
+        for(uint i=0 ; i+2<nb ; i+=3)
+        {
+            Triangle t = { indices[i], indices[i+1], indices[i+2] };
+            std::rotate(t.begin(), std::min_element(t.begin(), t.end()), t.end());
+            res.push_back(t);
+        }
+        std::sort(res.begin(), res.end());
+        return res;
+    }
+
+    bool near(const vec3& a, const vec3& b, float eps) { return fabsf(a.x()-b.x()) <= eps && fabsf(a.y()-b.y()) <= eps && fabsf(a.z()-b.z()) <= eps; }
+
+    /* eps 0: exact */
+    bool sameMesh(const renderer::MeshData& ref, const renderer::MeshData& data, float eps, const char* what)
+    {
+        bool ok = check(data.nbVertex == ref.nbVertex && data.nbIndex == ref.nbIndex && data.nbSecondaryIndex == ref.nbSecondaryIndex, what);
+        if(!ok || !data.vData || !data.indexData)
+            return check(false, what);
+
+        for(uint i=0 ; i<ref.nbVertex && ok ; ++i)
+        {
+            const renderer::MeshData::DataType& a = ref.vData[i];
+            const renderer::MeshData::DataType& b = data.vData[i];
+            if(eps == 0)
+                ok = memcmp(&a, &b, sizeof(a)) == 0;
+            else
+                ok = a.v == b.v && near(a.n, b.n, eps) && near(a.t, b.t, eps) &&
+                     fabsf(a.c.x()-b.c.x()) <= eps && fabsf(a.c.y()-b.c.y()) <= eps;
+        }
+        ok = check(ok, what) && ok;
+
+        ok = check(triangles(ref.indexData, ref.nbIndex) == triangles(data.indexData, data.nbIndex), what) && ok;
+        if(ref.nbSecondaryIndex > 0)
+            ok = check(data.secondaryIndexData && triangles(ref.secondaryIndexData, ref.nbSecondaryIndex) ==
+                                                  triangles(data.secondaryIndexData, data.nbSecondaryIndex), what) && ok;
+
+        // the hash of the header is the one of the data loaded
+        ok = check(data.contentHash == MeshLoader::contentHash(data), what) && ok;
+        return ok;
+    }
+}
+
+int unitTest::timCompression()
+{
+    bool ok = true;
+
+    renderer::MeshData mesh = gridMesh(40);
+    MeshLoader::exportTim(mesh, "timCompression_none.tim", 0.33f, MeshLoader::TimCompression::NONE);
+    MeshLoader::exportTim(mesh, "timCompression_lossless.tim", 0.33f, MeshLoader::TimCompression::LOSSLESS);
+    MeshLoader::exportTim(mesh, "timCompression_filtered.tim", 0.33f, MeshLoader::TimCompression::FILTERED);
+    mesh.clear();
+
+    renderer::MeshData ref = MeshLoader::importTim("timCompression_none.tim");
+    ok = check(ref.nbVertex > 0 && ref.nbSecondaryIndex > 0, "uncompressed export not read") && ok;
+
+    if(ok)
+    {
+        renderer::MeshData data = MeshLoader::importTim("timCompression_lossless.tim");
+        ok = sameMesh(ref, data, 0, "lossless imported") && ok;
+        data.clear();
+
+        data = MeshLoader::mapTim("timCompression_lossless.tim");
+        ok = sameMesh(ref, data, 0, "lossless mapped") && ok;
+        data.clear();
+
+        // normals and tangents on 12 bits (octahedral), uvs on 16 bits of mantissa
+        data = MeshLoader::importTim("timCompression_filtered.tim");
+        ok = sameMesh(ref, data, 1e-2f, "filtered imported") && ok;
+        data.clear();
+
+        data = MeshLoader::mapTim("timCompression_filtered.tim");
+        ok = sameMesh(ref, data, 1e-2f, "filtered mapped") && ok;
+        data.clear();
+    }
+    ref.clear();
+
+    std::remove("timCompression_none.tim");
+    std::remove("timCompression_lossless.tim");
+    std::remove("timCompression_filtered.tim");
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,25 @@
+#ifndef UNITTEST_H_INCLUDED
+#define UNITTEST_H_INCLUDED
+
+#include <iostream>
+
+/* The tests of the executable, run by name: TIMEngine2_UnitTests <test>. They return 0 when passed. */
+
+namespace unitTest
+{
+    const int SKIPPED = 77; // SKIP_RETURN_CODE of the ctests
+
+    inline bool check(bool cond, const char* what)
+    {
+        if(!cond)
+            std::cerr << "failed: " << what << std::endl;
+        return cond;
+    }
+
+    int memoryLogger();
+    int changeJournal();
+    int lruCache();
+    int timCompression();
+}
+
+#endif // UNITTEST_H_INCLUDED
@@ -0,0 +1,41 @@
+#include "UnitTest.h"
+
+#include <cstring>
+
+namespace
+{
+    struct Test
+    {
+        const char* name;
+        int (*run)();
+    };
+
+    const Test tests[] =
+    {
+        { "MemoryLogger", unitTest::memoryLogger },
+        { "ChangeJournal", unitTest::changeJournal },
+        { "LruCache", unitTest::lruCache },
+        { "TimCompression", unitTest::timCompression },
+    };
+}
+
+int main(int argc, char* argv[])
+{
+    for(const Test& t : tests)
+    {
+        if(argc < 2 || strcmp(argv[1], t.name) == 0)
+        {
+            const int res = t.run();
+            std::cout << t.name << " test " << (res == 0 ? "passed" : res == unitTest::SKIPPED ? "skipped" : "failed") << std::endl;
+            if(argc >= 2 || (res != 0 && res != unitTest::SKIPPED))
+                return res;
+        }
+    }
+
+    if(argc >= 2)
+    {
+        std::cerr << "Unknown test " << argv[1] << std::endl;
+        return 1;
+    }
+    return 0;
+}